@@ -1499,6 +1499,10 @@ pc_close(UNUSED(thread_t *ptr))
 
     plat_mouse_capture(0);
 
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    codegen_log_stats();
+#endif
+
     /* Close all the memory mappings. */
     mem_close();
 
@@ -404,6 +404,8 @@ codegen_generate_call(uint8_t opcode, OpFn op, uint32_t fetchdat, uint32_t new_p
 
     codegen_timing_start();
 
+    codegen_trace_follow = 0;
+
     while (!over) {
         switch (opcode) {
             case 0x0f:
@@ -666,6 +668,10 @@ generate_call:
     if (recomp_op_table && recomp_op_table[(opcode | op_32) & recomp_opcode_mask]) {
         uint32_t new_pc = recomp_op_table[(opcode | op_32) & recomp_opcode_mask](block, ir, opcode, fetchdat, op_32, op_pc);
         if (new_pc) {
+            /*Only carry on past a followed branch if the uOPs go on from its
+              destination, some conditions known at compile time exit instead*/
+            if (codegen_trace_follow && new_pc != codegen_trace_dest)
+                codegen_trace_follow = 0;
             if (new_pc != -1)
                 uop_MOV_IMM(ir, IREG_pc, new_pc);
 
@@ -676,10 +682,19 @@ generate_call:
             if (block->ins >= MAX_INSTRUCTION_COUNT)
                 CPU_BLOCK_END();
 
+            /*The block was ended while this instruction was compiled (too many
+              instructions, register versions or references), so it has to end
+              here even if the branch was followed. The branch itself only ends
+              the block when the interpreter runs it, after this*/
+            if (cpu_block_end)
+                codegen_trace_follow = 0;
+
             return;
         }
     }
 
+    codegen_trace_follow = 0;
+
     // codegen_skip:
     if ((op_table == x86_dynarec_opcodes_REPNE || op_table == x86_dynarec_opcodes_REPE) && !op_table[opcode | op_32]) {
         op_table        = x86_dynarec_opcodes;
@@ -57,6 +57,10 @@ typedef struct codeblock_t {
     /*First mem_block_t used by this block. Any subsequent mem_block_ts
       will be in the list starting at head_mem_block->next.*/
     struct mem_block_t *head_mem_block;
+
+    /*Number of times this block has been run, saturating. Halved each time
+      the eviction clock passes it, see codegen_evict_block().*/
+    uint8_t uses;
 } codeblock_t;
 
 extern codeblock_t *codeblock;
@@ -81,6 +85,22 @@ extern uint8_t *block_write_data;
 #define CODEBLOCK_IN_DIRTY_LIST 0x40
 /*Code block is not inlining immediate parameters, parameters must be fetched from memory*/
 #define CODEBLOCK_NO_IMMEDIATES 0x80
+/*Code block is compiled as a trace - taken branches are followed instead of
+  ending the block, see codegen_can_follow()*/
+#define CODEBLOCK_TRACE 0x100
+/*Code block ended at a taken branch that it could have followed if it was a trace*/
+#define CODEBLOCK_CAN_TRACE 0x200
+
+/*Compile hot blocks again as traces. Off until it has been benchmarked against
+  plain blocks on a guest (eg Dhrystone or a Quake timedemo) - recompiling
+  throws away code that is already hot, and CODEBLOCK_TRACE_USES is a guess*/
+//#define CODEGEN_TRACES
+
+/*Number of runs since the eviction clock last passed it before a block that
+  can be a trace is compiled again as one. The counter saturates at 0xff and
+  is halved by each pass of the clock, so this is half way - only blocks that
+  keep being run between passes get there. Not tuned against any benchmark*/
+#define CODEBLOCK_TRACE_USES 0x80
 
 #define BLOCK_PC_INVALID        0xffffffff
 
@@ -296,6 +316,7 @@ extern void codegen_block_remove(void);
 extern void codegen_block_start_recompile(codeblock_t *block);
 extern void codegen_block_end_recompile(codeblock_t *block);
 extern void codegen_block_end(void);
+extern void codegen_block_start_trace(codeblock_t *block);
 extern void codegen_delete_block(codeblock_t *block);
 extern void codegen_generate_call(uint8_t opcode, OpFn op, uint32_t fetchdat, uint32_t new_pc, uint32_t old_pc);
 extern void codegen_generate_seg_restore(void);
@@ -308,9 +329,26 @@ extern void codegen_check_seg_read(codeblock_t *block, struct ir_data_t *ir, x86
 extern void codegen_check_seg_write(codeblock_t *block, struct ir_data_t *ir, x86seg *seg);
 
 extern int codegen_purge_purgable_list(void);
-/*Delete a random code block to free memory. This is obviously quite expensive, and
-  will only be called when the allocator is out of memory*/
-extern void codegen_delete_random_block(int required_mem_block);
+/*Delete a code block to free memory. A clock hand sweeps the code blocks, giving
+  blocks that have been run since it last passed another chance, so hot code
+  survives. This is still quite expensive, and will only be called when the
+  allocator or the free list is out of blocks*/
+extern void codegen_evict_block(int required_mem_block);
+
+/*Since the last reset : code blocks compiled, evicted to free memory,
+  compiled again after being evicted, and compiled again as traces. Logged by
+  codegen_log_stats() when ENABLE_386_DYNAREC_LOG is set*/
+extern int codegen_block_compiles;
+extern int codegen_block_evictions;
+extern int codegen_block_recompiles;
+extern int codegen_block_traces;
+
+/*Set when the taken branch that has just been compiled was followed, so the
+  recompile loop carries on at its destination instead of ending the block*/
+extern int      codegen_trace_follow;
+extern uint32_t codegen_trace_dest;
+/*Branches followed so far in the block being compiled*/
+extern int      codegen_trace_branches;
 
 extern int      cpu_block_end;
 extern uint32_t codegen_endpc;
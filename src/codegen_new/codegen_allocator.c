@@ -53,14 +53,10 @@ codegen_allocator_allocate(mem_block_t *parent, int code_block)
     mem_block_t *block;
     uint32_t     block_nr;
 
-    while (!mem_block_free_list) {
-        /*Pick a random memory block and free the owning code block*/
-        block_nr = rand() & MEM_BLOCK_MASK;
-        block    = &mem_blocks[block_nr];
-
-        if (block->code_block && block->code_block != code_block)
-            codegen_delete_block(&codeblock[block->code_block]);
-    }
+    /*Free the least recently used code block that has memory. This never picks
+      the block being compiled, which is the only one that can ask for more*/
+    while (!mem_block_free_list)
+        codegen_evict_block(1);
 
     /*Remove from free list*/
     block_nr            = mem_block_free_list;
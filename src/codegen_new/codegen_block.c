@@ -49,6 +49,22 @@ int        codegen_block_cycles;
 static int codegen_block_ins;
 static int codegen_block_full_ins;
 
+int codegen_block_compiles   = 0;
+int codegen_block_evictions  = 0;
+int codegen_block_recompiles = 0;
+int codegen_block_traces     = 0;
+
+int      codegen_trace_follow;
+uint32_t codegen_trace_dest;
+int      codegen_trace_branches;
+
+/*Next code block that codegen_evict_block() will look at*/
+static int block_clock_hand = 1;
+
+/*Physical address of the last block evicted from each hash slot, so that
+  compiling the same code again can be counted as a recompile*/
+static uint32_t block_evicted_phys[HASH_SIZE];
+
 static uint32_t last_op32;
 static x86seg  *last_ea_seg;
 static int      last_ssegs;
@@ -204,7 +220,7 @@ block_free_list_get(void)
         }
         /*Free list is empty - free up a block*/
         if (!codegen_purge_purgable_list())
-            codegen_delete_random_block(0);
+            codegen_evict_block(0);
     }
 
     block           = &codeblock[block_free_list];
@@ -228,13 +244,34 @@ codegen_init(void)
 #ifdef DEBUG_EXTRA
     memset(instr_counts, 0, sizeof(instr_counts));
 #endif
+    memset(block_evicted_phys, 0xff, sizeof(block_evicted_phys));
 }
 
+#ifdef ENABLE_386_DYNAREC_LOG
+extern int x386_dynarec_do_log;
+
+void
+codegen_log_stats(void)
+{
+    if (!x386_dynarec_do_log || !codegen_block_compiles)
+        return;
+
+    pclog("codegen: %i blocks compiled, %i evicted, %i compiled again after being evicted, %i compiled again as traces\n",
+          codegen_block_compiles, codegen_block_evictions, codegen_block_recompiles, codegen_block_traces);
+}
+#endif
+
 void
 codegen_reset(void)
 {
     int c;
 
+#ifdef ENABLE_386_DYNAREC_LOG
+    codegen_log_stats();
+#endif
+    codegen_block_compiles = codegen_block_evictions = codegen_block_recompiles = codegen_block_traces = 0;
+    memset(block_evicted_phys, 0xff, sizeof(block_evicted_phys));
+
     for (c = 1; c < BLOCK_SIZE; c++) {
         codeblock_t *block = &codeblock[c];
 
@@ -432,20 +469,30 @@ codegen_delete_block(codeblock_t *block)
 }
 
 void
-codegen_delete_random_block(int required_mem_block)
+codegen_evict_block(int required_mem_block)
 {
-    int block_nr = rand() & BLOCK_MASK;
-
     while (1) {
+        int block_nr = block_clock_hand;
+
+        block_clock_hand = (block_clock_hand + 1) & BLOCK_MASK;
+
         if (block_nr && block_nr != block_current) {
             codeblock_t *block = &codeblock[block_nr];
 
             if (block->pc != BLOCK_PC_INVALID && (!required_mem_block || block->head_mem_block)) {
+                /*Second chance - a block that has been used is aged instead, and
+                  the more it was used the more times round it takes to go*/
+                if (block->uses) {
+                    block->uses >>= 1;
+                    continue;
+                }
+
+                block_evicted_phys[HASH(block->phys)] = block->phys;
                 delete_block(block);
+                codegen_block_evictions++;
                 return;
             }
         }
-        block_nr = (block_nr + 1) & BLOCK_MASK;
     }
 }
 
@@ -528,6 +575,7 @@ codegen_block_init(uint32_t phys_addr)
     block->next_2 = block->prev_2 = BLOCK_INVALID;
     block->page_mask = block->page_mask2 = 0;
     block->flags                         = CODEBLOCK_STATIC_TOP;
+    block->uses                          = 1;
     block->status                        = cpu_cur_status;
 
     recomp_page = block->phys & ~0xfff;
@@ -562,6 +610,15 @@ codegen_block_start_recompile(codeblock_t *block)
     block->data           = codeblock_allocator_get_ptr(block->head_mem_block);
 
     block->status = cpu_cur_status;
+    block->uses   = 1;
+    codegen_block_compiles++;
+    if (block_evicted_phys[HASH(block->phys)] == block->phys) {
+        block_evicted_phys[HASH(block->phys)] = BLOCK_PC_INVALID;
+        codegen_block_recompiles++;
+    }
+
+    codegen_trace_follow   = 0;
+    codegen_trace_branches = 0;
 
     block->page_mask = block->page_mask2 = 0;
     block->ins                           = 0;
@@ -756,6 +813,25 @@ codegen_block_end(void)
     add_to_block_list(block);
 }
 
+/*Throw away the code of a hot block that ended at a branch it could have
+  followed, so that it is compiled again as a trace the next time it is run*/
+void
+codegen_block_start_trace(codeblock_t *block)
+{
+    if (block->head_mem_block)
+        codegen_allocator_free(block->head_mem_block);
+    block->head_mem_block = NULL;
+
+    block->flags &= ~(CODEBLOCK_WAS_RECOMPILED | CODEBLOCK_CAN_TRACE);
+    block->flags |= CODEBLOCK_TRACE;
+    /*Dropped at the end of compiling a block with no FPU code, but the trace
+      may reach some*/
+    if (!(block->flags & CODEBLOCK_HAS_FPU))
+        block->flags |= CODEBLOCK_STATIC_TOP;
+
+    codegen_block_traces++;
+}
+
 void
 codegen_block_end_recompile(codeblock_t *block)
 {
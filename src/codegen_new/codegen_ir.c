@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string.h>
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/mem.h>
@@ -59,6 +60,215 @@ duplicate_uop(ir_data_t *ir, uop_t *uop, int offset)
     }
 }
 
+/*Constant folding. uOPs whose sources all come from UOP_MOV_IMM are replaced
+  with a UOP_MOV_IMM of the result, which often leaves the original UOP_MOV_IMM
+  with no readers so that it can be removed as well (eg MOV EAX, imm followed by
+  ADD EAX, imm and the flags_op1/flags_res copies of it).
+
+  Only full size (32-bit) registers are folded, as partial writes merge with the
+  previous version. Register versions aren't stable across barriers (called
+  functions can change any register in cpu_state), or across jumps, so nothing
+  is carried past those.
+
+  There is no copy propagation or load/store elimination. Renaming a read to
+  an older version would keep that version live alongside the newer one, but
+  the register allocator only holds the latest version of each register in a
+  host register, so the older one would have to be spilled and reloaded.
+  Loads and stores of cpu_state are already only emitted by the allocator when
+  a register is first read or evicted.
+
+  There is no separate backward liveness pass for flags either.
+  codegen_reg_write() already queues the previous version of flags_op,
+  flags_res, flags_op1 and flags_op2 for removal when it is overwritten with
+  no readers, which covers an ALU op whose flags the next one replaces. The
+  versions it keeps are the ones marked REG_FLAGS_REQUIRED at barriers and
+  order barriers (calls, memory accesses, anything that can fault), where the
+  flags have to be in cpu_state in case an exception or helper reads them, so
+  a backward pass would have nothing more it could remove.*/
+static uint8_t  fold_valid[IREG_COUNT];
+static uint8_t  fold_version[IREG_COUNT];
+static uint32_t fold_value[IREG_COUNT];
+static uint8_t  fold_jump_dest[UOP_NR_MAX + 1];
+
+static int
+fold_get(ir_reg_t reg, uint32_t *value)
+{
+    int ireg = IREG_GET_REG(reg.reg);
+
+    if (IREG_GET_SIZE(reg.reg) != IREG_SIZE_L || !reg_is_native_size(reg))
+        return 0;
+    if (!fold_valid[ireg] || fold_version[ireg] != reg.version)
+        return 0;
+
+    *value = fold_value[ireg];
+    return 1;
+}
+
+/*Drop a read of a register version, and if that was the last one queue the
+  version for removal the same way codegen_reg_write() would*/
+static void
+fold_release(ir_data_t *ir, ir_reg_t reg)
+{
+    int            ireg = IREG_GET_REG(reg.reg);
+    reg_version_t *regv = &reg_version[ireg][reg.version];
+
+    regv->refcount--;
+    if (regv->refcount || (regv->flags & (REG_FLAGS_REQUIRED | REG_FLAGS_DEAD)))
+        return;
+    if (ireg <= IREG_EBX || reg.version >= reg_last_version[ireg])
+        return;
+
+    /*The next version must not depend on this one*/
+    if (!reg_is_native_size(ir->uops[reg_version[ireg][reg.version + 1].parent_uop].dest_reg_a))
+        return;
+
+    add_to_dead_list(regv, ireg, reg.version);
+}
+
+static int
+fold_uop(uop_t *uop, uint32_t *result)
+{
+    uint32_t a;
+    uint32_t b;
+
+    switch (uop->type & ~UOP_TYPE_JUMP_DEST) {
+        case UOP_MOV:
+            return fold_get(uop->src_reg_a, result);
+
+        case UOP_ADD_IMM:
+        case UOP_SUB_IMM:
+        case UOP_AND_IMM:
+        case UOP_OR_IMM:
+        case UOP_XOR_IMM:
+        case UOP_SHL_IMM:
+        case UOP_SHR_IMM:
+        case UOP_SAR_IMM:
+            if (!fold_get(uop->src_reg_a, &a))
+                return 0;
+            b = uop->imm_data;
+            break;
+
+        case UOP_ADD:
+        case UOP_SUB:
+        case UOP_AND:
+        case UOP_OR:
+        case UOP_XOR:
+        case UOP_ANDN:
+        case UOP_ADD_LSHIFT:
+            if (!fold_get(uop->src_reg_a, &a) || !fold_get(uop->src_reg_b, &b))
+                return 0;
+            break;
+
+        default:
+            return 0;
+    }
+
+    switch (uop->type & ~UOP_TYPE_JUMP_DEST) {
+        case UOP_ADD:
+        case UOP_ADD_IMM:
+            *result = a + b;
+            return 1;
+        case UOP_SUB:
+        case UOP_SUB_IMM:
+            *result = a - b;
+            return 1;
+        case UOP_AND:
+        case UOP_AND_IMM:
+            *result = a & b;
+            return 1;
+        case UOP_OR:
+        case UOP_OR_IMM:
+            *result = a | b;
+            return 1;
+        case UOP_XOR:
+        case UOP_XOR_IMM:
+            *result = a ^ b;
+            return 1;
+        case UOP_ANDN:
+            *result = ~a & b;
+            return 1;
+        case UOP_ADD_LSHIFT:
+            if (uop->imm_data > 3)
+                return 0;
+            *result = a + (b << uop->imm_data);
+            return 1;
+        case UOP_SHL_IMM:
+            if (b > 31)
+                return 0;
+            *result = a << b;
+            return 1;
+        case UOP_SHR_IMM:
+            if (b > 31)
+                return 0;
+            *result = a >> b;
+            return 1;
+        case UOP_SAR_IMM:
+            if (b > 31)
+                return 0;
+            *result = (uint32_t) ((int32_t) a >> b);
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static void
+codegen_ir_fold_constants(ir_data_t *ir)
+{
+    int c;
+
+    memset(fold_valid, 0, sizeof(fold_valid));
+    memset(fold_jump_dest, 0, ir->wr_pos + 1);
+
+    for (c = 0; c < ir->wr_pos; c++) {
+        if ((ir->uops[c].type & UOP_TYPE_JUMP) && ir->uops[c].jump_dest_uop >= 0 && ir->uops[c].jump_dest_uop <= ir->wr_pos)
+            fold_jump_dest[ir->uops[c].jump_dest_uop] = 1;
+    }
+
+    for (c = 0; c < ir->wr_pos; c++) {
+        uop_t   *uop = &ir->uops[c];
+        uint32_t result;
+        int      dest;
+
+        if (fold_jump_dest[c] || (uop->type & (UOP_TYPE_BARRIER | UOP_TYPE_JUMP)))
+            memset(fold_valid, 0, sizeof(fold_valid));
+
+        if ((uop->type & UOP_MASK) == UOP_INVALID || ir_reg_is_invalid(uop->dest_reg_a))
+            continue;
+
+        dest = IREG_GET_REG(uop->dest_reg_a.reg);
+
+        if (IREG_GET_SIZE(uop->dest_reg_a.reg) != IREG_SIZE_L || !reg_is_native_size(uop->dest_reg_a)
+            || (uop->type & (UOP_TYPE_BARRIER | UOP_TYPE_ORDER_BARRIER))) {
+            fold_valid[dest] = 0;
+            continue;
+        }
+
+        if ((uop->type & ~UOP_TYPE_JUMP_DEST) == UOP_MOV_IMM)
+            result = uop->imm_data;
+        else if (fold_uop(uop, &result)) {
+            if (!ir_reg_is_invalid(uop->src_reg_a))
+                fold_release(ir, uop->src_reg_a);
+            if (!ir_reg_is_invalid(uop->src_reg_b))
+                fold_release(ir, uop->src_reg_b);
+
+            uop->type      = UOP_MOV_IMM | (uop->type & UOP_TYPE_JUMP_DEST);
+            uop->imm_data  = result;
+            uop->src_reg_a = invalid_ir_reg;
+            uop->src_reg_b = invalid_ir_reg;
+            uop->src_reg_c = invalid_ir_reg;
+        } else {
+            fold_valid[dest] = 0;
+            continue;
+        }
+
+        fold_valid[dest]   = 1;
+        fold_version[dest] = uop->dest_reg_a.version;
+        fold_value[dest]   = result;
+    }
+}
+
 void
 codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
 {
@@ -81,6 +291,7 @@ codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
         }
     }
 
+    codegen_ir_fold_constants(ir);
     codegen_reg_mark_as_required();
     codegen_reg_process_dead_list(ir);
     block_write_data = codeblock_allocator_get_ptr(block->head_mem_block);
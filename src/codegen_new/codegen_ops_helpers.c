@@ -75,3 +75,35 @@ codegen_can_unroll_full(codeblock_t *block, ir_data_t *ir, UNUSED(uint32_t next_
 
     return 1;
 }
+
+#define TRACE_MAX_BRANCHES 8
+/*Don't start on another part of the trace if the block is already most of the
+  way to the register version limit, as it would end again almost straight away*/
+#define TRACE_MAX_VERSIONS (REG_VERSION_MAX / 2)
+int
+codegen_can_follow(codeblock_t *block, uint32_t next_pc, uint32_t dest_addr)
+{
+    if (block->flags & CODEBLOCK_BYTE_MASK)
+        return 0;
+
+    /*The second page of a block is found from where it ends, so only follow
+      branches while the block is still in its first page. Branches back past
+      the start of the block would run into the block size limit straight away*/
+    if (block->page_mask2 || (((cs + next_pc - 1) ^ block->pc) & ~0xfff))
+        return 0;
+    if ((cs + dest_addr) < block->pc || (((cs + dest_addr) ^ block->pc) & ~0xfff))
+        return 0;
+
+    if (codegen_trace_branches >= TRACE_MAX_BRANCHES || max_version_refcount >= TRACE_MAX_VERSIONS)
+        return 0;
+
+    if (!(block->flags & CODEBLOCK_TRACE)) {
+        block->flags |= CODEBLOCK_CAN_TRACE;
+        return 0;
+    }
+
+    codegen_trace_branches++;
+    codegen_trace_follow = 1;
+    codegen_trace_dest   = dest_addr;
+    return 1;
+}
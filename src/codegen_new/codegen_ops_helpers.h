@@ -125,3 +125,23 @@ codegen_can_unroll(codeblock_t *block, ir_data_t *ir, uint32_t next_pc, uint32_t
 
     return codegen_can_unroll_full(block, ir, next_pc, dest_addr);
 }
+
+/*Trace blocks don't end at taken branches. The branch is compiled with a side
+  exit for the not taken path, and the block carries on at the destination with
+  the guest registers still in host registers. Blocks that aren't traces only
+  note that they could have followed the branch, so that they are compiled
+  again as traces once they are hot*/
+int codegen_can_follow(codeblock_t *block, uint32_t next_pc, uint32_t dest_addr);
+
+/*Can the block carry on at the destination of a taken branch - either a loop
+  that can be unrolled, or any branch in a trace. Loops aren't unrolled once a
+  branch has been followed, as the loop body found for the destination may not
+  be the path the trace took to get here*/
+static inline int
+codegen_can_continue(codeblock_t *block, ir_data_t *ir, uint32_t next_pc, uint32_t dest_addr)
+{
+    if (!codegen_trace_branches && codegen_can_unroll(block, ir, next_pc, dest_addr))
+        return 1;
+
+    return codegen_can_follow(block, next_pc, dest_addr);
+}
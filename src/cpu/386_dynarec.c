@@ -498,6 +498,13 @@ exec386_dynarec_dyn(void)
     }
 
 #    ifdef USE_NEW_DYNAREC
+#        ifdef CODEGEN_TRACES
+    /* Hot, and ended at a branch that it could have carried on past, so
+       compile it again as a trace */
+    if (valid_block && !cpu_state.abrt && block->uses >= CODEBLOCK_TRACE_USES && (block->flags & (CODEBLOCK_WAS_RECOMPILED | CODEBLOCK_CAN_TRACE | CODEBLOCK_IN_DIRTY_LIST)) == (CODEBLOCK_WAS_RECOMPILED | CODEBLOCK_CAN_TRACE))
+        codegen_block_start_trace(block);
+#        endif
+
     if (valid_block && (block->flags & CODEBLOCK_WAS_RECOMPILED))
 #    else
     if (valid_block && block->was_recompiled)
@@ -507,6 +514,9 @@ exec386_dynarec_dyn(void)
 
 #    ifndef USE_NEW_DYNAREC
         codeblock_hash[hash] = block;
+#    else
+        if (block->uses < 0xff)
+            block->uses++;
 #    endif
         inrecomp = 1;
         code();
@@ -565,6 +575,15 @@ exec386_dynarec_dyn(void)
 
                 x86_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
 
+#    ifdef USE_NEW_DYNAREC
+                /* The branch was compiled with a side exit, so the trace goes on
+                   from where it went */
+                if (codegen_trace_follow) {
+                    codegen_trace_follow = 0;
+                    cpu_block_end        = 0;
+                }
+#    endif
+
                 if (x86_was_reset)
                     break;
             }
@@ -51,6 +51,11 @@
 
 extern void codegen_init(void);
 extern void codegen_flush(void);
+#if defined(USE_NEW_DYNAREC) && defined(ENABLE_386_DYNAREC_LOG)
+extern void codegen_log_stats(void);
+#else
+#    define codegen_log_stats()
+#endif
 
 /*Current physical page of block being recompiled. -1 if no recompilation taking place */
 extern uint32_t recomp_page;
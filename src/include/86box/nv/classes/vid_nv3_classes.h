@@ -136,6 +136,55 @@ typedef enum nv3_pgraph_class_e
 #define NV3_M2MF_NOTIFY                                 0x0328
 
 // blit
+// class 0x17: Direct3D 5.0 triangle with zeta buffer
+#define NV3_D3D5_TEXTURE_OFFSET                         0x0304
+#define NV3_D3D5_TEXTURE_FORMAT                         0x0308
+#define NV3_D3D5_TEXTURE_FILTER                         0x030C
+#define NV3_D3D5_FOG_COLOR                              0x0310
+#define NV3_D3D5_CONTROL_OUT                            0x0314
+#define NV3_D3D5_ALPHA_CONTROL                          0x0318
+#define NV3_D3D5_VERTEX_START                           0x1000  // 128 D3DTLVERTEX-style vertices, 0x20 bytes each
+#define NV3_D3D5_VERTEX_END                             0x1FFF
+#define NV3_D3D5_VERTEX_SIZE                            0x20
+#define NV3_D3D5_VERTEX_SPECULAR                        0x00    // Specular, fog factor in the top byte
+#define NV3_D3D5_VERTEX_COLOR                           0x04    // A8R8G8B8 diffuse
+#define NV3_D3D5_VERTEX_X                               0x08
+#define NV3_D3D5_VERTEX_Y                               0x0C
+#define NV3_D3D5_VERTEX_Z                               0x10
+#define NV3_D3D5_VERTEX_M                               0x14    // 1/W
+#define NV3_D3D5_VERTEX_U                               0x18
+#define NV3_D3D5_VERTEX_V                               0x1C    // Last word of a vertex
+
+// Texture format
+#define NV3_D3D5_TEXTURE_FORMAT_COLOR_KEY_ENABLED       16
+#define NV3_D3D5_TEXTURE_FORMAT_COLOR                   20
+#define NV3_D3D5_TEXTURE_FORMAT_SIZE_MIN                24
+#define NV3_D3D5_TEXTURE_FORMAT_SIZE_MAX                28
+
+// Control out
+#define NV3_D3D5_CONTROL_OUT_INTERPOLATOR               0
+#define NV3_D3D5_CONTROL_OUT_WRAP_U                     4
+#define NV3_D3D5_CONTROL_OUT_WRAP_V                     6
+#define NV3_D3D5_CONTROL_OUT_SOURCE_COLOR               10
+#define NV3_D3D5_CONTROL_OUT_CULLING                    12
+#define NV3_D3D5_CONTROL_OUT_ZBUFFER_TYPE               15
+#define NV3_D3D5_CONTROL_OUT_ZETA_COMPARE               16
+#define NV3_D3D5_CONTROL_OUT_ZETA_WRITE                 20
+#define NV3_D3D5_CONTROL_OUT_COLOR_WRITE                24
+#define NV3_D3D5_CONTROL_OUT_BLEND_ROP                  28
+#define NV3_D3D5_CONTROL_OUT_BLEND_INPUT0               29
+#define NV3_D3D5_CONTROL_OUT_BLEND_INPUT1               30
+
+// Alpha control
+#define NV3_D3D5_ALPHA_CONTROL_COMPARE                  8
+
+// class 0x18: Point with zeta buffer
+#define NV3_POINT_ZETA_CONTROL_OUT                      0x0304
+#define NV3_POINT_ZETA_ALPHA_CONTROL                    0x0308
+#define NV3_POINT_ZETA_POINT                            0x07FC
+#define NV3_POINT_ZETA_COLOR_ZETA_START                 0x0800  // 8 pairs of colour and zeta, one pixel each
+#define NV3_POINT_ZETA_COLOR_ZETA_END                   0x083F
+
 #define NV3_BLIT_POSITION_IN                            0x0300
 #define NV3_BLIT_POSITION_OUT                           0x0304
 #define NV3_BLIT_SIZE                                   0x0308
@@ -148,6 +197,39 @@ typedef enum nv3_pgraph_class_e
 #define NV3_IMAGE_COLOR_MAX                             32
 #define NV3_IMAGE_COLOR_END                             0x0480
 
+// scaled_image_from_memory
+#define NV3_SCALED_IMAGE_CLIP_POINT                     0x0304
+#define NV3_SCALED_IMAGE_CLIP_SIZE                      0x0308
+#define NV3_SCALED_IMAGE_OUT_POINT                      0x030C  // destination rectangle
+#define NV3_SCALED_IMAGE_OUT_SIZE                       0x0310
+#define NV3_SCALED_IMAGE_DELTA_DU_DX                    0x0314  // 12.20 source pixels per destination pixel
+#define NV3_SCALED_IMAGE_DELTA_DV_DY                    0x0318
+#define NV3_SCALED_IMAGE_SIZE                           0x0400  // source size
+#define NV3_SCALED_IMAGE_FORMAT                         0x0404  // pitch in bits 0-15, filter in bits 24-31
+#define NV3_SCALED_IMAGE_OFFSET                         0x0408  // source offset in the DMA object
+#define NV3_SCALED_IMAGE_POINT                          0x040C  // 12.4 source position, starts the transfer
+
+#define NV3_SCALED_IMAGE_FORMAT_FILTER                  24      // 0 = nearest, otherwise bilinear
+
+// stretched_image_from_cpu
+#define NV3_STRETCHED_IMAGE_SIZE_IN                     0x0304
+#define NV3_STRETCHED_IMAGE_DELTA_DX_DU                 0x0308  // 12.20 destination pixels per source pixel
+#define NV3_STRETCHED_IMAGE_DELTA_DY_DV                 0x030C
+#define NV3_STRETCHED_IMAGE_CLIP_POINT                  0x0310
+#define NV3_STRETCHED_IMAGE_CLIP_SIZE                   0x0314
+#define NV3_STRETCHED_IMAGE_POINT_12D4                  0x0318  // 12.4 destination position, pixels start arriving after this
+#define NV3_STRETCHED_IMAGE_COLOR_START                 0x0400
+#define NV3_STRETCHED_IMAGE_COLOR_END                   0x1FFC
+
+// bitmap_from_cpu
+#define NV3_BITMAP_COLOR_0                              0x0304  // colour for clear bits
+#define NV3_BITMAP_COLOR_1                              0x0308  // colour for set bits
+#define NV3_BITMAP_START_POSITION                       0x030C
+#define NV3_BITMAP_SIZE                                 0x0310
+#define NV3_BITMAP_SIZE_IN                              0x0314
+#define NV3_BITMAP_MONOCHROME_START                     0x0400  // 32 pixels per method
+#define NV3_BITMAP_MONOCHROME_END                       0x047F
+
 #define NV3_IMAGE_IN_MEMORY_COLOR_FORMAT                0x0300
 #define NV3_IMAGE_IN_MEMORY_IN_MEMORY_DMA_CTX_TYPE      0x0304
 #define NV3_IMAGE_IN_MEMORY_PITCH                       0x0308
@@ -656,8 +738,7 @@ typedef struct nv3_object_class_00D
     uint32_t pitch_out;
     uint32_t line_length_in;                        // Stride?
     uint32_t line_count;
-    uint8_t format;                                 // input increment 1 2 or 4, output increment 1 2 or 4 (represented by << 8)
-    uint8_t reserved3[2];
+    uint32_t format;                                // input increment 1 2 or 4, output increment 1 2 or 4 (represented by << 8)
     uint32_t buffer_notify;                         // Notify the Buffedr
     uint8_t reserved4[0x1CD3];  
 } nv3_memory_to_memory_format_t;
@@ -753,8 +834,8 @@ typedef struct nv3_object_class_012
     uint8_t reserved[0x100];
     uint32_t set_notify;
     uint8_t reserved2[0x200];
-    nv3_color_expanded_t color_0;
-    nv3_color_expanded_t color_1;
+    uint32_t color_0;                               // Colour for clear bits, in the object's colour format
+    uint32_t color_1;                               // Colour for set bits, in the object's colour format
     nv3_position_16_t point;                        // Top left(?) of the bitmap
     nv3_size_16_t size;
     nv3_size_16_t size_in;
@@ -17,11 +17,291 @@
 
 #pragma once
 
+/* Most dirty rectangles we track per frame before giving up and converting the whole screen */
+#define NV3_RENDER_DIRTY_RECTS_MAX      32
+
+/* A part of the screen that PGRAPH drew to (inclusive) */
+typedef struct nv3_render_dirty_rect_s
+{
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+} nv3_render_dirty_rect_t;
+
+/* 
+    What needs to be sent to the monitor at the next vsync.
+    PGRAPH only ever draws into VRAM, and just adds to this list. The scanout path converts it to the monitor once per frame.
+*/
+typedef struct nv3_render_present_s
+{
+    nv3_render_dirty_rect_t rects[NV3_RENDER_DIRTY_RECTS_MAX];
+    uint32_t num_rects;
+    bool full;                          // Convert the whole screen (mode change, page flip, too many rects)
+    uint32_t display_start;             // Start address of the screen in VRAM at the last vsync, to detect page flips
+} nv3_render_present_t;
+
+/* Hardware cursor */
+#define NV3_RENDER_CURSOR_SIZE          32                                                  // Always 32x32
+#define NV3_RENDER_CURSOR_BYTES         (NV3_RENDER_CURSOR_SIZE * NV3_RENDER_CURSOR_SIZE * 2)   // a1r5g5b5
+
+/* 
+    The cursor image is decoded out of RAMIN once when it changes, and drawn over the screen at vsync.
+    row_mask has a bit set for every pixel that isn't transparent, so drawing it only touches those.
+*/
+typedef struct nv3_render_cursor_s
+{
+    bool enabled;
+    uint32_t ramin_address;             // Where the image is in RAMIN
+    uint32_t vram_start;                // The part of VRAM that the image is in (start inclusive, end exclusive)
+    uint32_t vram_end;
+    int32_t x;                          // Top left of the cursor. Can be off the top or left of the screen
+    int32_t y;
+    bool image_dirty;                   // The image has been written to since it was decoded
+    uint32_t image[NV3_RENDER_CURSOR_SIZE * NV3_RENDER_CURSOR_SIZE];    // x8r8g8b8
+    uint32_t row_mask[NV3_RENDER_CURSOR_SIZE];                          // Bit n = pixel n of the row is drawn
+    bool drawn;                         // It was drawn at the last vsync at drawn_x, drawn_y
+    int32_t drawn_x;
+    int32_t drawn_y;
+} nv3_render_cursor_t;
+
+/* 
+    Pixel pipelines.
+    A pipeline is the span routine for one combination of pixel size, ROP and per-pixel tests, put together from the ROP's row kernel and a
+    write-back routine that was specialised at compile time for exactly those tests, so the inner loops don't check anything that is constant
+    for the whole method. They are built once per method by nv3_render_span_begin.
+*/
+struct nv3_render_span_state_s;
+
+/* Write the ROP result back to VRAM for every pixel that passes the tests the pipeline was built for */
+typedef void (*nv3_render_pipeline_write_t)(const struct nv3_render_span_state_s* state, uint8_t* dst, const uint8_t* result, const uint8_t* src, 
+    uint64_t pattern_row, uint32_t x_mask, int32_t x_start, uint32_t count);
+
+typedef struct nv3_render_pipeline_s
+{
+    uint32_t bytes;                     // Bytes per pixel
+    bool uses_pattern;                  // The ROP depends on the pattern, so the pattern row has to be expanded
+    video_rop_row_kernel_t rop_kernel;  // Row kernel for the ROP
+    nv3_render_pipeline_write_t write;  // NULL if every pixel gets written, so the kernel can run directly on VRAM
+} nv3_render_pipeline_t;
+
+/* Per-method state for the span rasteriser. Everything in here only needs to be worked out once per method, not once per pixel. */
+typedef struct nv3_render_span_state_s
+{
+    nv3_grobj_t grobj;
+    uint32_t bpp;                       // Framebuffer bpp
+    uint8_t rop;                        // GDI ternary ROP
+    nv3_render_pipeline_t fill_pipeline;    // Pipeline for one colour spans. The colour is tested once per span, so only the pattern is per pixel
+    nv3_render_pipeline_t copy_pipeline;    // Pipeline for spans copied from VRAM, which test every source pixel
+
+    /* Clip rectangle (inclusive) */
+    int32_t clip_left;
+    int32_t clip_top;
+    int32_t clip_right;
+    int32_t clip_bottom;
+
+    bool alpha_enabled;                 // Reject pixels with alpha=0 in 15bpp
+    bool is_565;                        // RAMDAC is in 565 mode
+
+    bool chroma_enabled;                // Chroma key test enabled
+    uint32_t chroma_color;              // Chroma key, already in the object's colour format
+
+    uint32_t pattern_color[2];          // Pattern colours, already in the object's colour format
+    bool pattern_opaque[2];             // Pattern colour alpha is not zero
+
+    /* Area of the screen that was drawn to and needs to be sent to the monitor, worked out from the VRAM that was written */
+    bool dirty;
+    int32_t dirty_left;
+    int32_t dirty_top;
+    int32_t dirty_right;
+    int32_t dirty_bottom;
+} nv3_render_span_state_t;
+
+/* 
+    Image staging.
+    Images and bitmaps from the CPU arrive one dword per method. The pixels are collected here until a row is complete (or the buffer is full), 
+    and then the whole row is drawn with one span.
+*/
+#define NV3_RENDER_IMAGE_LINE_PIXELS    1024
+
+typedef struct nv3_render_image_s
+{
+    nv3_grobj_t grobj;                  // Object the staged pixels were sent to
+    uint32_t class_id;                  // Class of that object
+    nv3_position_16_t point;            // Top left of the image
+    uint32_t clip_x;                    // Pixels at or past this x are padding, and are thrown away
+    uint32_t width;                     // Pixels in a row of data (size_in)
+    uint32_t height;                    // Rows of data (size_in)
+    nv3_position_16_t position;         // Where the next pixel that arrives goes
+    uint32_t staged;                    // Number of pixels in line, which go at position.x - staged onwards
+    uint8_t line[NV3_RENDER_IMAGE_LINE_PIXELS * 4];
+} nv3_render_image_t;
+
+/* 
+    Scaled and stretched images (classes 0x0E and 0x15).
+    The source column for every destination column is worked out once per image, so each destination row is a gather (plus a blend when filtering) 
+    and one span. Coordinates and deltas are 12.20 fixed point, like the hardware's.
+*/
+#define NV3_RENDER_SCALED_MAX_WIDTH     2048        // Widest source or destination row that gets drawn
+
+typedef struct nv3_render_scaled_s
+{
+    nv3_grobj_t grobj;                  // Object being drawn
+    uint32_t bytes;                     // Bytes per pixel. The source is in the framebuffer format
+    bool bilinear;                      // Blend the 4 nearest source pixels instead of taking the nearest one (not at 8bpp)
+
+    /* Destination, clipped to the object's clip rectangle (inclusive) */
+    int32_t dst_left;
+    int32_t dst_top;
+    int32_t dst_right;
+    int32_t dst_bottom;
+
+    uint32_t src_width;
+    uint32_t src_height;
+
+    uint16_t columns[NV3_RENDER_SCALED_MAX_WIDTH];          // Source column of every destination column, from dst_left
+    uint8_t column_weights[NV3_RENDER_SCALED_MAX_WIDTH];    // How much of the source column after it to blend in, for bilinear
+
+    /* Class 0x15: the source arrives from the CPU one row at a time */
+    int64_t origin_y;                   // Destination y of the top of source row 0
+    int64_t dy_dv;                      // Destination rows per source row
+    uint32_t src_row;                   // Source row being received
+    uint32_t src_x;                     // Pixels of it received so far
+
+    /* Class 0x0E: the last two source rows read from memory, so magnified rows don't get read again */
+    int32_t src_line_row[2];
+    uint8_t src_line[2][NV3_RENDER_SCALED_MAX_WIDTH * 4];
+
+    uint8_t dst_line[NV3_RENDER_SCALED_MAX_WIDTH * 4];
+} nv3_render_scaled_t;
+
+/* 
+    D3D5 triangle rasteriser.
+    Modelled on the Voodoo: triangles are set up on the emulation thread, put in a ring buffer, and drawn by up to NV3_D3D5_RENDER_THREADS_MAX render threads.
+    The screen is split into interleaved bands of (1 << NV3_D3D5_BAND_SHIFT) lines, and each thread only draws the bands that belong to it, so the threads never touch 
+    the same pixels and don't need to lock anything.
+*/
+#define NV3_D3D5_RENDER_THREADS_MAX     8
+#define NV3_D3D5_PARAMS_SIZE            256                             // Must be a power of two
+#define NV3_D3D5_PARAMS_MASK            (NV3_D3D5_PARAMS_SIZE - 1)
+#define NV3_D3D5_BAND_SHIFT             4
+#define NV3_D3D5_VERTICES               128
+#define NV3_D3D5_ZETA_BUFFER            3                               // Surface that holds the zeta buffer. Assumption
+
+#define NV3_D3D5_PARAMS_ENTRIES(x)      (nv3->d3d5.params_write_idx - nv3->d3d5.params_read_idx[x])
+#define NV3_D3D5_PARAMS_FULL(x)         (NV3_D3D5_PARAMS_ENTRIES(x) >= NV3_D3D5_PARAMS_SIZE)
+#define NV3_D3D5_PARAMS_EMPTY(x)        (nv3->d3d5.params_read_idx[x] == nv3->d3d5.params_write_idx)
+
+/* A vertex, exactly as it was submitted */
+typedef struct nv3_d3d5_vertex_s
+{
+    uint32_t specular;                  // Top byte is the fog factor
+    uint32_t color;                     // A8R8G8B8
+    float x;
+    float y;
+    float z;
+    float m;                            // 1/W
+    float u;
+    float v;
+} nv3_d3d5_vertex_t;
+
+/* Everything that gets interpolated across a triangle */
+typedef enum nv3_d3d5_attribute_e
+{
+    nv3_d3d5_attribute_z = 0,
+    nv3_d3d5_attribute_m = 1,           // 1/W
+    nv3_d3d5_attribute_um = 2,          // U/W
+    nv3_d3d5_attribute_vm = 3,          // V/W
+    nv3_d3d5_attribute_r = 4,
+    nv3_d3d5_attribute_g = 5,
+    nv3_d3d5_attribute_b = 6,
+    nv3_d3d5_attribute_a = 7,
+    nv3_d3d5_attribute_fog = 8,
+    nv3_d3d5_attribute_count = 9,
+} nv3_d3d5_attribute;
+
+/* Plane equation for an attribute: value = start + (x * dx) + (y * dy) */
+typedef struct nv3_d3d5_gradient_s
+{
+    float start;
+    float dx;
+    float dy;
+} nv3_d3d5_gradient_t;
+
+/* A triangle that has been set up and is ready to draw. Has a copy of all the state, so the methods can carry on while the threads draw it */
+typedef struct nv3_d3d5_params_s
+{
+    /* Screen space positions, sorted top to bottom */
+    float x[3];
+    float y[3];
+    nv3_d3d5_gradient_t gradients[nv3_d3d5_attribute_count];
+
+    /* Clip rectangle (inclusive) */
+    int32_t clip_left;
+    int32_t clip_top;
+    int32_t clip_right;
+    int32_t clip_bottom;
+
+    /* Surfaces */
+    uint32_t bpp;
+    bool is_565;
+    uint32_t color_offset;
+    uint32_t color_pitch;
+    uint32_t zeta_offset;
+    uint32_t zeta_pitch;
+
+    /* Method state */
+    uint32_t texture_offset;
+    uint32_t texture_format;
+    uint32_t fog_color;
+    uint32_t control_out;
+    uint32_t alpha_control;
+} nv3_d3d5_params_t;
+
+/* D3D5 state, and the render threads */
+typedef struct nv3_d3d5_s
+{
+    /* Class 0x17 method state */
+    uint32_t texture_offset;
+    uint32_t texture_format;
+    uint32_t texture_filter;
+    uint32_t fog_color;
+    uint32_t control_out;
+    uint32_t alpha_control;
+    nv3_d3d5_vertex_t vertices[NV3_D3D5_VERTICES];
+
+    /* Class 0x18 method state */
+    uint32_t point_control_out;
+    uint32_t point_alpha_control;
+    uint32_t point_color[8];            // A8R8G8B8, drawn when the zeta for it is submitted
+
+    /* Render threads. With only one, triangles are just drawn straight away */
+    int32_t render_threads;
+    thread_t* render_thread[NV3_D3D5_RENDER_THREADS_MAX];
+    event_t* wake_render_thread[NV3_D3D5_RENDER_THREADS_MAX];
+    event_t* render_not_full_event[NV3_D3D5_RENDER_THREADS_MAX];
+    atomic_int render_thread_run[NV3_D3D5_RENDER_THREADS_MAX];
+    atomic_int render_busy[NV3_D3D5_RENDER_THREADS_MAX];
+    atomic_int params_read_idx[NV3_D3D5_RENDER_THREADS_MAX];
+    atomic_int params_write_idx;
+    nv3_d3d5_params_t params_buffer[NV3_D3D5_PARAMS_SIZE];
+} nv3_d3d5_t;
+
 /* Core */
-void nv3_render_current_bpp(svga_t *svga, nv3_position_16_t position, nv3_size_16_t size, nv3_grobj_t grobj);
-void nv3_render_current_bpp_dfb_8(uint32_t address);
-void nv3_render_current_bpp_dfb_16(uint32_t address);
-void nv3_render_current_bpp_dfb_32(uint32_t address);
+void nv3_render_mark_dirty(nv3_position_16_t position, nv3_size_16_t size);                                                 // Add part of the screen to the list to present at the next vsync
+void nv3_render_mark_vram_dirty(uint32_t vram_address, uint32_t size);                                                     // Mark whatever part of the screen a range of VRAM covers as dirty
+bool nv3_render_vram_to_rect(uint32_t vram_address, uint32_t size, nv3_render_dirty_rect_t* rect);                          // Work out which part of the screen a range of VRAM covers
+void nv3_render_mark_full(void);                                                                                            // Present the whole screen at the next vsync
+void nv3_render_present(svga_t* svga);                                                                                      // Convert everything that changed to the monitor (vsync callback)
+
+/* Hardware cursor */
+void nv3_render_cursor_set_address(void);                                                                                   // CRTC cursor address/enable registers changed
+void nv3_render_cursor_set_position(uint32_t value);                                                                        // PRAMDAC cursor position changed
+void nv3_render_cursor_prepare(void);                                                                                       // Mark where the cursor was if it moved, before presenting
+void nv3_render_cursor(svga_t* svga, int32_t width, int32_t height);                                                       // Draw the cursor over the presented screen
+
+/* Video overlay */
+void nv3_render_overlay(svga_t* svga, uint32_t display_start, uint32_t pitch, int32_t width, int32_t height);               // Put the PVIDEO overlay over the presented screen
 
 void nv3_render_write_pixel(nv3_position_16_t position, uint32_t color, nv3_grobj_t grobj);
 uint8_t nv3_render_read_pixel_8(nv3_position_16_t position, nv3_grobj_t grobj);
@@ -29,6 +309,7 @@ uint16_t nv3_render_read_pixel_16(nv3_position_16_t position, nv3_grobj_t grobj)
 uint32_t nv3_render_read_pixel_32(nv3_position_16_t position, nv3_grobj_t grobj);
 
 
+uint32_t nv3_render_get_buffer(nv3_grobj_t grobj);                                                                          // Get the surface a grobj draws to
 uint32_t nv3_render_get_vram_address(nv3_position_16_t position, nv3_grobj_t grobj);
 
 uint32_t nv3_render_to_chroma(nv3_color_expanded_t expanded);
@@ -38,6 +319,19 @@ uint32_t nv3_render_downconvert_color(nv3_grobj_t grobj, nv3_color_expanded_t co
 /* Pattern */
 uint32_t nv3_render_set_pattern_color(nv3_color_expanded_t pattern_colour, bool use_color1);
 
+/* Spans */
+void nv3_render_span_begin(nv3_render_span_state_t* state, nv3_grobj_t grobj);                                              // Work out the per-method state for drawing
+void nv3_render_span_fill(nv3_render_span_state_t* state, int32_t x, int32_t y, int32_t width, uint32_t color);            // Draw a clipped row of pixels in one colour
+void nv3_render_span_copy(nv3_render_span_state_t* state, int32_t x, int32_t y, int32_t width, uint32_t src_addr_vram);    // Copy a row of pixels from elsewhere in VRAM
+void nv3_render_span_write(nv3_render_span_state_t* state, int32_t x, int32_t y, int32_t width, const uint8_t* src);      // Draw a row of pixels that are already in the framebuffer format
+void nv3_render_span_pixel(nv3_render_span_state_t* state, nv3_position_16_t position, uint32_t color);                     // Draw one pixel
+void nv3_render_span_end(nv3_render_span_state_t* state);                                                                   // Mark what was drawn as dirty
+
+/* Pipelines */
+void nv3_render_pipeline_build(nv3_render_pipeline_t* pipeline, uint32_t bpp, uint8_t rop, bool chroma, bool alpha, bool pattern);    // Put together the pipeline for a state
+void nv3_render_pipeline_run(const nv3_render_pipeline_t* pipeline, struct nv3_render_span_state_s* state, uint32_t dst_addr_vram, uint32_t src,
+    const uint8_t* src_buffer, bool src_solid, bool backwards, int32_t x_start, uint32_t count, uint64_t pattern_row, uint32_t x_mask);  // Run a pipeline over a row
+
 /* Primitives */
 void nv3_render_rect(nv3_position_16_t position, nv3_size_16_t size, uint32_t color, nv3_grobj_t grobj);                    // Render an A (unclipped) GDI rect
 void nv3_render_rect_clipped(nv3_clip_16_t clip, uint32_t color, nv3_grobj_t grobj);                                        // Render a B (clipped) GDI rect.
@@ -46,9 +340,25 @@ void nv3_render_rect_clipped(nv3_clip_16_t clip, uint32_t color, nv3_grobj_t gro
 bool nv3_render_chroma_test(uint32_t color, nv3_grobj_t grobj);
 
 /* Blit */
-void nv3_render_blit_image(uint32_t color, nv3_grobj_t grobj);
+void nv3_render_image_begin(uint32_t class_id, nv3_position_16_t point, nv3_size_16_t size, nv3_size_16_t size_in);        // Start a new image or bitmap from the CPU
+void nv3_render_image_push(const uint8_t* pixels, uint32_t count, nv3_grobj_t grobj);                                      // Stage pixels sent by the CPU, drawing every row that gets completed
+void nv3_render_image_flush(void);                                                                                          // Draw whatever is staged
+void nv3_render_blit_image(uint32_t color, nv3_grobj_t grobj);                                                              // Image from CPU (class 0x11) colour method
+void nv3_render_blit_bitmap(uint32_t bitmap_data, nv3_grobj_t grobj);                                                       // Bitmap from CPU (class 0x12) monochrome method
 void nv3_render_blit_screen2screen(nv3_grobj_t grobj);
 
+/* Scaled */
+void nv3_render_scaled_image_from_memory(nv3_grobj_t grobj);                                                                // Draw a scaled image (class 0x0E) from a DMA object
+void nv3_render_stretched_image_begin(nv3_grobj_t grobj);                                                                   // Start a stretched image from the CPU (class 0x15)
+void nv3_render_stretched_image_push(uint32_t color, nv3_grobj_t grobj);                                                    // Stretched image colour method
+
 /* GDI */
 void nv3_render_gdi_transparent_bitmap(bool clip, uint32_t color, uint32_t bitmap_data, nv3_grobj_t grobj);
-void nv3_render_gdi_1bpp_bitmap(uint32_t color0, uint32_t color1, uint32_t bitmap_data, nv3_grobj_t grobj);                               /* GDI Type-E: Clipped 1bpp colour-expanded bitmap */
\ No newline at end of file
+void nv3_render_gdi_1bpp_bitmap(uint32_t color0, uint32_t color1, uint32_t bitmap_data, nv3_grobj_t grobj);                               /* GDI Type-E: Clipped 1bpp colour-expanded bitmap */
+
+/* D3D5 */
+void nv3_render_d3d5_init(int32_t render_threads);                                                                          // Start the render threads
+void nv3_render_d3d5_close(void);                                                                                           // Stop the render threads
+void nv3_render_d3d5_triangle(nv3_grobj_t grobj, uint32_t vertex0, uint32_t vertex1, uint32_t vertex2);                    // Set up a triangle and queue it for drawing
+void nv3_render_d3d5_point(nv3_grobj_t grobj, nv3_position_16_t position, uint32_t color, uint32_t zeta);                  // Draw a point with zeta buffer (class 0x18)
+void nv3_render_d3d5_wait_idle(void);                                                                                       // Wait for the render threads to finish everything
@@ -27,7 +27,9 @@
 #ifdef EMU_DEVICE_H // what
 
 //TODO: split this all into nv1, nv3, nv4...
+#include <stdatomic.h>
 #include <86box/log.h>
+#include <86box/thread.h>
 #include <86box/i2c.h>
 #include <86box/vid_ddc.h>
 #include <86box/timer.h>
@@ -35,11 +37,7 @@
 #include <86box/vid_svga_render.h>
 #include <86box/nv/vid_nv_rivatimer.h>
 
-void nv_log_set_device(void* device);
-void nv_log(const char *fmt, ...);
-
-// Verbose logging level.
-void nv_log_verbose_only(const char *fmt, ...);
+#include <86box/nv/vid_nv_log.h>
 
 // Defines common to all NV chip architectural generations
 
@@ -150,5 +148,36 @@ typedef struct nv_register_s
 
 nv_register_t* nv_get_register(uint32_t address, nv_register_t* register_list, uint32_t num_regs);
 
+// Register lists are searched in a loop, which is far too slow for registers the drivers poll constantly.
+// So each subsystem builds one of these from its list when it initialises: one pointer per dword between the lowest and highest register, 
+// so finding a register is just an index.
+typedef struct nv_register_table_s
+{
+    uint32_t        start;                      // Address of the lowest register in the list
+    uint32_t        num_entries;                // Number of dwords from the lowest to the highest register
+    nv_register_t** lookup;                     // The register at each dword, or NULL if there isn't one
+} nv_register_table_t;
+
+void nv_register_table_build(nv_register_table_t* table, nv_register_t* register_list, uint32_t num_regs);
+
+// Gets a register from a register table. Same result as nv_get_register on the list it was built from
+static inline nv_register_t* nv_register_table_get(nv_register_table_t* table, uint32_t address)
+{
+    uint32_t index = (address - table->start) >> 2;
+
+    if (address < table->start
+    || index >= table->num_entries)
+        return NULL;
+
+    nv_register_t* reg = table->lookup[index];
+
+    // Catch registers that aren't dword aligned
+    if (!reg
+    || (uint32_t)reg->address != address)
+        return NULL;
+
+    return reg;
+}
+
 
 #endif
\ No newline at end of file
@@ -22,6 +22,7 @@
  */
 
 #pragma once
+#include <86box/utils/video_stdlib.h>
 #include <86box/nv/classes/vid_nv3_classes.h>
 #include <86box/nv/render/vid_nv3_render.h>
 
@@ -265,6 +266,8 @@ extern const device_config_t nv3_config[];
 #define NV3_PFIFO_CACHE1_SIZE_REV_AB                    32
 #define NV3_PFIFO_CACHE1_SIZE_REV_C                     64
 #define NV3_PFIFO_CACHE1_SIZE_MAX                       NV3_PFIFO_CACHE1_SIZE_REV_C
+#define NV3_PFIFO_CACHE1_PULLER_BATCH                   NV3_PFIFO_CACHE1_SIZE_MAX   // Maximum number of entries the puller drains per wakeup
+#define NV3_PFIFO_CACHE1_PULLER_DELAY                   (TIMER_USEC * 20)           // Delay before the puller wakes up after CACHE1 goes non-empty
 #define NV3_PFIFO_CACHE_REASSIGNMENT                    0x2500        
 
 #define NV3_PFIFO_CACHE0_PUSH0                          0x3000
@@ -685,8 +688,23 @@ extern const device_config_t nv3_config[];
 #define NV3_PVIDEO_START                                0x680000    // Video Generation / overlay configuration
 #define NV3_PVIDEO_INTR                                 0x680100
 #define NV3_PVIDEO_INTR_EN                              0x680140
+#define NV3_PVIDEO_STEP_SIZE                            0x680200    // Source pixels per screen pixel, 1.11 fixed point
+#define NV3_PVIDEO_CONTROL_Y                            0x680204
+#define NV3_PVIDEO_CONTROL_X                            0x680208
+#define NV3_PVIDEO_BUFF0_START                          0x68020C    // Two buffers so that the driver can flip between them
+#define NV3_PVIDEO_BUFF1_START                          0x680210
+#define NV3_PVIDEO_BUFF0_PITCH                          0x680214
+#define NV3_PVIDEO_BUFF1_PITCH                          0x680218
+#define NV3_PVIDEO_BUFF0_OFFSET                         0x68021C
+#define NV3_PVIDEO_BUFF1_OFFSET                         0x680220
+#define NV3_PVIDEO_OE_STATE                             0x680224    // Bit0 = Buffer being scanned out
+#define NV3_PVIDEO_SU_STATE                             0x680228
+#define NV3_PVIDEO_RM_STATE                             0x68022C
+#define NV3_PVIDEO_WINDOW_START                         0x680230    // Bits 0-10 = X, Bits 16-26 = Y
+#define NV3_PVIDEO_WINDOW_SIZE                          0x680234    // Bits 0-10 = Width, Bits 16-26 = Height
 #define NV3_PVIDEO_FIFO_THRESHOLD                       0x680238
 #define NV3_PVIDEO_FIFO_BURST_LENGTH                    0x68023C
+#define NV3_PVIDEO_KEY                                  0x680240    // Framebuffer colour that the overlay shows through
 #define NV3_PVIDEO_OVERLAY                              0x680244
 #define NV3_PVIDEO_OVERLAY_VIDEO_IS_ON                  0
 #define NV3_PVIDEO_OVERLAY_KEY_ENABLED                  4
@@ -694,6 +712,7 @@ extern const device_config_t nv3_config[];
 
 #define NV3_PVIDEO_END                                  0x6802FF
 #define NV3_PRAMDAC_START                               0x680300
+#define NV3_PRAMDAC_CURSOR_START                        0x680300    // Bits 11:0 = X, Bits 27:16 = Y, both signed
 
 #define NV3_PRAMDAC_CLOCK_MEMORY                        0x680504
 #define NV3_PRAMDAC_CLOCK_MEMORY_VDIV                   7:0
@@ -836,6 +855,8 @@ extern const device_config_t nv3_config[];
 #define NV3_CRTC_REGISTER_PIXELMODE_16BPP               0x02
 #define NV3_CRTC_REGISTER_PIXELMODE_32BPP               0x03 
 
+#define NV3_CRTC_REGISTER_CURSOR_ADDR0                  0x30        // Cursor image RAMIN address bits 22:16
+#define NV3_CRTC_REGISTER_CURSOR_ADDR1                  0x31        // Bit0 = Cursor on, Bits 7:3 = Cursor image RAMIN address bits 15:11
 #define NV3_CRTC_REGISTER_RL0                           0x34
 #define NV3_CRTC_REGISTER_RL1                           0x35
 #define NV3_CRTC_REGISTER_RMA                           0x38        // REAL MODE ACCESS!
@@ -1032,6 +1053,8 @@ typedef struct nv3_pfifo_s
 
     nv3_pfifo_cache_entry_t cache0_entry;                              // It only has 1 entry
     nv3_pfifo_cache_entry_t cache1_entries[NV3_PFIFO_CACHE1_SIZE_MAX]; // ONLY 32 USED ON REVISION A/B CARDS
+
+    pc_timer_t cache1_puller_timer;                                     // Drains CACHE1 in batches so NV_USER writes don't run PGRAPH synchronously
 } nv3_pfifo_t;
 
 // RAMDAC
@@ -1047,6 +1070,7 @@ typedef struct nv3_pramdac_s
     uint32_t coeff_select;      // coefficient select
 
     uint32_t general_control;   // general control register
+    uint32_t cursor_start;      // hardware cursor position
 
     // this could duplicate SVGA state but I tihnk it's more readable,
     // we'll just modify both
@@ -1236,7 +1260,8 @@ typedef struct nv3_pgraph_s
     struct nv3_object_class_00E scaled_image_from_memory;
     struct nv3_object_class_010 blit;
     struct nv3_object_class_011 image;
-    nv3_position_16_t image_current_position;               /* This is here so we can hold the current state of the image */
+    nv3_render_image_t image_staging;                       /* Pixels of the image or bitmap from the CPU that haven't been drawn yet */
+    nv3_render_scaled_t scaled;                             /* Scaled (0x0E) or stretched (0x15) image being drawn */
     struct nv3_object_class_012 bitmap;
     struct nv3_object_class_014 transfer2memory;
     struct nv3_object_class_015 stretched_image_from_cpu;
@@ -1306,8 +1331,11 @@ typedef struct nv3_ptimer_s
     uint32_t interrupt_enable;          // PTIMER Interrupt enable
     uint32_t clock_numerator;           // PTIMER (tick?) numerator
     uint32_t clock_denominator;         // PTIMER (tick?) denominator
-    uint64_t time;                      // time
+    uint64_t time;                      // Value of time at time_host. Read it with nv3_ptimer_get_time
+    double time_host;                   // Host monotonic time in uS that time was last brought up to date at
+    double rate;                        // How much time goes up by every uS. 0 if it's stopped
     uint32_t alarm;                     // The value of time when there should be an alarm
+    rivatimer_t* alarm_timer;           // One-shot timer that fires when the low 32 bits of time reach alarm
 } nv3_ptimer_t;
 
 // Object name is just a uint32_t identifier it doesn't need a struct
@@ -1331,6 +1359,7 @@ typedef struct nv3_ramin_context_s
 } nv3_ramin_context_t;
 
 // Graphics object hashtable for specific DMA [channel, subchannel] pair
+// This caches the last object found in RAMHT for the [channel, subchannel] pair, and its grobj, so we don't have to walk RAMIN every method
 typedef struct nv3_ramin_ramht_subchannel_s
 {
     uint32_t           name;                      // must be >4096
@@ -1338,12 +1367,21 @@ typedef struct nv3_ramin_ramht_subchannel_s
     // Contextual information.
     // See the above union.
     nv3_ramin_context_t context;                       
+
+    bool               name_valid;                // name -> context was resolved from RAMHT
+    bool               grobj_valid;               // grobj was read from RAMIN at grobj_ramin_offset
+    uint16_t           grobj_ramin_offset;        // ramin_offset of the context the grobj belongs to
+    nv3_grobj_t        grobj;
 } nv3_ramin_ramht_subchannel_t;
 
 // Graphics object hashtable
 typedef struct nv3_ramin_ramht_s
 {
     nv3_ramin_ramht_subchannel_t subchannels[NV3_DMA_CHANNELS][NV3_DMA_SUBCHANNELS_PER_CHANNEL];
+
+    // Lowest VRAM address that any cached entry came from (RAMIN is reversed, so it grows down from the top of VRAM).
+    // DFB writes at or above this can hit RAMIN and flush the cache.
+    uint32_t cache_vram_floor;
 } nv3_ramin_ramht_t;
 
 
@@ -1404,6 +1442,18 @@ typedef struct nv3_pvideo_s
     uint32_t fifo_threshold;            // FIFO threshold
     uint32_t fifo_burst_size;           // FIFO burst size
     uint32_t overlay_settings;          // Overlay settings
+    uint32_t step_size;                 // Source pixels per screen pixel (1.11)
+    uint32_t control_x;
+    uint32_t control_y;
+    uint32_t buffer_start[2];           // Where the two overlay buffers are in VRAM
+    uint32_t buffer_pitch[2];
+    uint32_t buffer_offset[2];
+    uint32_t oe_state;                  // Bit0 = Buffer being scanned out
+    uint32_t su_state;
+    uint32_t rm_state;
+    nv3_position_16_t window_start;     // Where the overlay is on the screen
+    nv3_size_16_t window_size;
+    uint32_t key;                       // Colour key
 } nv3_pvideo_t;
 
 typedef struct nv3_pme_s                // Mediaport
@@ -1412,6 +1462,50 @@ typedef struct nv3_pme_s                // Mediaport
     uint32_t interrupt_enable;
 } nv3_pme_t;
 
+/* 
+    PGRAPH command stream capture (nv3_core_capture.c).
+    A capture file is a nv3_capture_header_t, the contents of VRAM (which RAMIN is part of), the PFIFO, PGRAPH and PRAMDAC state, 
+    and then one nv3_capture_record_t for every write that was pushed into CACHE1. The state is copied as it is in memory, 
+    so a capture can only be replayed by the same build of the emulator; the sizes in the header are there to catch that.
+*/
+#define NV3_CAPTURE_MAGIC               0x5043334E  // "NV3C"
+#define NV3_CAPTURE_VERSION             1
+#define NV3_CAPTURE_RECORD_FRAME        0xFFFFFFFF  // Address of the record that marks a vsync
+#define NV3_CAPTURE_BUFFER_SIZE         4096        // Records to build up before writing them out
+#define NV3_CAPTURE_CLASSES             0x20        // PGRAPH only has 5 bits of class id
+
+typedef struct nv3_capture_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vram_size;
+    uint32_t bpp;                       // SVGA state that the renderer uses
+    uint32_t rowoffset;
+    uint32_t hdisp;
+    uint32_t dispend;
+    uint32_t pfifo_size;                // sizeof each state struct when it was captured
+    uint32_t pgraph_size;
+    uint32_t pramdac_size;
+} nv3_capture_header_t;
+
+typedef struct nv3_capture_record_s
+{
+    uint32_t address;                   // NV_USER address: channel, subchannel and method
+    uint32_t param;
+} nv3_capture_record_t;
+
+typedef struct nv3_capture_s
+{
+    FILE* file;
+    bool armed;                         // Start at the next vsync in an accelerated mode
+    bool recording;
+    uint32_t frames_left;               // Vsyncs to go before the capture is finished
+    uint32_t num_buffered;
+    nv3_capture_record_t buffer[NV3_CAPTURE_BUFFER_SIZE];
+
+    uint64_t pixels;                    // Pixels the span rasteriser has drawn, for replay statistics
+} nv3_capture_t;
+
 typedef struct nv3_s
 {
     nv_base_t nvbase;   // Base Nvidia structure
@@ -1437,6 +1531,10 @@ typedef struct nv3_s
     nv3_ramin_t pramin;        // Ram for INput of DMA objects. Very important!
     nv3_pvideo_t pvideo;        // Video overlay
     nv3_pme_t pme;              // Mediaport - external MPEG decoder and video interface
+    nv3_render_present_t present;   // Dirty parts of the screen, presented at vsync
+    nv3_render_cursor_t cursor;     // Hardware cursor
+    nv3_d3d5_t d3d5;                // D3D5 triangle state and render threads
+    nv3_capture_t capture;          // Command stream capture
     //more here
 
 } nv3_t;
@@ -1444,6 +1542,14 @@ typedef struct nv3_s
 // device object
 extern nv3_t* nv3;
 
+// Something wrote to VRAM. If it was the cursor image, it needs to be decoded again
+static inline void nv3_cursor_vram_written(uint32_t addr, uint32_t size)
+{
+    if (addr < nv3->cursor.vram_end
+    && (addr + size) > nv3->cursor.vram_start)
+        nv3->cursor.image_dirty = true;
+}
+
 /*
     *FUNCTIONS* for the GPU core start here
     Functions for PGRAPH objects are in vid_nv3_classes.h
@@ -1502,6 +1608,13 @@ void        nv3_ramro_write(uint32_t address, uint32_t value);
 uint32_t    nv3_ramht_read(uint32_t address);
 void        nv3_ramht_write(uint32_t address, uint32_t value);
 
+// RAMHT object translation cache
+void        nv3_ramht_cache_invalidate(void);
+bool        nv3_ramht_cache_find_object(uint32_t name, uint8_t channel, uint8_t subchannel, nv3_ramin_context_t* context);
+void        nv3_ramht_cache_store_object(uint32_t name, uint8_t channel, uint8_t subchannel, nv3_ramin_context_t context, uint32_t ramht_address);
+bool        nv3_ramht_cache_get_grobj(uint8_t channel, uint8_t subchannel, nv3_ramin_context_t context, nv3_grobj_t* grobj);
+void        nv3_ramht_cache_store_grobj(uint8_t channel, uint8_t subchannel, nv3_ramin_context_t context, nv3_grobj_t grobj);
+
 // MMIO Arbitration
 // Determine where the hell in this mess our reads or writes are going
 uint32_t    nv3_mmio_arbitrate_read(uint32_t address);
@@ -1568,6 +1681,8 @@ void        nv3_pgraph_vblank_start(svga_t* svga);
 void        nv3_pgraph_interrupt_valid(uint32_t num);
 void        nv3_pgraph_interrupt_invalid(uint32_t num);
 void        nv3_pgraph_submit(uint32_t param, uint16_t method, uint8_t channel, uint8_t subchannel, uint8_t class_id, nv3_ramin_context_t context);
+bool        nv3_pgraph_dma_read(uint32_t dma_object, uint32_t offset, uint8_t* buffer, uint32_t size);          // Bulk read from a DMA object
+bool        nv3_pgraph_dma_write(uint32_t dma_object, uint32_t offset, const uint8_t* buffer, uint32_t size);   // Bulk write to a DMA object
 
 // PGRAPH class methods
 // this should be in "vid_nv3_classes.h", but before that can happen, some things need to be rejigged
@@ -1609,6 +1724,10 @@ void        nv3_pfifo_interrupt(uint32_t id, bool fire_now);
 void        nv3_pfifo_cache0_pull(void);
 void        nv3_pfifo_cache1_push(uint32_t addr, uint32_t val);
 void        nv3_pfifo_cache1_pull(void);
+uint32_t    nv3_pfifo_cache1_drain(uint32_t max_entries);
+void        nv3_pfifo_cache1_wake_puller(void);
+void        nv3_pfifo_cache1_puller_timer(void* priv);
+bool        nv3_pfifo_cache1_is_empty(void);
 uint32_t    nv3_pfifo_cache1_normal2gray(uint32_t val);
 uint32_t    nv3_pfifo_cache1_gray2normal(uint32_t val);
 uint32_t    nv3_pfifo_cache1_num_free_spaces(void);
@@ -1635,10 +1754,18 @@ void        nv3_pramdac_memory_clock_poll(double real_time);
 
 // NV3 PTIMER
 void        nv3_ptimer_init(void);
-void        nv3_ptimer_tick(double real_time);
+uint64_t    nv3_ptimer_get_time(void);
+void        nv3_ptimer_update_rate(void);
 
 // NV3 PVIDEO
 void        nv3_pvideo_init(void);
 
+// Command stream capture and replay
+void        nv3_capture_init(const char* path, uint32_t frames);            // Start a capture at the next vsync in an accelerated mode
+void        nv3_capture_push(uint32_t addr, uint32_t param);                // Record a write into CACHE1
+void        nv3_capture_frame(svga_t* svga);                                // Vsync
+void        nv3_capture_close(void);
+bool        nv3_capture_replay(const char* path);                           // Run a capture through PFIFO and PGRAPH as fast as possible and log how long it took
+
 // NV3 PME (Mediaport)
 void        nv3_pme_init(void); 
\ No newline at end of file
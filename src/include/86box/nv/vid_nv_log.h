@@ -0,0 +1,80 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Logging for emulation of NVidia video cards.
+ *
+ *          nv_log and nv_log_verbose_only are macros, so a log site that is turned off never evaluates its arguments or makes a call:
+ *          - Levels above NV_LOG_LEVEL_MAX (set by ENABLE_NV_LOG / ENABLE_NV_LOG_ULTRA) compile to nothing.
+ *          - Everything else is one test of a bitmask: which subsystems are logged at that level, set at runtime with nv_log_configure.
+ *
+ *          A file says which subsystem its log sites belong to by defining NV_LOG_SUBSYSTEM before including this header.
+ *
+ * Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+ *
+ *          Copyright 2024-2025 starfrost
+ */
+#pragma once
+#include <stdint.h>
+
+// Log levels
+#define NV_LOG_LEVEL_NONE       0
+#define NV_LOG_LEVEL_NORMAL     1       // nv_log
+#define NV_LOG_LEVEL_VERBOSE    2       // nv_log_verbose_only
+
+#ifndef NV_LOG_LEVEL_MAX
+#if defined(ENABLE_NV_LOG) && defined(ENABLE_NV_LOG_ULTRA)
+#define NV_LOG_LEVEL_MAX        NV_LOG_LEVEL_VERBOSE
+#elif defined(ENABLE_NV_LOG)
+#define NV_LOG_LEVEL_MAX        NV_LOG_LEVEL_NORMAL
+#else
+#define NV_LOG_LEVEL_MAX        NV_LOG_LEVEL_NONE
+#endif
+#endif
+
+// Subsystem masks
+#define NV_LOG_CORE             (1 << 0)    // Core, config, MMIO arbitration
+#define NV_LOG_PMC              (1 << 1)
+#define NV_LOG_PBUS             (1 << 2)
+#define NV_LOG_PFB              (1 << 3)
+#define NV_LOG_PEXTDEV          (1 << 4)
+#define NV_LOG_PTIMER           (1 << 5)
+#define NV_LOG_PFIFO            (1 << 6)
+#define NV_LOG_PRAMIN           (1 << 7)    // Includes RAMHT, RAMFC and RAMRO
+#define NV_LOG_PGRAPH           (1 << 8)
+#define NV_LOG_PRAMDAC          (1 << 9)
+#define NV_LOG_PVIDEO           (1 << 10)
+#define NV_LOG_PME              (1 << 11)
+#define NV_LOG_USER             (1 << 12)
+#define NV_LOG_CLASS            (1 << 13)   // Graphics object methods
+#define NV_LOG_RENDER           (1 << 14)
+#define NV_LOG_ALL              0x7FFF
+
+#ifndef NV_LOG_SUBSYSTEM
+#define NV_LOG_SUBSYSTEM        NV_LOG_CORE
+#endif
+
+// The subsystems that are logged at each level
+extern uint32_t nv_log_masks[NV_LOG_LEVEL_VERBOSE + 1];
+
+void nv_log_set_device(void* device);
+void nv_log_configure(int32_t level, uint32_t subsystem_mask);
+void nv_log_print(const char *fmt, ...);
+
+// Is a log site at this level in this subsystem turned on? Use this to skip work that is only done to log something
+#define nv_log_enabled(level, subsystem) \
+    ((level) <= NV_LOG_LEVEL_MAX && (nv_log_masks[(level)] & (subsystem)))
+
+// These are expressions rather than statements because some callers use them in ?:
+#define nv_log(...)                                                         \
+    (nv_log_enabled(NV_LOG_LEVEL_NORMAL, NV_LOG_SUBSYSTEM)                  \
+        ? nv_log_print(__VA_ARGS__) : (void)0)
+
+// Verbose logging level.
+#define nv_log_verbose_only(...)                                            \
+    (nv_log_enabled(NV_LOG_LEVEL_VERBOSE, NV_LOG_SUBSYSTEM)                 \
+        ? nv_log_print(__VA_ARGS__) : (void)0)
@@ -56,20 +56,26 @@ So I decided to create this timer that is completely separate from the CPU Core.
 #include <time.h>
 #endif
 
+#define RIVATIMER_MAX                   32      // Most rivatimers that can exist at once
+#define RIVATIMER_MAX_CATCHUP           4       // Most callbacks for one timer per update. Any more missed periods get folded into the last one
+
+/* 
+    Running rivatimers are kept in a min-heap ordered by deadline, so rivatimer_update_all only has to look at the ones that are due.
+    All times are in microseconds of host monotonic time, so they don't jump when the wall clock does.
+*/
 typedef struct rivatimer_s
 {
-    struct rivatimer_s*     prev;           // Previous Rivatimer
     double                  period;         // Period in uS before firing
-    double                  value;          // The current value of the rivatimer
+    double                  deadline;       // Monotonic time in uS when it fires next
     bool                    running;        // Is this RivaTimer running?
-    struct rivatimer_s*     next;           // Next RivaTimer
+    bool                    in_use;         // Has this slot in the pool been created and not destroyed?
+    int32_t                 heap_index;     // Where it is in the deadline heap, -1 if it isn't running
     void                    (*callback)(double real_time);  // Callback to call on fire
-    #ifdef _WIN32
-    LARGE_INTEGER           starting_time;  // Starting time.
-    #else
-    struct timespec         starting_time;  // Starting time.
-    #endif
     double                  time;           // Accumulated time in uS.
+    uint64_t                fired;          // Number of periods that have elapsed since it was started
+    uint64_t                coalesced;      // Number of those that were folded into another callback because we fell behind
+    uint32_t                generation;     // Bumped by start, stop and set_period, so a catch-up can tell the callback rescheduled the timer
+    struct rivatimer_s*     next_free;      // Next free slot in the pool
 } rivatimer_t;
 
 void rivatimer_init(void);                                              // Initialise the Rivatimer.
@@ -77,6 +83,8 @@ rivatimer_t* rivatimer_create(double period, void (*callback)(double real_time))
 void rivatimer_destroy(rivatimer_t* rivatimer_ptr);
 
 void rivatimer_update_all(void);
+double rivatimer_get_monotonic_time(void);                              // Current host monotonic time in uS, the same clock that deadlines use
+double rivatimer_get_next_deadline(void);                               // Monotonic time in uS that the next timer fires at, or a negative number if none are running
 void rivatimer_start(rivatimer_t* rivatimer_ptr);
 void rivatimer_stop(rivatimer_t* rivatimer_ptr);
 double rivatimer_get_time(rivatimer_t* rivatimer_ptr);
@@ -14,7 +14,23 @@
  *
  *          Copyright 2025 Connor Hyde
  */
-
+#ifndef EMU_VIDEO_STDLIB_H
+#define EMU_VIDEO_STDLIB_H
  
 /* ROP */
-int32_t video_rop_gdi_ternary(int32_t rop, int32_t src, int32_t dst, int32_t pattern);
\ No newline at end of file
+int32_t video_rop_gdi_ternary(int32_t rop, int32_t src, int32_t dst, int32_t pattern);
+
+/* 
+    ROP row kernels.
+    Ternary ROPs are bitwise, so one kernel works for any bpp as long as src and pattern are laid out the same way as the destination.
+    Get the kernel once per blit with video_rop_get_row_kernel, then run it on every row: dst = rop(dst, src, pattern) for bytes bytes.
+    dst, src and pattern don't need to be aligned.
+*/
+typedef void (*video_rop_row_kernel_t)(uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes);
+
+video_rop_row_kernel_t video_rop_get_row_kernel(uint8_t rop);
+
+/* Fill a row with a solid colour of the given bpp (8, 15, 16, 24 or 32), e.g. to turn a solid source or pattern colour into a row for a kernel */
+void video_rop_fill_row(uint8_t* row, uint32_t color, uint32_t bpp, uint32_t pixels);
+
+#endif /*EMU_VIDEO_STDLIB_H*/
@@ -0,0 +1,222 @@
+#include <stdint.h>
+#include <string.h>
+#include <86box/utils/video_stdlib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* 
+    Specialised row kernels for GDI ternary ROPs, for when a whole row of a blit is done at once instead of calling video_rop_gdi_ternary for every pixel.
+
+    Every ROP3 code is a truth table: bit ((pattern << 2) | (src << 1) | dst) of the code is the output for those input bits. So the ROP can be worked out
+    as the OR of the minterms whose bit is set. With the code as a compile time constant, the compiler throws away the minterms that aren't used,
+    and we get one branchless kernel per ROP code that doesn't care about the bpp. 
+*/
+
+#define VIDEO_ROP_EVAL(rop, p, s, d, not)                           \
+    (((rop & 0x01) ? (not(p) & not(s) & not(d)) : 0)                \
+    | ((rop & 0x02) ? (not(p) & not(s) & (d)) : 0)                  \
+    | ((rop & 0x04) ? (not(p) & (s) & not(d)) : 0)                  \
+    | ((rop & 0x08) ? (not(p) & (s) & (d)) : 0)                     \
+    | ((rop & 0x10) ? ((p) & not(s) & not(d)) : 0)                  \
+    | ((rop & 0x20) ? ((p) & not(s) & (d)) : 0)                     \
+    | ((rop & 0x40) ? ((p) & (s) & not(d)) : 0)                     \
+    | ((rop & 0x80) ? ((p) & (s) & (d)) : 0))
+
+#define VIDEO_ROP_NOT(x) (~(x))
+
+static inline uint32_t 
+video_rop_eval32(const uint8_t rop, uint32_t p, uint32_t s, uint32_t d)
+{
+    return VIDEO_ROP_EVAL(rop, p, s, d, VIDEO_ROP_NOT);
+}
+
+static inline uint8_t 
+video_rop_eval8(const uint8_t rop, uint8_t p, uint8_t s, uint8_t d)
+{
+    return (uint8_t)VIDEO_ROP_EVAL(rop, p, s, d, VIDEO_ROP_NOT);
+}
+
+#ifdef __SSE2__
+static inline __m128i 
+video_rop_eval128(const uint8_t rop, __m128i p, __m128i s, __m128i d)
+{
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i np = _mm_xor_si128(p, ones);
+    __m128i ns = _mm_xor_si128(s, ones);
+    __m128i nd = _mm_xor_si128(d, ones);
+    __m128i out = zero;
+
+    if (rop & 0x01) out = _mm_or_si128(out, _mm_and_si128(_mm_and_si128(np, ns), nd));
+    if (rop & 0x02) out = _mm_or_si128(out, _mm_and_si128(_mm_and_si128(np, ns), d));
+    if (rop & 0x04) out = _mm_or_si128(out, _mm_and_si128(_mm_and_si128(np, s), nd));
+    if (rop & 0x08) out = _mm_or_si128(out, _mm_and_si128(_mm_and_si128(np, s), d));
+    if (rop & 0x10) out = _mm_or_si128(out, _mm_and_si128(_mm_and_si128(p, ns), nd));
+    if (rop & 0x20) out = _mm_or_si128(out, _mm_and_si128(_mm_and_si128(p, ns), d));
+    if (rop & 0x40) out = _mm_or_si128(out, _mm_and_si128(_mm_and_si128(p, s), nd));
+    if (rop & 0x80) out = _mm_or_si128(out, _mm_and_si128(_mm_and_si128(p, s), d));
+
+    return out;
+}
+#endif
+
+/* The body of every kernel: 16 bytes at a time with SSE2, then 4, then the rest one byte at a time. */
+static inline void 
+video_rop_row(const uint8_t rop, uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes)
+{
+    uint32_t i = 0;
+
+#ifdef __SSE2__
+    for (; (i + 16) <= bytes; i += 16)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i*)&pattern[i]);
+        __m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i d = _mm_loadu_si128((const __m128i*)&dst[i]);
+
+        _mm_storeu_si128((__m128i*)&dst[i], video_rop_eval128(rop, p, s, d));
+    }
+#endif
+
+    for (; (i + 4) <= bytes; i += 4)
+    {
+        uint32_t p, s, d, out;
+
+        /* memcpy so we don't care about alignment; it's optimised into a plain load */
+        memcpy(&p, &pattern[i], 4);
+        memcpy(&s, &src[i], 4);
+        memcpy(&d, &dst[i], 4);
+
+        out = video_rop_eval32(rop, p, s, d);
+        memcpy(&dst[i], &out, 4);
+    }
+
+    for (; i < bytes; i++)
+        dst[i] = video_rop_eval8(rop, pattern[i], src[i], dst[i]);
+}
+
+/* Some ROPs don't need to look at everything */
+
+/* BLACKNESS */
+static void 
+video_rop_row_blackness(uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes)
+{
+    memset(dst, 0x00, bytes);
+}
+
+/* WHITENESS */
+static void 
+video_rop_row_whiteness(uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes)
+{
+    memset(dst, 0xFF, bytes);
+}
+
+/* SRCCOPY */
+static void 
+video_rop_row_srccopy(uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes)
+{
+    memmove(dst, src, bytes);
+}
+
+/* PATCOPY */
+static void 
+video_rop_row_patcopy(uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes)
+{
+    memmove(dst, pattern, bytes);
+}
+
+/* Dst = Dst, nothing to do */
+static void 
+video_rop_row_nop(uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes)
+{
+
+}
+
+/* Generate one kernel for every ROP code */
+#define VIDEO_ROP_ROW_KERNEL(rop)                                                                                       \
+    static void video_rop_row_##rop(uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes)          \
+    {                                                                                                                   \
+        video_rop_row(rop, dst, src, pattern, bytes);                                                                   \
+    }
+
+#define VIDEO_ROP_ROW_KERNELS_16(h)                                                                                     \
+    VIDEO_ROP_ROW_KERNEL(0x##h##0) VIDEO_ROP_ROW_KERNEL(0x##h##1) VIDEO_ROP_ROW_KERNEL(0x##h##2) VIDEO_ROP_ROW_KERNEL(0x##h##3)   \
+    VIDEO_ROP_ROW_KERNEL(0x##h##4) VIDEO_ROP_ROW_KERNEL(0x##h##5) VIDEO_ROP_ROW_KERNEL(0x##h##6) VIDEO_ROP_ROW_KERNEL(0x##h##7)   \
+    VIDEO_ROP_ROW_KERNEL(0x##h##8) VIDEO_ROP_ROW_KERNEL(0x##h##9) VIDEO_ROP_ROW_KERNEL(0x##h##a) VIDEO_ROP_ROW_KERNEL(0x##h##b)   \
+    VIDEO_ROP_ROW_KERNEL(0x##h##c) VIDEO_ROP_ROW_KERNEL(0x##h##d) VIDEO_ROP_ROW_KERNEL(0x##h##e) VIDEO_ROP_ROW_KERNEL(0x##h##f)
+
+VIDEO_ROP_ROW_KERNELS_16(0) VIDEO_ROP_ROW_KERNELS_16(1) VIDEO_ROP_ROW_KERNELS_16(2) VIDEO_ROP_ROW_KERNELS_16(3)
+VIDEO_ROP_ROW_KERNELS_16(4) VIDEO_ROP_ROW_KERNELS_16(5) VIDEO_ROP_ROW_KERNELS_16(6) VIDEO_ROP_ROW_KERNELS_16(7)
+VIDEO_ROP_ROW_KERNELS_16(8) VIDEO_ROP_ROW_KERNELS_16(9) VIDEO_ROP_ROW_KERNELS_16(a) VIDEO_ROP_ROW_KERNELS_16(b)
+VIDEO_ROP_ROW_KERNELS_16(c) VIDEO_ROP_ROW_KERNELS_16(d) VIDEO_ROP_ROW_KERNELS_16(e) VIDEO_ROP_ROW_KERNELS_16(f)
+
+#define VIDEO_ROP_ROW_ENTRIES_16(h)                                                                                     \
+    video_rop_row_0x##h##0, video_rop_row_0x##h##1, video_rop_row_0x##h##2, video_rop_row_0x##h##3,                     \
+    video_rop_row_0x##h##4, video_rop_row_0x##h##5, video_rop_row_0x##h##6, video_rop_row_0x##h##7,                     \
+    video_rop_row_0x##h##8, video_rop_row_0x##h##9, video_rop_row_0x##h##a, video_rop_row_0x##h##b,                     \
+    video_rop_row_0x##h##c, video_rop_row_0x##h##d, video_rop_row_0x##h##e, video_rop_row_0x##h##f
+
+static const video_rop_row_kernel_t video_rop_row_kernels[256] = 
+{
+    VIDEO_ROP_ROW_ENTRIES_16(0), VIDEO_ROP_ROW_ENTRIES_16(1), VIDEO_ROP_ROW_ENTRIES_16(2), VIDEO_ROP_ROW_ENTRIES_16(3),
+    VIDEO_ROP_ROW_ENTRIES_16(4), VIDEO_ROP_ROW_ENTRIES_16(5), VIDEO_ROP_ROW_ENTRIES_16(6), VIDEO_ROP_ROW_ENTRIES_16(7),
+    VIDEO_ROP_ROW_ENTRIES_16(8), VIDEO_ROP_ROW_ENTRIES_16(9), VIDEO_ROP_ROW_ENTRIES_16(a), VIDEO_ROP_ROW_ENTRIES_16(b),
+    VIDEO_ROP_ROW_ENTRIES_16(c), VIDEO_ROP_ROW_ENTRIES_16(d), VIDEO_ROP_ROW_ENTRIES_16(e), VIDEO_ROP_ROW_ENTRIES_16(f),
+};
+
+/* 
+    Get the row kernel for a ROP. 
+    Call this once per blit, not once per row.
+*/
+video_rop_row_kernel_t 
+video_rop_get_row_kernel(uint8_t rop)
+{
+    switch (rop)
+    {
+        case 0x00:
+            return video_rop_row_blackness;
+        case 0xAA:
+            return video_rop_row_nop;
+        case 0xCC:
+            return video_rop_row_srccopy;
+        case 0xF0:
+            return video_rop_row_patcopy;
+        case 0xFF:
+            return video_rop_row_whiteness;
+        default:
+            return video_rop_row_kernels[rop];
+    }
+}
+
+/* Fill a row with a solid colour of the given bpp */
+void 
+video_rop_fill_row(uint8_t* row, uint32_t color, uint32_t bpp, uint32_t pixels)
+{
+    switch (bpp)
+    {
+        case 8:
+            memset(row, color & 0xFF, pixels);
+            break;
+        case 15:
+        case 16:
+            for (uint32_t i = 0; i < pixels; i++)
+            {
+                row[(i << 1)] = color & 0xFF;
+                row[(i << 1) + 1] = (color >> 8) & 0xFF;
+            }
+            break;
+        case 24:
+            for (uint32_t i = 0; i < pixels; i++)
+            {
+                row[(i * 3)] = color & 0xFF;
+                row[(i * 3) + 1] = (color >> 8) & 0xFF;
+                row[(i * 3) + 2] = (color >> 16) & 0xFF;
+            }
+            break;
+        case 32:
+            for (uint32_t i = 0; i < pixels; i++)
+                memcpy(&row[i << 2], &color, 4);
+            break;
+    }
+}
@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CLASS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
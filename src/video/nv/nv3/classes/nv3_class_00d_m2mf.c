@@ -19,15 +19,119 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <86box/86box.h>
 #include <86box/device.h>
 #include <86box/mem.h>
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CLASS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
+/* Bytes of each line moved at a time. The line length is up to the guest, so lines go through these a chunk at a time instead of being buffered whole */
+#define NV3_M2MF_CHUNK_SIZE     4096
+
+static uint8_t nv3_m2mf_chunk_in[NV3_M2MF_CHUNK_SIZE];
+static uint8_t nv3_m2mf_chunk_out[NV3_M2MF_CHUNK_SIZE];
+
+/* Check that an M2MF increment is one the hardware supports */
+static bool nv3_class_00d_increment_valid(uint32_t increment)
+{
+    return (increment == 1 || increment == 2 || increment == 4);
+}
+
+/* 
+    Run the transfer that was set up with the other methods. 
+    The in and out DMA objects come from the grobj (instances in the low and high halves of grobj_2), and can point to VRAM or system memory.
+    Every line is moved in chunks of NV3_M2MF_CHUNK_SIZE bytes with one bulk read and one bulk write each; the per byte path is only needed when the format spreads bytes out or gathers them.
+*/
+static void nv3_class_00d_transfer(nv3_grobj_t grobj)
+{
+    uint32_t dma_in = (grobj.grobj_2 & 0xFFFF) << 4;
+    uint32_t dma_out = ((grobj.grobj_2 >> 16) & 0xFFFF) << 4;
+    uint32_t increment_in = nv3->pgraph.m2mf.format & 0x07;
+    uint32_t increment_out = (nv3->pgraph.m2mf.format >> 8) & 0x07;
+    uint32_t line_length = nv3->pgraph.m2mf.line_length_in;
+    uint32_t offset_in = nv3->pgraph.m2mf.offset_in;
+    uint32_t offset_out = nv3->pgraph.m2mf.offset_out;
+
+    if (!line_length
+    || !nv3->pgraph.m2mf.line_count)
+        return;
+
+    if (!nv3_class_00d_increment_valid(increment_in)
+    || !nv3_class_00d_increment_valid(increment_out))
+    {
+        warning("M2MF: Invalid format 0x%08x\n", nv3->pgraph.m2mf.format);
+        nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_INVALID_DATA);
+        return;
+    }
+
+    /* How many bytes of each line actually get touched. The guest sets the length, so this can't be allowed to wrap */
+    uint64_t span_in = ((uint64_t)(line_length - 1) * increment_in) + 1;
+    uint64_t span_out = ((uint64_t)(line_length - 1) * increment_out) + 1;
+    bool packed = (increment_in == 1 && increment_out == 1);
+
+    /* A line can't be any bigger than the objects it's going between (the limit is the last valid offset) */
+    uint64_t limit_in = (uint64_t)nv3_ramin_read32(dma_in + 0x04, nv3) + 1;
+    uint64_t limit_out = (uint64_t)nv3_ramin_read32(dma_out + 0x04, nv3) + 1;
+
+    if (span_in > limit_in
+    || span_out > limit_out
+    || span_in > UINT32_MAX
+    || span_out > UINT32_MAX)
+    {
+        warning("M2MF: Line of 0x%08x bytes doesn't fit in the DMA objects\n", line_length);
+        nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_INVALID_DATA);
+        return;
+    }
+
+    /* Bytes of the line per chunk, so that the widest increment still fits in the chunk buffers */
+    uint32_t chunk_length = NV3_M2MF_CHUNK_SIZE / ((increment_in > increment_out) ? increment_in : increment_out);
+    uint8_t* chunk_out = (packed) ? nv3_m2mf_chunk_in : nv3_m2mf_chunk_out;
+
+    nv_log("M2MF: %d lines of 0x%08x bytes, 0x%08x (pitch 0x%08x) -> 0x%08x (pitch 0x%08x), format 0x%08x\n", nv3->pgraph.m2mf.line_count, 
+        line_length, offset_in, nv3->pgraph.m2mf.pitch_in, offset_out, nv3->pgraph.m2mf.pitch_out, nv3->pgraph.m2mf.format);
+
+    for (uint32_t line = 0; line < nv3->pgraph.m2mf.line_count; line++)
+    {
+        for (uint32_t start = 0; start < line_length; start += chunk_length)
+        {
+            uint32_t length = line_length - start;
+
+            if (length > chunk_length)
+                length = chunk_length;
+
+            uint32_t chunk_offset_in = offset_in + (start * increment_in);
+            uint32_t chunk_offset_out = offset_out + (start * increment_out);
+            uint32_t chunk_span_in = ((length - 1) * increment_in) + 1;
+            uint32_t chunk_span_out = ((length - 1) * increment_out) + 1;
+
+            if (!nv3_pgraph_dma_read(dma_in, chunk_offset_in, nv3_m2mf_chunk_in, chunk_span_in))
+                return;
+
+            if (!packed)
+            {
+                /* The bytes in between the ones we write stay as they are */
+                if (!nv3_pgraph_dma_read(dma_out, chunk_offset_out, chunk_out, chunk_span_out))
+                    return;
+
+                for (uint32_t i = 0; i < length; i++)
+                    chunk_out[i * increment_out] = nv3_m2mf_chunk_in[i * increment_in];
+            }
+
+            if (!nv3_pgraph_dma_write(dma_out, chunk_offset_out, chunk_out, chunk_span_out))
+                return;
+        }
+
+        /* The pitches are signed, so this can go backwards too */
+        offset_in += nv3->pgraph.m2mf.pitch_in;
+        offset_out += nv3->pgraph.m2mf.pitch_out;
+    }
+}
+
 void nv3_class_00d_method(uint32_t param, uint32_t method_id, nv3_ramin_context_t context, nv3_grobj_t grobj)
 {
     switch (method_id)
@@ -66,7 +170,8 @@ void nv3_class_00d_method(uint32_t param, uint32_t method_id, nv3_ramin_context_
             {
                 nv_log("WARNING: M2MF notification with notify_pending already set. param=0x%08x, method=0x%04x, grobj=0x%08x 0x%08x 0x%08x 0x%08x\n");
                 nv_log("IF THIS BUILD WAS COMPILED WITH NV_LOG_ENABLE_ULTRA, YOU SHOULD SEE A CONTEXT BELOW");
-                nv3_debug_ramin_print_context_info(param, context);
+                if (nv_log_enabled(NV_LOG_LEVEL_VERBOSE, NV_LOG_PRAMIN))
+                    nv3_debug_ramin_print_context_info(param, context);
                 nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_DOUBLE_NOTIFY);
                 
                 // disable
@@ -76,7 +181,9 @@ void nv3_class_00d_method(uint32_t param, uint32_t method_id, nv3_ramin_context_
                 return; 
             }
 
-            nv_log("Method Execution: TODO: ACTUALLY IMPLEMENT M2MF!!!!");
+            /* Writing the notifier is what starts the transfer. nv3_notify_if_needed sends the notification once we're done */
+            nv3_class_00d_transfer(grobj);
+
             // set a notify as pending.
             nv3->pgraph.notifier = param; 
             nv3->pgraph.notify_pending = true; 
@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CLASS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -32,6 +33,54 @@ void nv3_class_00e_method(uint32_t param, uint32_t method_id, nv3_ramin_context_
 {
     switch (method_id)
     {
+        case NV3_SCALED_IMAGE_CLIP_POINT:
+            nv3->pgraph.scaled_image_from_memory.clip_0.x = (param & 0xFFFF);
+            nv3->pgraph.scaled_image_from_memory.clip_0.y = (param >> 16);
+            nv_log("Method Execution: Scaled Image Clip Point=%d,%d\n", param & 0xFFFF, param >> 16);
+            break;
+        case NV3_SCALED_IMAGE_CLIP_SIZE:
+            nv3->pgraph.scaled_image_from_memory.clip_1.w = (param & 0xFFFF);
+            nv3->pgraph.scaled_image_from_memory.clip_1.h = (param >> 16);
+            nv_log("Method Execution: Scaled Image Clip Size=%d,%d\n", param & 0xFFFF, param >> 16);
+            break;
+        case NV3_SCALED_IMAGE_OUT_POINT:
+            nv3->pgraph.scaled_image_from_memory.rectangle_out_0.x = (param & 0xFFFF);
+            nv3->pgraph.scaled_image_from_memory.rectangle_out_0.y = (param >> 16);
+            nv_log("Method Execution: Scaled Image Out Point=%d,%d\n", param & 0xFFFF, param >> 16);
+            break;
+        case NV3_SCALED_IMAGE_OUT_SIZE:
+            nv3->pgraph.scaled_image_from_memory.rectangle_out_1.w = (param & 0xFFFF);
+            nv3->pgraph.scaled_image_from_memory.rectangle_out_1.h = (param >> 16);
+            nv_log("Method Execution: Scaled Image Out Size=%d,%d\n", param & 0xFFFF, param >> 16);
+            break;
+        case NV3_SCALED_IMAGE_DELTA_DU_DX:
+            nv3->pgraph.scaled_image_from_memory.delta_du_dx = param;
+            nv_log("Method Execution: Scaled Image du/dx=0x%08x\n", param);
+            break;
+        case NV3_SCALED_IMAGE_DELTA_DV_DY:
+            nv3->pgraph.scaled_image_from_memory.delta_dv_dy = param;
+            nv_log("Method Execution: Scaled Image dv/dy=0x%08x\n", param);
+            break;
+        case NV3_SCALED_IMAGE_SIZE:
+            nv3->pgraph.scaled_image_from_memory.size.w = (param & 0xFFFF);
+            nv3->pgraph.scaled_image_from_memory.size.h = (param >> 16);
+            nv_log("Method Execution: Scaled Image Size=%d,%d\n", param & 0xFFFF, param >> 16);
+            break;
+        case NV3_SCALED_IMAGE_FORMAT:
+            /* Pitch and filter */
+            nv3->pgraph.scaled_image_from_memory.pitch = param;
+            nv_log("Method Execution: Scaled Image Format=0x%08x\n", param);
+            break;
+        case NV3_SCALED_IMAGE_OFFSET:
+            nv3->pgraph.scaled_image_from_memory.offset = param;
+            nv_log("Method Execution: Scaled Image Offset=0x%08x\n", param);
+            break;
+        case NV3_SCALED_IMAGE_POINT:
+            nv3->pgraph.scaled_image_from_memory.point = param;
+            nv_log("Method Execution: Scaled Image Point=0x%08x (12.4)\n", param);
+            /* This is the last method, so draw it */
+            nv3_render_scaled_image_from_memory(grobj);
+            break;
         default:
             warning("%s: Invalid or unimplemented method 0x%04x\n", nv3_class_names[context.class_id & 0x1F], method_id);
             nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_SOFTWARE_METHOD_PENDING);
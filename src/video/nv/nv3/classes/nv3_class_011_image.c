@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CLASS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -46,8 +47,9 @@ void nv3_class_011_method(uint32_t param, uint32_t method_id, nv3_ramin_context_
         case NV3_IMAGE_SIZE_IN:
             nv3->pgraph.image.size_in.w = (param & 0xFFFF);
             nv3->pgraph.image.size_in.h = (param >> 16);
-            nv3->pgraph.image_current_position = nv3->pgraph.image.point;
             nv_log("Method Execution: Image SizeIn=%d,%d\n", nv3->pgraph.image.size_in.w, nv3->pgraph.image.size_in.h);
+            /* Pixels start arriving after this */
+            nv3_render_image_begin(nv3_pgraph_class11_image, nv3->pgraph.image.point, nv3->pgraph.image.size, nv3->pgraph.image.size_in);
             break;
         default:
             if (method_id >= NV3_IMAGE_COLOR_START && method_id <= NV3_IMAGE_COLOR_END)
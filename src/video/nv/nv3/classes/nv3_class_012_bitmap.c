@@ -26,6 +26,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CLASS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -33,9 +34,42 @@ void nv3_class_012_method(uint32_t param, uint32_t method_id, nv3_ramin_context_
 {
     switch (method_id)
     {
+        case NV3_BITMAP_COLOR_0:
+            nv3->pgraph.bitmap.color_0 = param;
+            nv_log("Method Execution: Bitmap Color0 0x%08x\n", param);
+            break;
+        case NV3_BITMAP_COLOR_1:
+            nv3->pgraph.bitmap.color_1 = param;
+            nv_log("Method Execution: Bitmap Color1 0x%08x\n", param);
+            break;
+        case NV3_BITMAP_START_POSITION:
+            nv3->pgraph.bitmap.point.x = (param & 0xFFFF);
+            nv3->pgraph.bitmap.point.y = (param >> 16);
+            nv_log("Method Execution: Bitmap Point=%d,%d\n", nv3->pgraph.bitmap.point.x, nv3->pgraph.bitmap.point.y);
+            break;
+        case NV3_BITMAP_SIZE:
+            nv3->pgraph.bitmap.size.w = (param & 0xFFFF);
+            nv3->pgraph.bitmap.size.h = (param >> 16);
+            nv_log("Method Execution: Bitmap Size (Clip)=%d,%d\n", nv3->pgraph.bitmap.size.w, nv3->pgraph.bitmap.size.h);
+            break;
+        case NV3_BITMAP_SIZE_IN:
+            nv3->pgraph.bitmap.size_in.w = (param & 0xFFFF);
+            nv3->pgraph.bitmap.size_in.h = (param >> 16);
+            nv_log("Method Execution: Bitmap SizeIn=%d,%d\n", nv3->pgraph.bitmap.size_in.w, nv3->pgraph.bitmap.size_in.h);
+            /* Bits start arriving after this */
+            nv3_render_image_begin(nv3_pgraph_class12_bitmap, nv3->pgraph.bitmap.point, nv3->pgraph.bitmap.size, nv3->pgraph.bitmap.size_in);
+            break;
         default:
-            warning("%s: Invalid or unimplemented method 0x%04x\n", nv3_class_names[context.class_id & 0x1F], method_id);
-            nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_SOFTWARE_METHOD_PENDING);
+            if (method_id >= NV3_BITMAP_MONOCHROME_START && method_id <= NV3_BITMAP_MONOCHROME_END)
+            {
+                nv_log("Method Execution: Bitmap Monochrome%d 0x%08x\n", (method_id - NV3_BITMAP_MONOCHROME_START) >> 2, param);
+                nv3_render_blit_bitmap(param, grobj);
+            }
+            else
+            {
+                warning("%s: Invalid or unimplemented method 0x%04x\n", nv3_class_names[context.class_id & 0x1F], method_id);
+                nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_SOFTWARE_METHOD_PENDING);
+            }
             return;
     }
 }
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CLASS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -32,9 +33,46 @@ void nv3_class_015_method(uint32_t param, uint32_t method_id, nv3_ramin_context_
 {
     switch (method_id)
     {
+        case NV3_STRETCHED_IMAGE_SIZE_IN:
+            nv3->pgraph.stretched_image_from_cpu.size_in.w = (param & 0xFFFF);
+            nv3->pgraph.stretched_image_from_cpu.size_in.h = (param >> 16);
+            nv_log("Method Execution: Stretched Image SizeIn=%d,%d\n", param & 0xFFFF, param >> 16);
+            break;
+        case NV3_STRETCHED_IMAGE_DELTA_DX_DU:
+            nv3->pgraph.stretched_image_from_cpu.delta_dx_du = param;
+            nv_log("Method Execution: Stretched Image dx/du=0x%08x\n", param);
+            break;
+        case NV3_STRETCHED_IMAGE_DELTA_DY_DV:
+            nv3->pgraph.stretched_image_from_cpu.delta_dy_dv = param;
+            nv_log("Method Execution: Stretched Image dy/dv=0x%08x\n", param);
+            break;
+        case NV3_STRETCHED_IMAGE_CLIP_POINT:
+            nv3->pgraph.stretched_image_from_cpu.clip_0.x = (param & 0xFFFF);
+            nv3->pgraph.stretched_image_from_cpu.clip_0.y = (param >> 16);
+            nv_log("Method Execution: Stretched Image Clip Point=%d,%d\n", param & 0xFFFF, param >> 16);
+            break;
+        case NV3_STRETCHED_IMAGE_CLIP_SIZE:
+            nv3->pgraph.stretched_image_from_cpu.clip_1.w = (param & 0xFFFF);
+            nv3->pgraph.stretched_image_from_cpu.clip_1.h = (param >> 16);
+            nv_log("Method Execution: Stretched Image Clip Size=%d,%d\n", param & 0xFFFF, param >> 16);
+            break;
+        case NV3_STRETCHED_IMAGE_POINT_12D4:
+            nv3->pgraph.stretched_image_from_cpu.point12d4 = param;
+            nv_log("Method Execution: Stretched Image Point=0x%08x (12.4)\n", param);
+            /* Pixels start arriving after this */
+            nv3_render_stretched_image_begin(grobj);
+            break;
         default:
-            warning("%s: Invalid or unimplemented method 0x%04x\n", nv3_class_names[context.class_id & 0x1F], method_id);
-            nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_SOFTWARE_METHOD_PENDING);
+            if (method_id >= NV3_STRETCHED_IMAGE_COLOR_START && method_id <= NV3_STRETCHED_IMAGE_COLOR_END)
+            {
+                nv_log_verbose_only("Method Execution: Stretched Image Colour%d 0x%08x\n", (method_id - NV3_STRETCHED_IMAGE_COLOR_START) >> 2, param);
+                nv3_render_stretched_image_push(param, grobj);
+            }
+            else
+            {
+                warning("%s: Invalid or unimplemented method 0x%04x\n", nv3_class_names[context.class_id & 0x1F], method_id);
+                nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_SOFTWARE_METHOD_PENDING);
+            }
             return;
     }
 }
\ No newline at end of file
@@ -19,12 +19,14 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <86box/86box.h>
 #include <86box/device.h>
 #include <86box/mem.h>
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CLASS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -32,9 +34,82 @@ void nv3_class_017_method(uint32_t param, uint32_t method_id, nv3_ramin_context_
 {
     switch (method_id)
     {
+        case NV3_D3D5_TEXTURE_OFFSET:
+            nv3->d3d5.texture_offset = param;
+            nv_log("Method Execution: D3D5 Texture Offset=0x%08x\n", param);
+            break;
+        case NV3_D3D5_TEXTURE_FORMAT:
+            nv3->d3d5.texture_format = param;
+            nv_log("Method Execution: D3D5 Texture Format=0x%08x\n", param);
+            break;
+        case NV3_D3D5_TEXTURE_FILTER:
+            nv3->d3d5.texture_filter = param;
+            break;
+        case NV3_D3D5_FOG_COLOR:
+            nv3->d3d5.fog_color = param;
+            break;
+        case NV3_D3D5_CONTROL_OUT:
+            nv3->d3d5.control_out = param;
+            nv_log("Method Execution: D3D5 Control Out=0x%08x\n", param);
+            break;
+        case NV3_D3D5_ALPHA_CONTROL:
+            nv3->d3d5.alpha_control = param;
+            break;
         default:
+            /* Check for a vertex */
+            if (method_id >= NV3_D3D5_VERTEX_START && method_id <= NV3_D3D5_VERTEX_END)
+            {
+                uint32_t index = (method_id - NV3_D3D5_VERTEX_START) / NV3_D3D5_VERTEX_SIZE;
+                nv3_d3d5_vertex_t* vertex = &nv3->d3d5.vertices[index];
+                float param_float = 0.0f;
+
+                // The coordinates are IEEE floats
+                memcpy(&param_float, &param, sizeof(float));
+
+                switch ((method_id - NV3_D3D5_VERTEX_START) % NV3_D3D5_VERTEX_SIZE)
+                {
+                    case NV3_D3D5_VERTEX_SPECULAR:
+                        vertex->specular = param;
+                        break;
+                    case NV3_D3D5_VERTEX_COLOR:
+                        vertex->color = param;
+                        break;
+                    case NV3_D3D5_VERTEX_X:
+                        vertex->x = param_float;
+                        break;
+                    case NV3_D3D5_VERTEX_Y:
+                        vertex->y = param_float;
+                        break;
+                    case NV3_D3D5_VERTEX_Z:
+                        vertex->z = param_float;
+                        break;
+                    case NV3_D3D5_VERTEX_M:
+                        vertex->m = param_float;
+                        break;
+                    case NV3_D3D5_VERTEX_U:
+                        vertex->u = param_float;
+                        break;
+                    case NV3_D3D5_VERTEX_V:
+                        vertex->v = param_float;
+
+                        /* 
+                            V is the last word of a vertex, so once the third vertex of a triangle is complete, draw it.
+                            This treats the vertices as a triangle list, which is what the drivers seem to submit.
+                        */
+                        if ((index % 3) == 2)
+                        {
+                            nv_log("Method Execution: D3D5 Triangle %d,%d,%d\n", index - 2, index - 1, index);
+                            nv3_render_d3d5_triangle(grobj, index - 2, index - 1, index);
+                        }
+
+                        break;
+                }
+
+                return;
+            }
+
             warning("%s: Invalid or unimplemented method 0x%04x\n", nv3_class_names[context.class_id & 0x1F], method_id);
             nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_SOFTWARE_METHOD_PENDING);
             return;
     }
-}
\ No newline at end of file
+}
@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CLASS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -34,9 +35,38 @@ void nv3_class_018_method(uint32_t param, uint32_t method_id, nv3_ramin_context_
 {
     switch (method_id)
     {
+        case NV3_POINT_ZETA_CONTROL_OUT:
+            nv3->d3d5.point_control_out = param;
+            break;
+        case NV3_POINT_ZETA_ALPHA_CONTROL:
+            nv3->d3d5.point_alpha_control = param;
+            break;
+        case NV3_POINT_ZETA_POINT:
+            nv3->pgraph.point_zeta_buffer.point.x = param & 0xFFFF;
+            nv3->pgraph.point_zeta_buffer.point.y = (param >> 16) & 0xFFFF;
+            nv_log("Method Execution: Point Zeta Position=%d,%d\n", nv3->pgraph.point_zeta_buffer.point.x, nv3->pgraph.point_zeta_buffer.point.y);
+            break;
         default:
+            /* Colour and zeta pairs. Each one is drawn at the point, then the point moves one to the right (assumption) */
+            if (method_id >= NV3_POINT_ZETA_COLOR_ZETA_START && method_id <= NV3_POINT_ZETA_COLOR_ZETA_END)
+            {
+                uint32_t index = (method_id - NV3_POINT_ZETA_COLOR_ZETA_START) >> 3;
+
+                if (method_id & 0x04)
+                {
+                    nv3->pgraph.point_zeta_buffer.zeta[index].zeta = param;
+
+                    nv3_render_d3d5_point(grobj, nv3->pgraph.point_zeta_buffer.point, nv3->d3d5.point_color[index], param);
+                    nv3->pgraph.point_zeta_buffer.point.x++;
+                }
+                else
+                    nv3->d3d5.point_color[index] = param;
+
+                return;
+            }
+
             warning("%s: Invalid or unimplemented method 0x%04x\n", nv3_class_names[context.class_id & 0x1F], method_id);
             nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_SOFTWARE_METHOD_PENDING);
             return;
     }
-}
\ No newline at end of file
+}
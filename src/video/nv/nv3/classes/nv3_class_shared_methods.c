@@ -26,6 +26,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CLASS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -45,7 +46,8 @@ void nv3_generic_method(uint32_t param, uint32_t method_id, nv3_ramin_context_t
             {
                 nv_log("Executed method NV3_SET_NOTIFY with nv3->pgraph.notify_pending already set. param=0x%08x, method=0x%04x, grobj=0x%08x 0x%08x 0x%08x 0x%08x\n");
                 nv_log("IF THIS IS A DEBUG BUILD, YOU SHOULD SEE A CONTEXT BELOW");
-                nv3_debug_ramin_print_context_info(param, context);
+                if (nv_log_enabled(NV_LOG_LEVEL_VERBOSE, NV_LOG_PRAMIN))
+                    nv3_debug_ramin_print_context_info(param, context);
                 nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_DOUBLE_NOTIFY);
                 
                 // disable
@@ -73,6 +75,9 @@ void nv3_notify_if_needed(uint32_t name, uint32_t method_id, nv3_ramin_context_t
     if (!nv3->pgraph.notify_pending)
         return; 
 
+    /* The notification says everything is done, so make sure the render threads really are */
+    nv3_render_d3d5_wait_idle();
+
     uint32_t current_notification_object = nv3->pgraph.notifier;
     uint32_t notification_type = ((current_notification_object >> NV3_PGRAPH_NOTIFY_REQUEST_TYPE) & 0x07);
 
@@ -86,7 +91,7 @@ void nv3_notify_if_needed(uint32_t name, uint32_t method_id, nv3_ramin_context_t
         
     // set up the NvNotification structure
     nv3_notification_t notify = {0}; 
-    notify.nanoseconds = nv3->ptimer.time;
+    notify.nanoseconds = nv3_ptimer_get_time();
     notify.status = NV3_NOTIFICATION_STATUS_DONE_OK; // it should be fine to just signal that it's ok
     
     // these are only nonzero when there is an error
@@ -514,6 +514,9 @@ void nv3_recalc_timings(svga_t* svga)
     /* Turn off override if we are in VGA mode */
     svga->override = !(pixel_mode == NV3_CRTC_REGISTER_PIXELMODE_VGA);
 
+    /* The mode might have changed, so redraw everything at the next vsync */
+    nv3_render_mark_full();
+
     /* NOTE: The RIVA 128 draws in a way almost completely separate to any other 86Box GPU.
     
     Basically, we only blit to buffer32 when something changes and we don't even bother using a timer. We only render when there is something to actually render.
@@ -740,6 +743,10 @@ void nv3_svga_out(uint16_t addr, uint8_t val, void* priv)
                 case NV3_CRTC_REGISTER_RMA:
                     nv3->pbus.rma.mode = val & NV3_CRTC_REGISTER_RMA_MODE_MAX;
                     break;
+                case NV3_CRTC_REGISTER_CURSOR_ADDR0:
+                case NV3_CRTC_REGISTER_CURSOR_ADDR1:
+                    nv3_render_cursor_set_address();
+                    break;
                 case NV3_CRTC_REGISTER_I2C_GPIO:
                     uint8_t scl = !!(val & 0x20);
                     uint8_t sda = !!(val & 0x10);
@@ -771,68 +778,103 @@ void nv3_svga_out(uint16_t addr, uint8_t val, void* priv)
 
 }
 
-/* DFB, sets up a dumb framebuffer */
+/* 
+    DFB, sets up a dumb framebuffer
+    
+    Stores only mark VRAM dirty. Whatever part of the screen they hit is converted once at the next vsync (or by the SVGA renderer when we aren't
+    drawing the screen ourselves), instead of on every store.
+*/
+
+/* A store that is not inside VRAM goes through the byte path so that it wraps like the hardware does */
+static inline bool nv3_dfb_fits(uint32_t addr, uint32_t size)
+{
+    return (addr + size - 1) <= nv3->nvbase.svga.vram_mask;
+}
+
+/* Everything that has to happen after the CPU writes to VRAM */
+static inline void nv3_dfb_written(uint32_t addr, uint32_t size)
+{
+    // The top of VRAM is RAMIN
+    if ((addr + size - 1) >= nv3->ramht.cache_vram_floor)
+        nv3_ramht_cache_invalidate();
+
+    nv3->nvbase.svga.changedvram[addr >> 12] = nv3->nvbase.svga.monitor->mon_changeframecount;
+    nv3->nvbase.svga.changedvram[(addr + size - 1) >> 12] = nv3->nvbase.svga.monitor->mon_changeframecount;
+    nv3_render_mark_vram_dirty(addr, size);
+}
+
 uint8_t nv3_dfb_read8(uint32_t addr, void* priv)
 {
     addr &= (nv3->nvbase.svga.vram_mask);
+
+    // The CPU has to see what the render threads drew
+    nv3_render_d3d5_wait_idle();
     return nv3->nvbase.svga.vram[addr];
 }
 
 uint16_t nv3_dfb_read16(uint32_t addr, void* priv)
 {
     addr &= (nv3->nvbase.svga.vram_mask);
-    return (nv3->nvbase.svga.vram[addr + 1] << 8) | nv3->nvbase.svga.vram[addr];
+    nv3_render_d3d5_wait_idle();
+
+    if (!nv3_dfb_fits(addr, 2))
+        return nv3->nvbase.svga.vram[addr] | (nv3->nvbase.svga.vram[(addr + 1) & nv3->nvbase.svga.vram_mask] << 8);
+
+    return *(uint16_t*)&nv3->nvbase.svga.vram[addr];
 }
 
 uint32_t nv3_dfb_read32(uint32_t addr, void* priv)
 {
     addr &= (nv3->nvbase.svga.vram_mask);
-    return (nv3->nvbase.svga.vram[addr + 3] << 24) | (nv3->nvbase.svga.vram[addr + 2] << 16) +
-    (nv3->nvbase.svga.vram[addr + 1] << 8) | nv3->nvbase.svga.vram[addr];
+    nv3_render_d3d5_wait_idle();
+
+    if (!nv3_dfb_fits(addr, 4))
+        return nv3_dfb_read16(addr, priv) | (nv3_dfb_read16(addr + 2, priv) << 16);
+
+    return *(uint32_t*)&nv3->nvbase.svga.vram[addr];
 }
 
 void nv3_dfb_write8(uint32_t addr, uint8_t val, void* priv)
 {
     addr &= (nv3->nvbase.svga.vram_mask);
+    nv3_render_d3d5_wait_idle();
+
     nv3->nvbase.svga.vram[addr] = val;
-    nv3->nvbase.svga.changedvram[addr >> 12] = val;
-    nv3_render_current_bpp_dfb_8(addr);
+    nv3_dfb_written(addr, 1);
 }
 
 void nv3_dfb_write16(uint32_t addr, uint16_t val, void* priv)
 {
     addr &= (nv3->nvbase.svga.vram_mask);
-    nv3->nvbase.svga.vram[addr + 1] = (val >> 8) & 0xFF;
-    nv3->nvbase.svga.vram[addr] = (val) & 0xFF;
-    nv3->nvbase.svga.changedvram[addr >> 12] = val;
-    nv3_render_current_bpp_dfb_16(addr);
 
+    if (!nv3_dfb_fits(addr, 2))
+    {
+        nv3_dfb_write8(addr, val & 0xFF, priv);
+        nv3_dfb_write8(addr + 1, (val >> 8) & 0xFF, priv);
+        return;
+    }
+
+    nv3_render_d3d5_wait_idle();
+
+    *(uint16_t*)&nv3->nvbase.svga.vram[addr] = val;
+    nv3_dfb_written(addr, 2);
 }
 
 void nv3_dfb_write32(uint32_t addr, uint32_t val, void* priv)
 {
     addr &= (nv3->nvbase.svga.vram_mask);
-    nv3->nvbase.svga.vram[addr + 3] = (val >> 24) & 0xFF;
-    nv3->nvbase.svga.vram[addr + 2] = (val >> 16) & 0xFF;
-    nv3->nvbase.svga.vram[addr + 1] = (val >> 8) & 0xFF;
-    nv3->nvbase.svga.vram[addr] = (val) & 0xFF;
-    nv3->nvbase.svga.changedvram[addr >> 12] = val;
-
-    nv3_render_current_bpp_dfb_32(addr);
 
-}
+    if (!nv3_dfb_fits(addr, 4))
+    {
+        nv3_dfb_write16(addr, val & 0xFFFF, priv);
+        nv3_dfb_write16(addr + 2, (val >> 16) & 0xFFFF, priv);
+        return;
+    }
 
-/* Cursor shit */
-void nv3_draw_cursor(svga_t* svga, int32_t drawline)
-{
-    // sanity check
-    if (!nv3)
-        return; 
-    
-    // On windows, this shows up using NV_IMAGE_IN_MEMORY.
-    // Do we need to emulate it?
+    nv3_render_d3d5_wait_idle();
 
-    nv_log("nv3_draw_cursor drawline=0x%04x", drawline);
+    *(uint32_t*)&nv3->nvbase.svga.vram[addr] = val;
+    nv3_dfb_written(addr, 4);
 }
 
 // MMIO 0x110000->0x111FFF is mapped to a mirror of the VBIOS.
@@ -1077,6 +1119,10 @@ void* nv3_init(const device_t *info)
 #ifdef ENABLE_NV_LOG
     // Allows nv_log to be used for multiple nvidia devices
     nv_log_set_device(nv3->nvbase.log); 
+
+#ifndef RELEASE_BUILD
+    nv_log_configure(device_get_config_int("nv_debug_log_level"), device_get_config_int("nv_debug_log_mask"));
+#endif
 #endif   
     nv_log("Initialising core\n");
 
@@ -1117,7 +1163,7 @@ void* nv3_init(const device_t *info)
         pci_add_card(PCI_ADD_NORMAL, nv3_pci_read, nv3_pci_write, NULL, &nv3->nvbase.pci_slot);
 
         svga_init(&nv3_device_pci, &nv3->nvbase.svga, nv3, nv3->nvbase.vram_amount, 
-        nv3_recalc_timings, nv3_svga_in, nv3_svga_out, nv3_draw_cursor, NULL);
+        nv3_recalc_timings, nv3_svga_in, nv3_svga_out, NULL, NULL);
 
         if (nv3->nvbase.gpu_revision == NV3_PCI_CFG_REVISION_C00)
             video_inform(VIDEO_FLAG_TYPE_SPECIAL, &timing_nv3t_pci);
@@ -1132,7 +1178,7 @@ void* nv3_init(const device_t *info)
         pci_add_card(PCI_ADD_AGP, nv3_pci_read, nv3_pci_write, NULL, &nv3->nvbase.pci_slot);
 
         svga_init(&nv3_device_agp, &nv3->nvbase.svga, nv3, nv3->nvbase.vram_amount, 
-        nv3_recalc_timings, nv3_svga_in, nv3_svga_out, nv3_draw_cursor, NULL);
+        nv3_recalc_timings, nv3_svga_in, nv3_svga_out, NULL, NULL);
 
         if (nv3->nvbase.gpu_revision == NV3_PCI_CFG_REVISION_C00)
             video_inform(VIDEO_FLAG_TYPE_SPECIAL, &timing_nv3t_agp);
@@ -1156,6 +1202,7 @@ void* nv3_init(const device_t *info)
 
     nv3_pextdev_init();             // Initialise Straps
     nv3_pmc_init();                 // Initialise Master Control
+    nv3_pme_init();                 // Initialise Mediaport Engine
     nv3_pbus_init();                // Initialise Bus (the 128 part of riva)
     nv3_pfb_init();                 // Initialise Framebuffer Interface
     nv3_pramdac_init();             // Initialise RAMDAC (CLUT, final pixel presentation etc)
@@ -1163,11 +1210,22 @@ void* nv3_init(const device_t *info)
     nv3_pgraph_init();              // Initialise accelerated graphics engine
     nv3_ptimer_init();              // Initialise programmable interval timer
     nv3_pvideo_init();              // Initialise video overlay engine
+    nv3_render_d3d5_init(device_get_config_int("pgraph_threads"));  // Start the D3D5 render threads
+
+    /* PGRAPH only draws into VRAM; what changed gets sent to the monitor once per frame at vsync */
+    nv3->nvbase.svga.vsync_callback = nv3_render_present;
+    nv3_render_mark_full();
 
     nv_log("Initialising I2C...");
     nv3->nvbase.i2c = i2c_gpio_init("nv3_i2c");
     nv3->nvbase.ddc = ddc_init(i2c_gpio_get_bus(nv3->nvbase.i2c));
 
+#ifndef RELEASE_BUILD
+    // Benchmark a capture, then start capturing if we were asked to
+    nv3_capture_replay(device_get_config_string("nv_debug_replay_file"));
+    nv3_capture_init(device_get_config_string("nv_debug_capture_file"), device_get_config_int("nv_debug_capture_frames"));
+#endif
+
     return nv3;
 }
 
@@ -1197,6 +1255,9 @@ void nv3_close(void* priv)
     nv_log_set_device(NULL);
 #endif
 
+    // Finish any capture that was still going
+    nv3_capture_close();
+
     // Shut down I2C and the DDC
     ddc_close(nv3->nvbase.ddc);
     i2c_gpio_close(nv3->nvbase.i2c);
@@ -1204,6 +1265,15 @@ void nv3_close(void* priv)
     // Destroy the Rivatimers. (It doesn't matter if they are running.)
     rivatimer_destroy(nv3->nvbase.pixel_clock_timer);
     rivatimer_destroy(nv3->nvbase.memory_clock_timer);
+
+    if (nv3->ptimer.alarm_timer)
+        rivatimer_destroy(nv3->ptimer.alarm_timer);
+
+    // Stop the CACHE1 puller
+    timer_disable(&nv3->pfifo.cache1_puller_timer);
+
+    // Stop the D3D5 render threads
+    nv3_render_d3d5_close();
     
     // Shut down SVGA
     svga_close(&nv3->nvbase.svga);
@@ -49,6 +49,47 @@ nv_register_t* nv_get_register(uint32_t address, nv_register_t* register_list, u
     return NULL;
 }
 
+// Builds a register table from a register list, so registers can be found without searching the list
+void nv_register_table_build(nv_register_table_t* table, nv_register_t* register_list, uint32_t num_regs)
+{
+    uint32_t lowest = 0xFFFFFFFF, highest = 0;
+
+    // Only needs to be done once, the lists never change
+    if (table->lookup)
+        return;
+
+    for (uint32_t reg_num = 0; reg_num < num_regs; reg_num++)
+    {
+        if (register_list[reg_num].address == NV_REG_LIST_END)
+            break;
+
+        uint32_t address = register_list[reg_num].address;
+
+        if (address < lowest) lowest = address;
+        if (address > highest) highest = address;
+    }
+
+    // Empty list
+    if (lowest > highest)
+        return;
+
+    table->start = lowest & ~3;
+    table->num_entries = ((highest - table->start) >> 2) + 1;
+    table->lookup = calloc(table->num_entries, sizeof(nv_register_t*));
+
+    for (uint32_t reg_num = 0; reg_num < num_regs; reg_num++)
+    {
+        if (register_list[reg_num].address == NV_REG_LIST_END)
+            break;
+
+        uint32_t index = (register_list[reg_num].address - table->start) >> 2;
+
+        // If a register is in the list twice, the first one wins, same as nv_get_register
+        if (!table->lookup[index])
+            table->lookup[index] = &register_list[reg_num];
+    }
+}
+
 // Arbitrates an MMIO read
 uint32_t nv3_mmio_arbitrate_read(uint32_t address)
 {
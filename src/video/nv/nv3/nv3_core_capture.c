@@ -0,0 +1,339 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          NV3 PGRAPH command stream capture and replay
+ *
+ *          A capture is a snapshot of VRAM and the PFIFO/PGRAPH state, and then every write that went into CACHE1 for a number of frames.
+ *          Replaying one runs the same writes through PFIFO and PGRAPH as fast as they will go, without the guest, so any change to the
+ *          renderer can be timed against exactly the same work every time. See vid_nv3.h for the file format.
+ *          A replay can run at device init (nv_debug_replay_file), or on its own with the nv3_replay tool (NV3_REPLAY in CMake).
+ *
+ * Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+ *
+ *          Copyright 2024-2025 starfrost
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/pci.h>
+#include <86box/plat.h>
+#include <86box/rom.h>
+#include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_CORE
+#include <86box/nv/vid_nv.h>
+#include <86box/nv/vid_nv3.h>
+
+// Write out the records we have built up
+static void nv3_capture_flush(void)
+{
+    nv3_capture_t* capture = &nv3->capture;
+
+    if (!capture->num_buffered)
+        return;
+
+    if (fwrite(capture->buffer, sizeof(nv3_capture_record_t), capture->num_buffered, capture->file) != capture->num_buffered)
+    {
+        warning("NV3 capture: Failed to write records, stopping the capture\n");
+        capture->num_buffered = 0;
+        nv3_capture_close();
+        return;
+    }
+
+    capture->num_buffered = 0;
+}
+
+// Get ready to capture. It actually starts at the next vsync in an accelerated mode, so that there is something worth capturing
+void nv3_capture_init(const char* path, uint32_t frames)
+{
+    nv3_capture_t* capture = &nv3->capture;
+
+    if (!path
+    || !path[0]
+    || !frames)
+        return;
+
+    capture->file = plat_fopen(path, "wb");
+
+    if (!capture->file)
+    {
+        warning("NV3 capture: Couldn't open %s\n", path);
+        return;
+    }
+
+    capture->armed = true;
+    capture->frames_left = frames;
+    nv_log("Capturing %d frames of PGRAPH commands to %s\n", frames, path);
+}
+
+// Record a write into CACHE1
+void nv3_capture_push(uint32_t addr, uint32_t param)
+{
+    nv3_capture_t* capture = &nv3->capture;
+
+    if (!capture->recording)
+        return;
+
+    capture->buffer[capture->num_buffered].address = addr;
+    capture->buffer[capture->num_buffered].param = param;
+
+    if (++capture->num_buffered >= NV3_CAPTURE_BUFFER_SIZE)
+        nv3_capture_flush();
+}
+
+// Write the header and the state that the commands start from
+static bool nv3_capture_write_snapshot(svga_t* svga)
+{
+    nv3_capture_t* capture = &nv3->capture;
+    nv3_capture_header_t header = {0};
+
+    header.magic = NV3_CAPTURE_MAGIC;
+    header.version = NV3_CAPTURE_VERSION;
+    header.vram_size = svga->vram_max;
+    header.bpp = svga->bpp;
+    header.rowoffset = svga->rowoffset;
+    header.hdisp = svga->hdisp;
+    header.dispend = svga->dispend;
+    header.pfifo_size = sizeof(nv3_pfifo_t);
+    header.pgraph_size = sizeof(nv3_pgraph_t);
+    header.pramdac_size = sizeof(nv3_pramdac_t);
+
+    return (fwrite(&header, sizeof(header), 1, capture->file) == 1
+    && fwrite(svga->vram, svga->vram_max, 1, capture->file) == 1
+    && fwrite(&nv3->pfifo, sizeof(nv3_pfifo_t), 1, capture->file) == 1
+    && fwrite(&nv3->pgraph, sizeof(nv3_pgraph_t), 1, capture->file) == 1
+    && fwrite(&nv3->pramdac, sizeof(nv3_pramdac_t), 1, capture->file) == 1);
+}
+
+// Vsync. Starts the capture if it's waiting to, and counts down the frames until it's done
+void nv3_capture_frame(svga_t* svga)
+{
+    nv3_capture_t* capture = &nv3->capture;
+
+    if (capture->armed)
+    {
+        /* Nothing interesting happens in VGA mode */
+        if (!svga->override)
+            return;
+
+        capture->armed = false;
+
+        if (!nv3_capture_write_snapshot(svga))
+        {
+            warning("NV3 capture: Failed to write the snapshot\n");
+            nv3_capture_close();
+            return;
+        }
+
+        capture->recording = true;
+        nv_log("Capture started\n");
+        return;
+    }
+
+    if (!capture->recording)
+        return;
+
+    /* So the replay knows where the frames were */
+    nv3_capture_push(NV3_CAPTURE_RECORD_FRAME, 0);
+
+    if (!--capture->frames_left)
+    {
+        nv_log("Capture finished\n");
+        nv3_capture_close();
+    }
+}
+
+void nv3_capture_close(void)
+{
+    nv3_capture_t* capture = &nv3->capture;
+
+    if (!capture->file)
+        return;
+
+    /* Don't flush from nv3_capture_flush failing */
+    if (capture->recording)
+    {
+        capture->recording = false;
+        nv3_capture_flush();
+    }
+
+    if (capture->file)
+        fclose(capture->file);
+
+    capture->file = NULL;
+    capture->armed = capture->recording = false;
+}
+
+/*
+    Replay a capture and log how long it took.
+    Whatever state the card was in is put back afterwards, apart from VRAM, which is cleared.
+*/
+bool nv3_capture_replay(const char* path)
+{
+    svga_t* svga = &nv3->nvbase.svga;
+    nv3_capture_header_t header = {0};
+
+    if (!path
+    || !path[0])
+        return false;
+
+    FILE* file = plat_fopen(path, "rb");
+
+    if (!file)
+    {
+        warning("NV3 replay: Couldn't open %s\n", path);
+        return false;
+    }
+
+    if (fread(&header, sizeof(header), 1, file) != 1
+    || header.magic != NV3_CAPTURE_MAGIC
+    || header.version != NV3_CAPTURE_VERSION
+    || header.pfifo_size != sizeof(nv3_pfifo_t)
+    || header.pgraph_size != sizeof(nv3_pgraph_t)
+    || header.pramdac_size != sizeof(nv3_pramdac_t))
+    {
+        warning("NV3 replay: %s isn't a capture from this build\n", path);
+        fclose(file);
+        return false;
+    }
+
+    if (header.vram_size != svga->vram_max)
+    {
+        warning("NV3 replay: %s was captured with %d bytes of VRAM, but this card has %d\n", path, header.vram_size, svga->vram_max);
+        fclose(file);
+        return false;
+    }
+
+    /* Save everything that the replay is about to overwrite */
+    nv3_pfifo_t* old_pfifo = malloc(sizeof(nv3_pfifo_t));
+    nv3_pgraph_t* old_pgraph = malloc(sizeof(nv3_pgraph_t));
+    nv3_capture_record_t* records = malloc(NV3_CAPTURE_BUFFER_SIZE * sizeof(nv3_capture_record_t));
+
+    if (!old_pfifo
+    || !old_pgraph
+    || !records)
+    {
+        warning("NV3 replay: Couldn't allocate memory to replay %s\n", path);
+        free(old_pfifo);
+        free(old_pgraph);
+        free(records);
+        fclose(file);
+        return false;
+    }
+
+    nv3_pramdac_t old_pramdac = nv3->pramdac;
+    nv3_pmc_t old_pmc = nv3->pmc;
+    int32_t old_bpp = svga->bpp, old_rowoffset = svga->rowoffset, old_hdisp = svga->hdisp, old_dispend = svga->dispend;
+    bool ok = true;
+
+    memcpy(old_pfifo, &nv3->pfifo, sizeof(nv3_pfifo_t));
+    memcpy(old_pgraph, &nv3->pgraph, sizeof(nv3_pgraph_t));
+
+    if (fread(svga->vram, header.vram_size, 1, file) != 1
+    || fread(&nv3->pfifo, sizeof(nv3_pfifo_t), 1, file) != 1
+    || fread(&nv3->pgraph, sizeof(nv3_pgraph_t), 1, file) != 1
+    || fread(&nv3->pramdac, sizeof(nv3_pramdac_t), 1, file) != 1)
+    {
+        warning("NV3 replay: %s is truncated\n", path);
+        ok = false;
+    }
+
+    /* The timer in the snapshot belongs to the emulator that captured it */
+    nv3->pfifo.cache1_puller_timer = old_pfifo->cache1_puller_timer;
+
+    svga->bpp = header.bpp;
+    svga->rowoffset = header.rowoffset;
+    svga->hdisp = header.hdisp;
+    svga->dispend = header.dispend;
+    nv3_ramht_cache_invalidate();
+
+    uint64_t methods = 0, frames = 0;
+    uint64_t class_methods[NV3_CAPTURE_CLASSES] = {0};
+    double class_time[NV3_CAPTURE_CLASSES] = {0};
+    size_t num_records = 0;
+
+    nv3->capture.pixels = 0;
+
+    double start = rivatimer_get_monotonic_time();
+
+    while (ok
+    && (num_records = fread(records, sizeof(nv3_capture_record_t), NV3_CAPTURE_BUFFER_SIZE, file)) > 0)
+    {
+        for (size_t i = 0; i < num_records; i++)
+        {
+            if (records[i].address == NV3_CAPTURE_RECORD_FRAME)
+            {
+                frames++;
+                continue;
+            }
+
+            double method_start = rivatimer_get_monotonic_time();
+
+            /* Nothing drains CACHE1 for us while we're in here */
+            nv3_pfifo_cache1_push(records[i].address, records[i].param);
+            nv3_pfifo_cache1_drain(NV3_PFIFO_CACHE1_SIZE_MAX);
+
+            uint32_t class_id = nv3->pgraph.context_user.class & (NV3_CAPTURE_CLASSES - 1);
+
+            class_time[class_id] += rivatimer_get_monotonic_time() - method_start;
+            class_methods[class_id]++;
+            methods++;
+        }
+    }
+
+    nv3_render_d3d5_wait_idle();
+
+    double elapsed = (rivatimer_get_monotonic_time() - start) / 1000000.0;
+
+    fclose(file);
+    free(records);
+
+    if (ok)
+    {
+        pclog("NV3 replay: %s\n", path);
+        pclog("NV3 replay: %llu methods, %llu frames, %llu pixels in %.3f seconds\n",
+            (unsigned long long)methods, (unsigned long long)frames, (unsigned long long)nv3->capture.pixels, elapsed);
+
+        if (elapsed > 0)
+        {
+            pclog("NV3 replay: %.0f methods/s, %.0f pixels/s, %.1f frames/s\n",
+                (double)methods / elapsed, (double)nv3->capture.pixels / elapsed, (double)frames / elapsed);
+        }
+
+        for (uint32_t class_id = 0; class_id < NV3_CAPTURE_CLASSES; class_id++)
+        {
+            if (!class_methods[class_id])
+                continue;
+
+            pclog("NV3 replay: Class 0x%02x %-40s %10llu methods %10.3f ms\n", class_id, nv3_class_names[class_id],
+                (unsigned long long)class_methods[class_id], class_time[class_id] / 1000.0);
+        }
+    }
+
+    /* Put the card back how it was */
+    memcpy(&nv3->pfifo, old_pfifo, sizeof(nv3_pfifo_t));
+    memcpy(&nv3->pgraph, old_pgraph, sizeof(nv3_pgraph_t));
+    nv3->pramdac = old_pramdac;
+    nv3->pmc = old_pmc;
+    svga->bpp = old_bpp;
+    svga->rowoffset = old_rowoffset;
+    svga->hdisp = old_hdisp;
+    svga->dispend = old_dispend;
+    memset(svga->vram, 0x00, svga->vram_max);
+    nv3_ramht_cache_invalidate();
+    nv3_render_mark_full();
+
+    free(old_pfifo);
+    free(old_pgraph);
+    return ok;
+}
@@ -233,6 +233,63 @@ const device_config_t nv3_config[] =
         .type = CONFIG_BINARY,
         .default_int = 0,
     },
+    {
+        .name = "nv_debug_log_level",
+        .description = "nv_log level (Only up to what the build was compiled with)",
+        .type = CONFIG_SELECTION,
+        .default_int = NV_LOG_LEVEL_VERBOSE,
+        .selection = 
+        {
+            {
+                .description = "Off",
+                .value = NV_LOG_LEVEL_NONE,
+            },
+            {
+                .description = "Normal",
+                .value = NV_LOG_LEVEL_NORMAL,
+            },
+            {
+                .description = "Verbose (ENABLE_NV_LOG_ULTRA)",
+                .value = NV_LOG_LEVEL_VERBOSE,
+            },
+        },
+    },
+    {
+        .name = "nv_debug_log_mask",
+        .description = "nv_log subsystem mask (See vid_nv_log.h, 32767 = everything)",
+        .type = CONFIG_SPINNER,
+        .default_int = NV_LOG_ALL,
+        .spinner = 
+        {
+            .min = 0,
+            .max = NV_LOG_ALL,
+        },
+    },
+    {
+        .name = "nv_debug_capture_file",
+        .description = "Capture PGRAPH commands to (starts at the first accelerated frame)",
+        .type = CONFIG_FNAME,
+        .default_string = NULL,
+        .file_filter = "NV3 command captures (*.nv3cap)|*.nv3cap",
+    },
+    {
+        .name = "nv_debug_capture_frames",
+        .description = "Frames to capture",
+        .type = CONFIG_SPINNER,
+        .default_int = 300,
+        .spinner = 
+        {
+            .min = 1,
+            .max = 30000,
+        },
+    },
+    {
+        .name = "nv_debug_replay_file",
+        .description = "Replay a PGRAPH command capture at startup and log how long it took",
+        .type = CONFIG_FNAME,
+        .default_string = NULL,
+        .file_filter = "NV3 command captures (*.nv3cap)|*.nv3cap",
+    },
 #endif
     {
         .type = CONFIG_END
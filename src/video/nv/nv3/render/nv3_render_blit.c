@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <86box/86box.h>
 #include <86box/device.h>
 #include <86box/mem.h>
@@ -29,200 +30,171 @@
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
-/* Check the line bounds */
-void nv3_class_011_check_line_bounds(void)
-{                
-    uint32_t relative_x = nv3->pgraph.image_current_position.x - nv3->pgraph.image.point.x;
-    //uint32_t relative_y = nv3->pgraph.image_current_position.y - nv3->pgraph.image.point.y;
-
-    /* In theory, relative_y should never be exceeded...because it only submits enough pixels to render the image*/
-    if (relative_x >= nv3->pgraph.image.size_in.w)
-    {   
-        nv3->pgraph.image_current_position.y++;
-        nv3->pgraph.image_current_position.x = nv3->pgraph.image.point.x;
-    }
-}
-
-/* Renders an image from cpu */
-void nv3_render_blit_image(uint32_t color, nv3_grobj_t grobj)
+/* Bytes per pixel of the framebuffer, which is the format images from the CPU are sent in */
+static uint32_t nv3_render_image_bytes(void)
 {
-    // shift left by 2 because it's 4 bits per size..
-    uint32_t current_buffer = (nv3->pgraph.context_switch >> NV3_PGRAPH_CONTEXT_SWITCH_SRC_BUFFER) & 0x03; 
-
-    /* todo: a lot of stuff */
-
-    uint32_t pixel0 = 0, pixel1 = 0, pixel2 = 0, pixel3 = 0;
-
-    /* Some extra data is sent as padding, we need to clip it off using size_out */
-
-    uint16_t clip_x = nv3->pgraph.image.point.x + nv3->pgraph.image.size.w;
-    /* we need to unpack them - IF THIS IS USED SOMEWHERE ELSE, DO SOMETHING ELSE WITH IT */
-    /* the reverse order is due to the endianness */
     switch (nv3->nvbase.svga.bpp)
     {
-        // 4pixels packed into one color
         case 8:
-        
-            //pixel3
-            pixel3 = color & 0xFF;
-            if (nv3->pgraph.image_current_position.x < clip_x) nv3_render_write_pixel(nv3->pgraph.image_current_position, pixel3, grobj);
-            nv3->pgraph.image_current_position.x++;
-            nv3_class_011_check_line_bounds();
-
-            pixel2 = (color >> 8) & 0xFF;
-            if (nv3->pgraph.image_current_position.x < clip_x) nv3_render_write_pixel(nv3->pgraph.image_current_position, pixel2, grobj);
-            nv3->pgraph.image_current_position.x++;
-            nv3_class_011_check_line_bounds();
-            
-            pixel1 = (color >> 16) & 0xFF;
-            if (nv3->pgraph.image_current_position.x < clip_x) nv3_render_write_pixel(nv3->pgraph.image_current_position, pixel1, grobj);
-            nv3->pgraph.image_current_position.x++;
-            nv3_class_011_check_line_bounds();
-
-            pixel0 = (color >> 24) & 0xFF;
-            if (nv3->pgraph.image_current_position.x < clip_x) nv3_render_write_pixel(nv3->pgraph.image_current_position, pixel0, grobj);
-            nv3->pgraph.image_current_position.x++;
-            nv3_class_011_check_line_bounds();
-
-            break;
-        //2pixels packed into one color
+            return 1;
         case 15:
         case 16:
-            pixel1 = (color) & 0xFFFF;
-            if (nv3->pgraph.image_current_position.x < (clip_x)) nv3_render_write_pixel(nv3->pgraph.image_current_position, pixel1, grobj);
-            nv3->pgraph.image_current_position.x++;
-            nv3_class_011_check_line_bounds();
-
-            pixel0 = (color >> 16) & 0xFFFF;
-            if (nv3->pgraph.image_current_position.x < (clip_x)) nv3_render_write_pixel(nv3->pgraph.image_current_position, pixel0, grobj);
-            nv3->pgraph.image_current_position.x++;
-            nv3_class_011_check_line_bounds();
-                
-            break;
-        // just one pixel in 32bpp
-        case 32: 
-            pixel0 = color;
-            if (nv3->pgraph.image_current_position.x < clip_x) nv3_render_write_pixel(nv3->pgraph.image_current_position, pixel0, grobj);
-            nv3->pgraph.image_current_position.x++;
-            nv3_class_011_check_line_bounds();
-
-            break;
+            return 2;
+        default:
+            return 4;
     }
 }
 
+/* Start a new image or bitmap from the CPU at point. size is the part of it that gets drawn, size_in is the size of the data that will be sent */
+void nv3_render_image_begin(uint32_t class_id, nv3_position_16_t point, nv3_size_16_t size, nv3_size_16_t size_in)
+{
+    nv3_render_image_t* image = &nv3->pgraph.image_staging;
+
+    /* Finish off the last one if it was cut short */
+    nv3_render_image_flush();
+
+    image->class_id = class_id;
+    image->point = point;
+    image->position = point;
+    image->clip_x = point.x + size.w;
+    image->width = size_in.w;
+    image->height = size_in.h;
+    image->staged = 0;
+}
 
-#define NV3_MAX_HORIZONTAL_SIZE     1920
-#define NV3_MAX_VERTICAL_SIZE       1200
+/* Draw the pixels staged for the current row with one span */
+void nv3_render_image_flush(void)
+{
+    nv3_render_image_t* image = &nv3->pgraph.image_staging;
 
-/* 1920 for margin. Holds a buffer of the old screen we want to hold so we don't overwrite things we already overwtote
-We only need to clear it once per blit, because the blits are always the same size, and then only for the size of our new blit 
+    if (!image->staged)
+        return;
 
-Extremely not crazy about this...Surely a better way to do it without buffering the ENTIRE SCREEN. I only update the parts that are needed, but still...
+    int32_t x = (int32_t)image->position.x - (int32_t)image->staged;
+    int32_t width = image->staged;
 
-This is LUDICROUSLY INEFFICIENT (2*O(n^2)) and COMPLETELY TERRIBLE code, but it's currently 2:48am so I can't think of a better approach... 
-*/
-uint32_t nv3_s2sb_line_buffer[NV3_MAX_HORIZONTAL_SIZE*NV3_MAX_VERTICAL_SIZE] = {0};
+    /* Some extra data is sent as padding, we need to clip it off using size */
+    if ((x + width) > (int32_t)image->clip_x)
+        width = (int32_t)image->clip_x - x;
 
-void nv3_render_blit_screen2screen(nv3_grobj_t grobj)
+    if (width > 0)
+    {
+        nv3_render_span_state_t state;
+        nv3_render_span_begin(&state, image->grobj);
+        nv3_render_span_write(&state, x, image->position.y, width, image->line);
+        nv3_render_span_end(&state);
+    }
+
+    image->staged = 0;
+}
+
+/* 
+    Stage count pixels sent by the CPU, which are already in the framebuffer format. 
+    The rows of the image follow straight on from each other in the data, so a dword can have pixels from two rows in it.
+*/
+void nv3_render_image_push(const uint8_t* pixels, uint32_t count, nv3_grobj_t grobj)
 {
-    if (nv3->pgraph.blit.size.w < NV3_MAX_HORIZONTAL_SIZE
-    && nv3->pgraph.blit.size.h < NV3_MAX_VERTICAL_SIZE)
-        memset(&nv3_s2sb_line_buffer, 0x00, (sizeof(uint32_t) * nv3->pgraph.blit.size.h) * (sizeof(uint32_t) * nv3->pgraph.blit.size.w));
+    nv3_render_image_t* image = &nv3->pgraph.image_staging;
+    uint32_t bytes = nv3_render_image_bytes();
 
-    nv3_position_16_t old_position = nv3->pgraph.blit.point_in;
-    nv3_position_16_t new_position = nv3->pgraph.blit.point_out;
+    if (!image->width)
+        return;
 
-    uint32_t src_buffer = (grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_SRC_BUFFER) & 0x03; 
+    /* Pixels for a different object can't be drawn in the same span */
+    if (image->staged
+    && memcmp(&image->grobj, &grobj, sizeof(nv3_grobj_t)))
+        nv3_render_image_flush();
 
-    /* test DST_BUFFER code
-    I assume for 2d at least only one is allowed at a time
-    */
+    image->grobj = grobj;
 
-    uint32_t dst_buffer = 0; // 5 = just use the source buffer
+    while (count)
+    {
+        /* The rest is past the end of the image */
+        if (image->position.y >= (image->point.y + image->height))
+            return;
+
+        uint32_t row_left = (image->point.x + image->width) - image->position.x;
+        uint32_t space = NV3_RENDER_IMAGE_LINE_PIXELS - image->staged;
+        uint32_t take = count;
+
+        if (take > row_left) take = row_left;
+        if (take > space) take = space;
+
+        memcpy(&image->line[image->staged * bytes], pixels, take * bytes);
+        image->staged += take;
+        image->position.x += take;
+        pixels += take * bytes;
+        count -= take;
+
+        if (take == row_left)
+        {
+            nv3_render_image_flush();
+            image->position.x = image->point.x;
+            image->position.y++;
+        }
+        else if (image->staged == NV3_RENDER_IMAGE_LINE_PIXELS)
+            nv3_render_image_flush();
+    }
+}
 
-    if ((grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_DST_BUFFER0_ENABLED) & 0x01) dst_buffer = 0;
-    if ((grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_DST_BUFFER1_ENABLED) & 0x01) dst_buffer = 1;
-    if ((grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_DST_BUFFER2_ENABLED) & 0x01) dst_buffer = 2;
-    if ((grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_DST_BUFFER3_ENABLED) & 0x01) dst_buffer = 3;
+/* Renders an image from cpu. Each colour method has 4, 2 or 1 pixels packed into it depending on the bpp, the first one in the low bits */
+void nv3_render_blit_image(uint32_t color, nv3_grobj_t grobj)
+{
+    nv3_render_image_push((const uint8_t*)&color, 4 / nv3_render_image_bytes(), grobj);
+}
 
+/* 
+    Renders a bitmap from cpu. Every bit is a pixel, set bits are color_1 and clear bits are color_0.
+    Like GDI, the bits are in the right byte order, but the first pixel is the top bit of each byte.
+*/
+void nv3_render_blit_bitmap(uint32_t bitmap_data, nv3_grobj_t grobj)
+{
+    uint8_t pixels[32 * 4];
+    uint32_t bytes = nv3_render_image_bytes();
+    uint32_t color_0 = nv3->pgraph.bitmap.color_0;
+    uint32_t color_1 = nv3->pgraph.bitmap.color_1;
 
-    uint16_t end_x_in = (nv3->pgraph.blit.point_in.x + nv3->pgraph.blit.size.w); /* needed for bounds checking */
-    uint16_t end_x_out = (nv3->pgraph.blit.point_out.x + nv3->pgraph.blit.size.w);
-    uint16_t end_y = (nv3->pgraph.blit.point_out.y + nv3->pgraph.blit.size.h);
+    for (uint32_t pixel = 0; pixel < 32; pixel++)
+    {
+        uint32_t bit = (pixel & ~7) | (7 - (pixel & 7));
+        bool set = (bitmap_data >> bit) & 0x01;
 
-    uint32_t pixel_to_copy = 0x00;
+        memcpy(&pixels[pixel * bytes], (set) ? &color_1 : &color_0, bytes);
+    }
+
+    nv3_render_image_push(pixels, 32, grobj);
+}
 
-    /* Coordinates for copying an entire line at a time */
-    uint32_t buf_position = 0, vram_position = 0, size_x = nv3->pgraph.blit.size.w;
 
-    /* Read the old pixel into the line buffer
-       Assumption: All data is sent in an unpacked format. In the case of an NVIDIA GPU this means that all data is sent 32 bits at a time regardless of if
-       the actual source data is 32 bits in size or not. For pixel data, the upper bits are left as 0 in 8bpp/16bpp mode. For 86box purposes, the data is written
-       8/16 bits at a time.
+/* 
+    Screen to screen blit. Copies straight from VRAM to VRAM, one row at a time with nv3_render_span_copy.
+    The source and destination often overlap (dragging windows, scrolling), so the rows are copied bottom-up when moving down and top-down otherwise.
+    nv3_render_span_copy takes care of the direction within a row.
+*/
+void nv3_render_blit_screen2screen(nv3_grobj_t grobj)
+{
+    nv3_position_16_t src_position = nv3->pgraph.blit.point_in;
+    int32_t width = nv3->pgraph.blit.size.w;
+    int32_t height = nv3->pgraph.blit.size.h;
 
-       TODO: CHECK FOR PACKED FORMAT!!!!!
-    */
+    if (!width
+    || !height)
+        return;
 
-    if (nv3->nvbase.svga.bpp == 15
-    || nv3->nvbase.svga.bpp == 16)
-        size_x <<= 1;
-    else if (nv3->nvbase.svga.bpp == 32)
-        size_x <<= 2;
+    bool bottom_up = (nv3->pgraph.blit.point_out.y > nv3->pgraph.blit.point_in.y);
 
-    for (int32_t y = 0; y < nv3->pgraph.blit.size.h; y++)
+    nv3_render_span_state_t state;
+    nv3_render_span_begin(&state, grobj);
+
+    for (int32_t n = 0; n < height; n++)
     {
-        old_position.y = nv3->pgraph.blit.point_in.y + y;
-        /* 32bit buffer */
-        buf_position = (nv3->pgraph.blit.size.w * y);
-        vram_position = nv3_render_get_vram_address(old_position, grobj);
+        int32_t row = (bottom_up) ? (height - 1 - n) : n;
 
-        memcpy(&nv3_s2sb_line_buffer[buf_position], &nv3->nvbase.svga.vram[vram_position], size_x);
-    }
-    
-    /* simply write it all back to vram */
-    for (int32_t y = 0; y < nv3->pgraph.blit.size.h; y++)
-    {        
-        buf_position = (nv3->pgraph.blit.size.w * y);
-        new_position.y = nv3->pgraph.blit.point_out.y + y;
-        vram_position = nv3_render_get_vram_address(new_position, grobj);
-        memcpy(&nv3->nvbase.svga.vram[vram_position], &nv3_s2sb_line_buffer[buf_position], size_x);
+        src_position.y = nv3->pgraph.blit.point_in.y + row;
+
+        nv3_render_span_copy(&state, nv3->pgraph.blit.point_out.x, nv3->pgraph.blit.point_out.y + row, width, 
+            nv3_render_get_vram_address(src_position, grobj));
     }
 
-    /* 
-        We need to blit manually here because we don't go through nv3_render_write_pixel
-        We also need to update all of the areas of the screen that moved. 
-    */
-
-    nv3_position_16_t blit_position = {0};
-    nv3_size_16_t blit_size = {0};
-
-    /* Change the smallest area of the screen that moved */
-    if (nv3->pgraph.blit.point_out.x > nv3->pgraph.blit.point_in.x)
-        blit_size.w = (nv3->pgraph.blit.point_out.x - nv3->pgraph.blit.point_in.x) + nv3->pgraph.blit.size.w;
-    else if (nv3->pgraph.blit.point_out.x < nv3->pgraph.blit.point_in.x)
-        blit_size.w = (nv3->pgraph.blit.point_in.x - nv3->pgraph.blit.point_out.x) + nv3->pgraph.blit.size.w;
-    else
-        blit_size.w = nv3->pgraph.blit.size.w;
-
-    if (nv3->pgraph.blit.point_out.y > nv3->pgraph.blit.point_in.y)
-        blit_size.h = (nv3->pgraph.blit.point_out.y - nv3->pgraph.blit.point_in.y) + nv3->pgraph.blit.size.h;
-    else if (nv3->pgraph.blit.point_out.y < nv3->pgraph.blit.point_in.y)
-        blit_size.h = (nv3->pgraph.blit.point_in.y - nv3->pgraph.blit.point_out.y) + nv3->pgraph.blit.size.h;
-    else
-        blit_size.h = nv3->pgraph.blit.size.h; 
-
-    if (nv3->pgraph.blit.point_out.x > nv3->pgraph.blit.point_in.x)
-        blit_position.x = nv3->pgraph.blit.point_in.x;
-    else if (nv3->pgraph.blit.point_out.x <= nv3->pgraph.blit.point_in.x) // equals case, just use out 
-        blit_position.x = nv3->pgraph.blit.point_out.x;
-
-    if (nv3->pgraph.blit.point_out.y > nv3->pgraph.blit.point_in.y)
-        blit_position.y = nv3->pgraph.blit.point_in.y;
-    else if (nv3->pgraph.blit.point_out.y <= nv3->pgraph.blit.point_in.y) // equals case, just use out 
-        blit_position.y = nv3->pgraph.blit.point_out.y;
-
-    uint32_t buf_end = ((nv3->nvbase.svga.bpp + 1) >> 3) * xsize * ysize;
-
-    //if (nv3->pgraph.boffset[dst_buffer] <= buf_end)
-        //nv3_render_current_bpp(&nv3->nvbase.svga, blit_position, blit_size, grobj);
-}
\ No newline at end of file
+    nv3_render_span_end(&state);
+}
@@ -26,16 +26,11 @@
 #include <86box/plat.h>
 #include <86box/rom.h>
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_RENDER
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 #include <86box/utils/video_stdlib.h>
 
-/* Functions only used in this translation unit */
-void nv3_render_8bpp(nv3_position_16_t position, nv3_size_16_t size, nv3_grobj_t grobj);
-void nv3_render_15bpp(nv3_position_16_t position, nv3_size_16_t size, nv3_grobj_t grobj);
-void nv3_render_16bpp(nv3_position_16_t position, nv3_size_16_t size, nv3_grobj_t grobj);
-void nv3_render_32bpp(nv3_position_16_t position, nv3_size_16_t size, nv3_grobj_t grobj);
-
 /* Expand a colour.
    NOTE: THE GPU INTERNALLY OPERATES ON RGB10!!!!!!!!!!!
 */
@@ -218,11 +213,9 @@ uint32_t nv3_render_set_pattern_color(nv3_color_expanded_t pattern_colour, bool
     
 }
 
-/* Combine the current buffer with the pitch to get the address in the framebuffer to draw from for a given position. */
-uint32_t nv3_render_get_vram_address(nv3_position_16_t position, nv3_grobj_t grobj)
+/* Get the surface (bpitch/boffset index) that a grobj draws to. */
+uint32_t nv3_render_get_buffer(nv3_grobj_t grobj)
 {
-    uint32_t vram_x = position.x;
-    uint32_t vram_y = position.y;
     uint32_t current_buffer = (grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_SRC_BUFFER) & 0x03; 
 
     uint32_t destination_buffer = 5; // 5 = just use the source buffer
@@ -237,6 +230,16 @@ uint32_t nv3_render_get_vram_address(nv3_position_16_t position, nv3_grobj_t gro
     && destination_buffer != 5)
         current_buffer = destination_buffer;
 
+    return current_buffer;
+}
+
+/* Combine the current buffer with the pitch to get the address in the framebuffer to draw from for a given position. */
+uint32_t nv3_render_get_vram_address(nv3_position_16_t position, nv3_grobj_t grobj)
+{
+    uint32_t vram_x = position.x;
+    uint32_t vram_y = position.y;
+    uint32_t current_buffer = nv3_render_get_buffer(grobj);
+
     uint32_t framebuffer_bpp = nv3->nvbase.svga.bpp;
 
     // we have to multiply the x position by the number of bytes per pixel
@@ -260,38 +263,6 @@ uint32_t nv3_render_get_vram_address(nv3_position_16_t position, nv3_grobj_t gro
     return pixel_addr_vram;
 }
 
-/* Convert a dumb framebuffer address to a position. No buffer setup or anything, but just start at 0,0 for address 0. */
-nv3_position_16_t nv3_render_get_dfb_position(uint32_t vram_address)
-{
-    nv3_position_16_t pos = {0};
-
-    uint32_t pitch = nv3->nvbase.svga.hdisp;
-
-    if (nv3->nvbase.svga.bpp == 15
-    || nv3->nvbase.svga.bpp == 16)
-        pitch <<= 1;
-    else if (nv3->nvbase.svga.bpp == 32)
-        pitch <<= 2;
-
-    //vram_address -= nv3->pgraph.boffset[0];
-
-    pos.y = (vram_address / pitch);
-    pos.x = (vram_address % pitch);
-
-    /* Fixup our x position */
-    if (nv3->nvbase.svga.bpp == 15
-    || nv3->nvbase.svga.bpp == 16)
-        pos.x >>= 1; 
-    else if (nv3->nvbase.svga.bpp == 32)
-        pos.x >>= 2; 
-    
-
-    /* there is some strange behaviour where it writes long past the end of the fb */
-    if (pos.y >= nv3->nvbase.svga.monitor->target_buffer->h) pos.y = nv3->nvbase.svga.monitor->target_buffer->h - 1;
-
-    return pos; 
-}
-
 /* Read an 8bpp pixel from the framebuffer. */
 uint8_t nv3_render_read_pixel_8(nv3_position_16_t position, nv3_grobj_t grobj)
 { 
@@ -325,152 +296,16 @@ uint32_t nv3_render_read_pixel_32(nv3_position_16_t position, nv3_grobj_t grobj)
     return vram_32[vram_address];
 }
 
-/* Plots a pixel. */
+/* Plots a pixel. 
+   Anything that draws more than one pixel per method should use the nv3_render_span_* functions directly, so the setup and the screen update is only done once.
+*/
 void nv3_render_write_pixel(nv3_position_16_t position, uint32_t color, nv3_grobj_t grobj)
 {
-    uint8_t alpha = 0xFF;
-
-    // PFB_0 is always set to hardcoded "NO_TILING" value of 0x1114.
-    // It seems, you are meant to 
-
-    /* put this here for debugging + it may be needed later. */
-    #ifdef DEBUG
-    uint8_t color_format_object = (grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_COLOR_FORMAT) & 0x07;
-    #endif
-    bool alpha_enabled = (grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_ALPHA) & 0x01;
-
-    uint32_t framebuffer_bpp = nv3->nvbase.svga.bpp; // maybe y16 too?z
-
-    /* doesn't seem*/
-    nv3_color_argb_t color_data = *(nv3_color_argb_t*)&color;
-
-    if (framebuffer_bpp == 32)
-        alpha = color_data.a;
-    
-    int32_t clip_end_x = nv3->pgraph.clip_start.x + nv3->pgraph.clip_size.x;
-    int32_t clip_end_y = nv3->pgraph.clip_start.y + nv3->pgraph.clip_size.y;
-    
-    /* First, check our current buffer. */
-    /* Then do the clip. */
-    if (position.x < nv3->pgraph.clip_start.x
-        || position.y < nv3->pgraph.clip_start.y
-        || position.x > clip_end_x
-        || position.y > clip_end_y)
-        {
-            // DO NOT DRAW THE PIXEL
-            return;
-        }
-
-    /* TODO: Plane Mask...*/
-    if (!nv3_render_chroma_test(color, grobj))
-        return;
-
-    uint32_t pixel_addr_vram = nv3_render_get_vram_address(position, grobj);
-
-    uint32_t rop_src = 0, rop_dst = 0, rop_pattern = 0;
-    uint8_t bit = 0x00; 
-
-    /* Get our pattern data, may move to another function */
-    switch (nv3->pgraph.pattern.shape)
-    {
-
-        /* This logic is from NV1 envytoos docs, but seems to be same on NV3*/
-        case NV3_PATTERN_SHAPE_8X8:
-            bit = (position.x & 7) | (position.y & 7) << 3;
-            break; 
-        case NV3_PATTERN_SHAPE_1X64:
-            bit = (position.x & 0x3f);
-            break;
-        case NV3_PATTERN_SHAPE_64X1:
-            bit = (position.y & 0x3f);
-            break;
-    }
+    nv3_render_span_state_t state;
 
-    // pull out the actual bit and see which colour we need to use
-
-    bool use_color1 = (nv3->pgraph.pattern_bitmap >> bit) & 0x01;
-
-    if (!use_color1)
-    {
-        if (!nv3->pgraph.pattern_color_0_alpha)
-            return; 
-
-        /* This is stupid */
-        rop_pattern = nv3_render_downconvert_color(grobj, nv3->pgraph.pattern_color_0_rgb);
-    }
-    else
-    {
-        if (!nv3->pgraph.pattern_color_1_alpha)
-            return;
-
-        rop_pattern = nv3_render_downconvert_color(grobj, nv3->pgraph.pattern_color_1_rgb);
-    }
-    
-
-    /*  Go to vram and do the final ROP for a basic bitblit.
-        It seems we can skip the downconversion step *for now*, since (framebuffer bits per pixel) == (object bits per pixel) 
-        I'm not sure how games will react. But it depends on how the D3D drivers operate, we may need ro convert texture formats to the current bpp internally.
-
-        TODO: MOVE TO BPIXEL DEPTH or GROBJ0 to determine this, once we figure out how to get the bpixel depth.
-    */
-
-    switch (framebuffer_bpp)
-    {
-        case 8:
-            rop_src = color & 0xFF;
-            rop_dst = nv3->nvbase.svga.vram[pixel_addr_vram];
-            nv3->nvbase.svga.vram[pixel_addr_vram] = video_rop_gdi_ternary(nv3->pgraph.rop, rop_src, rop_dst, rop_pattern) & 0xFF;
-
-            nv3->nvbase.svga.changedvram[pixel_addr_vram >> 12] = changeframecount;
-
-            break;
-        case 15:
-        case 16:
-            uint16_t* vram_16 = (uint16_t*)(nv3->nvbase.svga.vram);
-            pixel_addr_vram >>= 1; 
-  
-            // mask to 16bit 
-
-            rop_src = color & 0xFFFF; 
-
-            /* if alpha is turned on and we aren't in 565 mode, reject transparent pixels */
-            bool is_16bpp = (nv3->pramdac.general_control >> NV3_PRAMDAC_GENERAL_CONTROL_565_MODE) & 0x01;
-
-            // a1r5g5b5
-            if (!is_16bpp)
-            {
-                if (alpha_enabled && 
-                    !(color & 0x8000))
-                    return;
-            }
-
-            // convert to 16bpp
-            // forcing it to render in 15bpp fixes it, 
-
-            rop_dst = vram_16[pixel_addr_vram];
-
-            vram_16[pixel_addr_vram] = video_rop_gdi_ternary(nv3->pgraph.rop, rop_src, rop_dst, rop_pattern) & 0xFFFF;
-
-            nv3->nvbase.svga.changedvram[pixel_addr_vram >> 11] = changeframecount;
-
-            break;
-        case 32:
-            uint32_t* vram_32 = (uint32_t*)(nv3->nvbase.svga.vram);
-            pixel_addr_vram >>= 2; 
-
-            rop_src = color;
-            rop_dst = vram_32[pixel_addr_vram];
-            vram_32[pixel_addr_vram] = video_rop_gdi_ternary(nv3->pgraph.rop, rop_src, rop_dst, rop_pattern);
-
-            nv3->nvbase.svga.changedvram[pixel_addr_vram >> 10] = changeframecount;
-
-            break;
-    }
-    
-    /* Go write the pixel */
-    nv3_size_16_t size = {0};
-    size.w = size.h = 1; 
-    nv3_render_current_bpp(&nv3->nvbase.svga, position, size, grobj);
+    nv3_render_span_begin(&state, grobj);
+    nv3_render_span_pixel(&state, position, color);
+    nv3_render_span_end(&state);
 }
 
 /* Ensure the correct monitor size */
@@ -500,220 +335,292 @@ void nv3_render_ensure_screen_size(void)
 }
 
 
-/* Blit to the monitor from DFB, 8bpp */
-void nv3_render_current_bpp_dfb_8(uint32_t address)
+/* 
+    Add part of the screen to the list of things to present at the next vsync.
+    PGRAPH calls this instead of writing to the monitor itself, so that every pixel is only converted once per frame no matter how many methods hit it.
+*/
+void nv3_render_mark_dirty(nv3_position_16_t position, nv3_size_16_t size)
 {
+    nv3_render_present_t* present = &nv3->present;
+
+    if (present->full
+    || !size.w
+    || !size.h)
+        return;
 
+    nv3_render_dirty_rect_t rect = {0};
+    rect.left = position.x;
+    rect.top = position.y;
+    rect.right = position.x + size.w - 1;
+    rect.bottom = position.y + size.h - 1;
+
+    /* Nothing we can see */
+    if (rect.left >= nv3->nvbase.svga.hdisp
+    || rect.top >= nv3->nvbase.svga.dispend)
+        return;
+
+    /* If it touches a rect we already have, just grow that one. GDI tends to draw lots of little things next to each other */
+    for (uint32_t i = 0; i < present->num_rects; i++)
+    {
+        nv3_render_dirty_rect_t* current = &present->rects[i];
+
+        if (rect.left > (current->right + 1)
+        || rect.right < (current->left - 1)
+        || rect.top > (current->bottom + 1)
+        || rect.bottom < (current->top - 1))
+            continue;
+
+        if (rect.left < current->left) current->left = rect.left;
+        if (rect.right > current->right) current->right = rect.right;
+        if (rect.top < current->top) current->top = rect.top;
+        if (rect.bottom > current->bottom) current->bottom = rect.bottom;
+        return;
+    }
+
+    /* Too much changed, so just convert the whole screen */
+    if (present->num_rects >= NV3_RENDER_DIRTY_RECTS_MAX)
+    {
+        nv3_render_mark_full();
+        return;
+    }
+
+    present->rects[present->num_rects++] = rect;
 }
 
-/* Blit to the monitor from DFB, 15/16bpp */
-void nv3_render_current_bpp_dfb_16(uint32_t address)
+/* 
+    Work out which part of the screen a range of VRAM covers, from where the displayed framebuffer starts and its pitch.
+    A range within one row of the screen gives just the pixels it covers, anything bigger gives the whole width of the rows it touches.
+    Returns false if none of it is on the screen, e.g. it's an offscreen surface.
+*/
+bool nv3_render_vram_to_rect(uint32_t vram_address, uint32_t size, nv3_render_dirty_rect_t* rect)
 {
-    nv3_size_16_t size = {0};
-    size.w = size.h = 1; 
-
-    nv3_position_16_t pos = nv3_render_get_dfb_position(address);
+    svga_t* svga = &nv3->nvbase.svga;
+    uint32_t pitch = svga->rowoffset << 3;
+    uint32_t bytes = (svga->bpp + 1) >> 3;
+    uint32_t display_start = (svga->ma_latch << 2) & svga->vram_display_mask;
+
+    if (!svga->override
+    || !size
+    || !pitch
+    || !bytes
+    || svga->hdisp <= 0
+    || svga->dispend <= 0)
+        return false;
+
+    uint64_t display_end = (uint64_t)display_start + ((uint64_t)pitch * svga->dispend);
+    uint64_t range_end = (uint64_t)vram_address + size;
+
+    /* Not on the screen */
+    if (range_end <= display_start
+    || vram_address >= display_end)
+        return false;
+
+    uint32_t first = (vram_address > display_start) ? (vram_address - display_start) : 0;
+    uint32_t last = (uint32_t)(((range_end < display_end) ? range_end : display_end) - 1 - display_start);
+
+    rect->top = first / pitch;
+    rect->bottom = last / pitch;
+
+    if (rect->top == rect->bottom)
+    {
+        rect->left = (first % pitch) / bytes;
+        rect->right = (last % pitch) / bytes;
 
-    //pos.x >>= 1; 
+        /* Only in the part of the row past the edge of the screen */
+        if (rect->left >= svga->hdisp)
+            return false;
 
-    uint32_t* p = &nv3->nvbase.svga.monitor->target_buffer->line[pos.y][pos.x];
-    uint32_t data = *(uint32_t*)&(nv3->nvbase.svga.vram[address]);
-        
-    if ((nv3->pramdac.general_control >> NV3_PRAMDAC_GENERAL_CONTROL_565_MODE) & 0x01)
-        /* should just "tip over" to the next line */
-        *p = nv3->nvbase.svga.conv_16to32(&nv3->nvbase.svga, data & 0xFFFF, 16);
+        if (rect->right >= svga->hdisp)
+            rect->right = svga->hdisp - 1;
+    }
     else
-        /* should just "tip over" to the next line */
-        *p = nv3->nvbase.svga.conv_16to32(&nv3->nvbase.svga, data & 0xFFFF, 15);
+    {
+        rect->left = 0;
+        rect->right = svga->hdisp - 1;
+    }
 
-    /*does 8bpp packed into 16 occur/ i would be surprised*/
+    return true;
 }
 
-/* Blit to the monitor from DFB, 32bpp */
-void nv3_render_current_bpp_dfb_32(uint32_t address)
+/* Mark the part of the screen that a range of VRAM covers as dirty. Everything that writes VRAM comes through here or nv3_render_vram_to_rect */
+void nv3_render_mark_vram_dirty(uint32_t vram_address, uint32_t size)
 {
-    nv3_size_16_t size = {0};
-    size.w = size.h = 1; 
+    nv3_render_dirty_rect_t rect = {0};
 
-    nv3_position_16_t pos = nv3_render_get_dfb_position(address);
+    /* Whether or not it's on the screen, it might be the cursor image */
+    nv3_cursor_vram_written(vram_address, size);
 
-    uint32_t data = *(uint32_t*)&(nv3->nvbase.svga.vram[address]);
+    if (!nv3_render_vram_to_rect(vram_address, size, &rect))
+        return;
 
-    if (nv3->nvbase.svga.bpp == 32)
-    {
-        uint32_t* p = &nv3->nvbase.svga.monitor->target_buffer->line[pos.y][pos.x];
-        *p = data;
-    }
-    /* Packed format */
-    else if (nv3->nvbase.svga.bpp == 15
-    || nv3->nvbase.svga.bpp == 16)
-    {
-        //pos.x >>= 1;
+    nv3_position_16_t position = {0};
+    nv3_size_16_t rect_size = {0};
 
-        uint32_t* p = &nv3->nvbase.svga.monitor->target_buffer->line[pos.y][pos.x];
+    position.x = rect.left;
+    position.y = rect.top;
+    rect_size.w = (rect.right - rect.left) + 1;
+    rect_size.h = (rect.bottom - rect.top) + 1;
 
-        *p = nv3->nvbase.svga.conv_16to32(&nv3->nvbase.svga, data & 0xFFFF, nv3->nvbase.svga.bpp);
-        *p++;
-        *p = nv3->nvbase.svga.conv_16to32(&nv3->nvbase.svga, (data >> 16) & 0xFFFF, nv3->nvbase.svga.bpp);
-    }
+    nv3_render_mark_dirty(position, rect_size);
 }
 
-
-/* Blit to the monitor from GPU, current bpp */
-void nv3_render_current_bpp(svga_t *svga, nv3_position_16_t pos, nv3_size_16_t size, nv3_grobj_t grobj)
+/* Present the whole screen at the next vsync, e.g. after a mode change */
+void nv3_render_mark_full(void)
 {
-    /* Ensure that we are in the correct mode. Modified SVGA core code */
-    nv3_render_ensure_screen_size();
+    nv3->present.full = true;
+    nv3->present.num_rects = 0;
+}
 
-    /* Don't try and draw stuff that is past the buffer, but, leave it in Video RAM */
-    //if (nv3->nvbase.last_buffer_address > (((nv3->nvbase.svga.bpp + 1) >> 3) * xsize * ysize))
-        //return;
+/* Convert one row of the screen from VRAM into the monitor's buffer */
+static void nv3_render_present_row(svga_t* svga, uint32_t* p, uint32_t vram_address, int32_t count)
+{
+    uint32_t mask = svga->vram_display_mask;
+    uint32_t bytes = (svga->bpp + 1) >> 3;
+    uint32_t* lookup = (svga->bpp == 15) ? video_15to32 : video_16to32;
 
-    switch (nv3->nvbase.svga.bpp)
+    /* If the row doesn't wrap around VRAM, we can just walk it with a pointer */
+    if ((vram_address + (count * bytes) - 1) <= mask)
     {
-        case 4:
-            /* Uh we should never be here because we're in the SVGA mode */
-            fatal("NV3 - Tried to render 4bpp in NV mode");
-            break; 
-        case 8:
-            nv3_render_8bpp(pos, size, grobj);
-            break; 
-        case 15:
-            nv3_render_15bpp(pos, size, grobj);
-            break; 
-        case 16:
-            nv3_render_16bpp(pos, size, grobj);
-            break;
-        case 32:
-            nv3_render_32bpp(pos, size, grobj);
-            break; 
-    }
-    
-}
+        switch (svga->bpp)
+        {
+            case 8:
+            {
+                uint8_t* src = &svga->vram[vram_address];
 
-/* 
-    Blit a certain region from the (destination buffer base + (position in vram)) to the 86Box monitor, indexed 8 bits per pixel format
-*/
+                for (int32_t x = 0; x < count; x++)
+                    p[x] = svga->map8[src[x]];
 
-void nv3_render_8bpp(nv3_position_16_t pos, nv3_size_16_t size, nv3_grobj_t grobj)
-{
-    
-}
+                break;
+            }
+            case 15:
+            case 16:
+            {
+                uint16_t* src = (uint16_t*)&svga->vram[vram_address];
 
-/* 
-    Blit a certain region from the (destination buffer base + (position in vram)) to the 86Box monitor, 15 bits per pixel format
-*/
+                for (int32_t x = 0; x < count; x++)
+                    p[x] = lookup[src[x]];
 
-void nv3_render_15bpp(nv3_position_16_t pos, nv3_size_16_t size, nv3_grobj_t grobj)
-{
-    if (!nv3)
-        return; 
+                break;
+            }
+            case 32:
+            {
+                uint32_t* src = (uint32_t*)&svga->vram[vram_address];
 
-    uint32_t vram_base; //acquired for the start of each line
-    uint32_t* p;
-    uint32_t data; 
-    uint32_t start_x = pos.x;
+                for (int32_t x = 0; x < count; x++)
+                    p[x] = src[x] & 0xFFFFFF;
 
-    p = &nv3->nvbase.svga.monitor->target_buffer->line[pos.y][pos.x];
+                break;
+            }
+        }
 
-    for (uint32_t y = 0; y < size.h; y++)
-    {
-        /* re-set the vram address because we are basically "jumping" halfway across a line here */
-        vram_base = nv3_render_get_vram_address(pos, grobj) & nv3->nvbase.svga.vram_display_mask;
+        return;
+    }
 
-        for (uint32_t x = 0; x < size.w; x++)
+    /* Otherwise mask every pixel */
+    for (int32_t x = 0; x < count; x++, vram_address = (vram_address + bytes) & mask)
+    {
+        switch (svga->bpp)
         {
-            p = &nv3->nvbase.svga.monitor->target_buffer->line[pos.y][pos.x];
-
-            data = *(uint32_t*)&nv3->nvbase.svga.vram[vram_base];
-            
-            /* should just "tip over" to the next line */
-            *p = nv3->nvbase.svga.conv_16to32(&nv3->nvbase.svga, data & 0xFFFF, 15);
-            
-            vram_base += 2; 
-            pos.x++; 
+            case 8:
+                p[x] = svga->map8[svga->vram[vram_address]];
+                break;
+            case 15:
+            case 16:
+                p[x] = lookup[*(uint16_t*)&svga->vram[vram_address]];
+                break;
+            case 32:
+                p[x] = *(uint32_t*)&svga->vram[vram_address] & 0xFFFFFF;
+                break;
         }
-        
-        pos.x = start_x; 
-        pos.y++; 
     }
 }
 
 /* 
-    Blit a certain region from the (destination buffer base + (position in vram)) to the 86Box monitor, 16 bits per pixel format
+    Send everything that changed since the last vsync to the monitor. Called from svga_poll at vsync.
+    We read the screen from where the CRTC is scanning out from, so page flips and drawing into offscreen buffers just work.
 */
-
-void nv3_render_16bpp(nv3_position_16_t pos, nv3_size_16_t size, nv3_grobj_t grobj)
-{    
+void nv3_render_present(svga_t* svga)
+{
     if (!nv3)
         return; 
 
-    uint32_t vram_base; //acquired for the start of each line
-    uint32_t* p;
-    uint32_t data; 
-    uint32_t start_x = pos.x;
+    nv3_render_present_t* present = &nv3->present;
 
-    p = &nv3->nvbase.svga.monitor->target_buffer->line[pos.y][pos.x];
+    /* Let the render threads finish the frame first */
+    nv3_render_d3d5_wait_idle();
 
-    for (uint32_t y = 0; y < size.h; y++)
+    if (nv3->capture.armed
+    || nv3->capture.recording)
+        nv3_capture_frame(svga);
+
+    /* svga_poll draws VGA mode itself. Convert everything when we come back */
+    if (!svga->override)
     {
-        /* re-get the vram address because we are basically "jumping" halfway across a line here */
-        vram_base = nv3_render_get_vram_address(pos, grobj) & nv3->nvbase.svga.vram_display_mask;
+        nv3_render_mark_full();
+        return;
+    }
 
-        for (uint32_t x = 0; x < size.w; x++)
-        {
-            p = &nv3->nvbase.svga.monitor->target_buffer->line[pos.y][pos.x];
-
-            data = *(uint32_t*)&nv3->nvbase.svga.vram[vram_base];
-            
-            /* should just "tip over" to the next line */
-            *p = nv3->nvbase.svga.conv_16to32(&nv3->nvbase.svga, data & 0xFFFF, 15);
-            
-            vram_base += 2;
-            pos.x++; 
-        }
+    /* Ensure that we are in the correct mode. Modified SVGA core code */
+    nv3_render_ensure_screen_size();
 
-        pos.x = start_x; 
-        pos.y++; 
-    } 
-}
+    int32_t width = svga->hdisp;
+    int32_t height = svga->dispend;
 
-/* 
-    Blit a certain region from the (destination buffer base + (position in vram)) to the 86Box monitor, 32 bits per pixel format
-*/
+    if (width > svga->monitor->target_buffer->w) width = svga->monitor->target_buffer->w;
+    if (height > svga->monitor->target_buffer->h) height = svga->monitor->target_buffer->h;
 
-void nv3_render_32bpp(nv3_position_16_t pos, nv3_size_16_t size, nv3_grobj_t grobj)
-{
-    if (!nv3)
-        return; 
+    if (width <= 0 
+    || height <= 0)
+        return;
+
+    uint32_t display_start = (svga->ma_latch << 2) & svga->vram_display_mask;
+    uint32_t pitch = svga->rowoffset << 3;
+    uint32_t bytes = (svga->bpp + 1) >> 3;
+
+    /* Page flip, or the SVGA core wants a redraw */
+    if (display_start != present->display_start
+    || svga->fullchange)
+        nv3_render_mark_full();
 
-    uint32_t vram_base;
-    uint32_t* p;
-    uint32_t data; 
-    uint32_t start_x = pos.x;
+    present->display_start = display_start;
 
-    p = &nv3->nvbase.svga.monitor->target_buffer->line[pos.y][pos.x];
+    /* Take the cursor off if it moved */
+    nv3_render_cursor_prepare();
 
-    for (uint32_t y = 0; y < size.h; y++)
+    if (present->full)
     {
-        /* re-get the vram address because we are basically "jumping" halfway across a line here */
-        vram_base = nv3_render_get_vram_address(pos, grobj) & nv3->nvbase.svga.vram_display_mask;
-        
+        present->rects[0].left = present->rects[0].top = 0;
+        present->rects[0].right = width - 1;
+        present->rects[0].bottom = height - 1;
+        present->num_rects = 1;
+    }
+
+    for (uint32_t i = 0; i < present->num_rects; i++)
+    {
+        nv3_render_dirty_rect_t rect = present->rects[i];
+
+        if (rect.left < 0) rect.left = 0;
+        if (rect.top < 0) rect.top = 0;
+        if (rect.right >= width) rect.right = width - 1;
+        if (rect.bottom >= height) rect.bottom = height - 1;
+
+        if (rect.left > rect.right
+        || rect.top > rect.bottom)
+            continue;
 
-        for (uint32_t x = 0; x < size.w; x++)
+        for (int32_t y = rect.top; y <= rect.bottom; y++)
         {
-            p = &nv3->nvbase.svga.monitor->target_buffer->line[pos.y][pos.x];
-
-            data = *(uint32_t*)&nv3->nvbase.svga.vram[vram_base];
-            
-            /* should just "tip over" to the next line */
-            *p = data; 
-            
-            vram_base += 4; 
-            pos.x++;
-        }
+            uint32_t vram_address = (display_start + (y * pitch) + (rect.left * bytes)) & svga->vram_display_mask;
 
-        pos.y++; 
-        pos.x = start_x; 
+            nv3_render_present_row(svga, &svga->monitor->target_buffer->line[y][rect.left], vram_address, (rect.right - rect.left) + 1);
+        }
     }
+
+    present->num_rects = 0;
+    present->full = false;
+
+    nv3_render_overlay(svga, display_start, pitch, width, height);
+    nv3_render_cursor(svga, width, height);
+
+    video_blit_memtoscreen(0, 0, xsize, ysize);
 }
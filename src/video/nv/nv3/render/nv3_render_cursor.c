@@ -0,0 +1,175 @@
+/*
+* 86Box    A hypervisor and IBM PC system emulator that specializes in
+*          running old operating systems and software designed for IBM
+*          PC systems and compatibles from 1981 through fairly recent
+*          system designs based on the PCI bus.
+*
+*          This file is part of the 86Box distribution.
+*
+*          NV3 hardware cursor
+*
+*          The cursor is a 32x32 a1r5g5b5 image in RAMIN. It is decoded once whenever it is written to, and drawn over the monitor's buffer
+*          at vsync after the screen has been presented, so moving the mouse only redraws the 32 lines the cursor was and is on.
+*
+* Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+*
+*          Copyright 2024-2025 Connor Hyde
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/pci.h>
+#include <86box/rom.h>
+#include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_RENDER
+#include <86box/nv/vid_nv.h>
+#include <86box/nv/vid_nv3.h>
+
+/* The CRTC cursor registers changed */
+void nv3_render_cursor_set_address(void)
+{
+    nv3_render_cursor_t* cursor = &nv3->cursor;
+    svga_t* svga = &nv3->nvbase.svga;
+    uint8_t addr0 = svga->crtc[NV3_CRTC_REGISTER_CURSOR_ADDR0];
+    uint8_t addr1 = svga->crtc[NV3_CRTC_REGISTER_CURSOR_ADDR1];
+
+    cursor->enabled = addr1 & 0x01;
+    cursor->ramin_address = ((addr0 & 0x7F) << 16) | ((addr1 & 0xF8) << 8);
+
+    /* RAMIN is VRAM backwards in 16 byte units, and the image is 2K aligned, so it's still in one piece */
+    cursor->vram_start = (svga->vram_max - cursor->ramin_address - NV3_RENDER_CURSOR_BYTES) & (svga->vram_max - 1);
+    cursor->vram_end = cursor->vram_start + NV3_RENDER_CURSOR_BYTES;
+    cursor->image_dirty = true;
+
+    nv_log_verbose_only("Cursor %s, image at RAMIN 0x%06x\n", (cursor->enabled) ? "on" : "off", cursor->ramin_address);
+}
+
+/* The PRAMDAC cursor position changed. Both coordinates are 12-bit signed */
+void nv3_render_cursor_set_position(uint32_t value)
+{
+    nv3->cursor.x = ((int32_t)(value << 20)) >> 20;
+    nv3->cursor.y = ((int32_t)(value << 4)) >> 20;
+}
+
+/* Decode the image from RAMIN */
+static void nv3_render_cursor_decode(nv3_render_cursor_t* cursor)
+{
+    svga_t* svga = &nv3->nvbase.svga;
+
+    for (uint32_t y = 0; y < NV3_RENDER_CURSOR_SIZE; y++)
+    {
+        uint32_t mask = 0;
+
+        for (uint32_t x = 0; x < NV3_RENDER_CURSOR_SIZE; x++)
+        {
+            uint32_t ramin_address = cursor->ramin_address + (((y * NV3_RENDER_CURSOR_SIZE) + x) << 1);
+            uint32_t vram_address = (ramin_address ^ (svga->vram_max - 0x10)) & (svga->vram_max - 1);
+            uint16_t pixel = *(uint16_t*)&svga->vram[vram_address];
+
+            uint32_t r = (pixel >> 10) & 0x1F;
+            uint32_t g = (pixel >> 5) & 0x1F;
+            uint32_t b = pixel & 0x1F;
+
+            cursor->image[(y * NV3_RENDER_CURSOR_SIZE) + x] = (((r << 3) | (r >> 2)) << 16) | (((g << 3) | (g >> 2)) << 8) | ((b << 3) | (b >> 2));
+
+            if (pixel & 0x8000)
+                mask |= (1u << x);
+        }
+
+        cursor->row_mask[y] = mask;
+    }
+
+    cursor->image_dirty = false;
+}
+
+/* Mark where the cursor was drawn at the last vsync, if it isn't going to be drawn there the same way again, so it gets taken off */
+void nv3_render_cursor_prepare(void)
+{
+    nv3_render_cursor_t* cursor = &nv3->cursor;
+
+    if (!cursor->drawn)
+        return;
+
+    if (cursor->enabled
+    && !cursor->image_dirty
+    && cursor->x == cursor->drawn_x
+    && cursor->y == cursor->drawn_y)
+        return;
+
+    nv3_position_16_t position = {0};
+    nv3_size_16_t size = {0};
+    int32_t left = (cursor->drawn_x < 0) ? 0 : cursor->drawn_x;
+    int32_t top = (cursor->drawn_y < 0) ? 0 : cursor->drawn_y;
+
+    int32_t right = cursor->drawn_x + NV3_RENDER_CURSOR_SIZE;
+    int32_t bottom = cursor->drawn_y + NV3_RENDER_CURSOR_SIZE;
+
+    cursor->drawn = false;
+
+    /* It was completely off the screen */
+    if (right <= left
+    || bottom <= top)
+        return;
+
+    position.x = left;
+    position.y = top;
+    size.w = right - left;
+    size.h = bottom - top;
+
+    nv3_render_mark_dirty(position, size);
+}
+
+/* Draw the cursor over the monitor's buffer. Only the pixels in the row masks are touched */
+void nv3_render_cursor(svga_t* svga, int32_t width, int32_t height)
+{
+    nv3_render_cursor_t* cursor = &nv3->cursor;
+
+    if (!cursor->enabled)
+        return;
+
+    if (cursor->image_dirty)
+        nv3_render_cursor_decode(cursor);
+
+    cursor->drawn = true;
+    cursor->drawn_x = cursor->x;
+    cursor->drawn_y = cursor->y;
+
+    /* Clip off the parts of each row that aren't on the screen */
+    uint32_t clip_mask = 0xFFFFFFFF;
+
+    if (cursor->x < 0)
+        clip_mask &= (cursor->x <= -NV3_RENDER_CURSOR_SIZE) ? 0 : (0xFFFFFFFF << -cursor->x);
+
+    if ((cursor->x + NV3_RENDER_CURSOR_SIZE) > width)
+        clip_mask &= (cursor->x >= width) ? 0 : (0xFFFFFFFF >> ((cursor->x + NV3_RENDER_CURSOR_SIZE) - width));
+
+    if (!clip_mask)
+        return;
+
+    for (int32_t row = 0; row < NV3_RENDER_CURSOR_SIZE; row++)
+    {
+        int32_t y = cursor->y + row;
+
+        if (y < 0)
+            continue;
+
+        if (y >= height)
+            break;
+
+        uint32_t mask = cursor->row_mask[row] & clip_mask;
+        const uint32_t* src = &cursor->image[row * NV3_RENDER_CURSOR_SIZE];
+        uint32_t* line = svga->monitor->target_buffer->line[y];
+
+        for (int32_t x = 0; mask; x++, mask >>= 1)
+        {
+            if (mask & 0x01)
+                line[cursor->x + x] = src[x];
+        }
+    }
+}
@@ -0,0 +1,743 @@
+/*
+* 86Box    A hypervisor and IBM PC system emulator that specializes in
+*          running old operating systems and software designed for IBM
+*          PC systems and compatibles from 1981 through fairly recent
+*          system designs based on the PCI bus.
+*
+*          This file is part of the 86Box distribution.
+*
+*          NV3 Direct3D 5.0 triangle rasteriser (Software version)
+*
+*          Triangles are set up on the emulation thread and drawn by render threads, in the same way as the Voodoo.
+*          Each thread owns interleaved bands of 1 << NV3_D3D5_BAND_SHIFT lines, so no two threads ever draw the same pixel.
+*
+* Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+*
+*          Copyright 2024-2025 Connor Hyde
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/pci.h>
+#include <86box/rom.h>
+#include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_RENDER
+#include <86box/nv/vid_nv.h>
+#include <86box/nv/vid_nv3.h>
+
+/* An A8R8G8B8 colour split up, so it can be worked on */
+typedef struct nv3_d3d5_color_s
+{
+    int32_t a;
+    int32_t r;
+    int32_t g;
+    int32_t b;
+} nv3_d3d5_color_t;
+
+/* Snapshot everything the pixel pipeline needs, so the methods can change it while the render threads are still drawing */
+static void nv3_render_d3d5_setup_params(nv3_d3d5_params_t* params, nv3_grobj_t grobj, uint32_t control_out, uint32_t alpha_control)
+{
+    uint32_t buffer = nv3_render_get_buffer(grobj);
+
+    /* Same bounds as the span rasteriser, they are inclusive */
+    params->clip_left = nv3->pgraph.clip_start.x;
+    params->clip_top = nv3->pgraph.clip_start.y;
+    params->clip_right = nv3->pgraph.clip_start.x + nv3->pgraph.clip_size.x;
+    params->clip_bottom = nv3->pgraph.clip_start.y + nv3->pgraph.clip_size.y;
+
+    params->bpp = nv3->nvbase.svga.bpp;
+    params->is_565 = (nv3->pramdac.general_control >> NV3_PRAMDAC_GENERAL_CONTROL_565_MODE) & 0x01;
+    params->color_offset = nv3->pgraph.boffset[buffer];
+    params->color_pitch = nv3->pgraph.bpitch[buffer];
+    params->zeta_offset = nv3->pgraph.boffset[NV3_D3D5_ZETA_BUFFER];
+    params->zeta_pitch = nv3->pgraph.bpitch[NV3_D3D5_ZETA_BUFFER];
+
+    params->texture_offset = nv3->d3d5.texture_offset;
+    params->texture_format = nv3->d3d5.texture_format;
+    params->fog_color = nv3->d3d5.fog_color;
+    params->control_out = control_out;
+    params->alpha_control = alpha_control;
+}
+
+/* D3DCMPFUNC-style comparison of a new value against the one that is already there */
+static inline bool nv3_render_d3d5_compare(uint32_t func, uint32_t value, uint32_t reference)
+{
+    switch (func)
+    {
+        case nv3_d3d5_buffer_comparison_always_false:
+            return false;
+        case nv3_d3d5_buffer_comparison_less_than:
+            return (value < reference);
+        case nv3_d3d5_buffer_comparison_equal:
+            return (value == reference);
+        case nv3_d3d5_buffer_comparison_less_or_equal:
+            return (value <= reference);
+        case nv3_d3d5_buffer_comparison_greater:
+            return (value > reference);
+        case nv3_d3d5_buffer_comparison_not_equal:
+            return (value != reference);
+        case nv3_d3d5_buffer_comparison_greater_or_equal:
+            return (value >= reference);
+        default: // always_true, and the illegal 0 that drivers leave there when they don't care
+            return true;
+    }
+}
+
+/* Should a buffer be written, given which tests passed */
+static inline bool nv3_render_d3d5_write_enabled(uint32_t write_control, bool alpha_passed, bool zeta_passed)
+{
+    switch (write_control)
+    {
+        case nv3_d3d5_buffer_write_control_alpha:
+            return alpha_passed;
+        case nv3_d3d5_buffer_write_control_alpha_zeta:
+            return (alpha_passed && zeta_passed);
+        case nv3_d3d5_buffer_write_control_zeta:
+            return zeta_passed;
+        case nv3_d3d5_buffer_write_control_always:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Read a pixel of the colour buffer as A8R8G8B8 */
+static inline nv3_d3d5_color_t nv3_render_d3d5_read_color(const nv3_d3d5_params_t* params, uint32_t addr)
+{
+    nv3_d3d5_color_t color = {0};
+    uint8_t* vram = nv3->nvbase.svga.vram;
+
+    color.a = 0xFF;
+
+    if (params->bpp == 32)
+    {
+        uint32_t pixel = *(uint32_t*)&vram[addr];
+        color.r = (pixel >> 16) & 0xFF;
+        color.g = (pixel >> 8) & 0xFF;
+        color.b = pixel & 0xFF;
+    }
+    else
+    {
+        uint16_t pixel = *(uint16_t*)&vram[addr];
+
+        if (params->is_565)
+        {
+            color.r = ((pixel >> 11) & 0x1F) << 3;
+            color.g = ((pixel >> 5) & 0x3F) << 2;
+        }
+        else
+        {
+            color.r = ((pixel >> 10) & 0x1F) << 3;
+            color.g = ((pixel >> 5) & 0x1F) << 3;
+        }
+
+        color.b = (pixel & 0x1F) << 3;
+    }
+
+    return color;
+}
+
+/* Write a pixel of the colour buffer */
+static inline void nv3_render_d3d5_write_color(const nv3_d3d5_params_t* params, uint32_t addr, nv3_d3d5_color_t color)
+{
+    uint8_t* vram = nv3->nvbase.svga.vram;
+
+    if (params->bpp == 32)
+        *(uint32_t*)&vram[addr] = (color.a << 24) | (color.r << 16) | (color.g << 8) | color.b;
+    else if (params->is_565)
+        *(uint16_t*)&vram[addr] = ((color.r >> 3) << 11) | ((color.g >> 2) << 5) | (color.b >> 3);
+    else
+        *(uint16_t*)&vram[addr] = ((color.a >= 0x80) << 15) | ((color.r >> 3) << 10) | ((color.g >> 3) << 5) | (color.b >> 3);
+}
+
+/*
+    Everything after the colour of a pixel is known: alpha test, zeta test, blending and writing it out.
+    Shared by triangles and points.
+*/
+static void nv3_render_d3d5_output(const nv3_d3d5_params_t* params, int32_t x, int32_t y, nv3_d3d5_color_t color, uint32_t zeta)
+{
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+    uint32_t bytes = (params->bpp == 32) ? 4 : 2;
+    uint32_t color_addr = (params->color_offset + (params->color_pitch * y) + (x * bytes)) & vram_mask & ~(bytes - 1);
+    uint32_t zeta_addr = (params->zeta_offset + (params->zeta_pitch * y) + (x << 1)) & vram_mask & ~1;
+    uint16_t* zeta_buffer = (uint16_t*)&nv3->nvbase.svga.vram[zeta_addr];
+
+    uint32_t alpha_func = (params->alpha_control >> NV3_D3D5_ALPHA_CONTROL_COMPARE) & 0x0F;
+    uint32_t zeta_func = (params->control_out >> NV3_D3D5_CONTROL_OUT_ZETA_COMPARE) & 0x0F;
+    uint32_t zeta_write = (params->control_out >> NV3_D3D5_CONTROL_OUT_ZETA_WRITE) & 0x07;
+    uint32_t color_write = (params->control_out >> NV3_D3D5_CONTROL_OUT_COLOR_WRITE) & 0x07;
+
+    bool alpha_passed = nv3_render_d3d5_compare(alpha_func, color.a, params->alpha_control & 0xFF);
+    bool zeta_passed = nv3_render_d3d5_compare(zeta_func, zeta, *zeta_buffer);
+
+    if (nv3_render_d3d5_write_enabled(zeta_write, alpha_passed, zeta_passed))
+        *zeta_buffer = zeta;
+
+    if (!nv3_render_d3d5_write_enabled(color_write, alpha_passed, zeta_passed))
+        return;
+
+    /* Blend with what's already there. Any other blend ROP just replaces it */
+    if ((params->control_out >> NV3_D3D5_CONTROL_OUT_BLEND_ROP) & 0x01)
+    {
+        nv3_d3d5_color_t dst = nv3_render_d3d5_read_color(params, color_addr);
+        int32_t src_factor = ((params->control_out >> NV3_D3D5_CONTROL_OUT_BLEND_INPUT0) & 0x01) ? 0xFF : color.a;
+        int32_t dst_factor = ((params->control_out >> NV3_D3D5_CONTROL_OUT_BLEND_INPUT1) & 0x01) ? 0 : (0xFF - color.a);
+
+        color.r = ((color.r * src_factor) + (dst.r * dst_factor)) / 0xFF;
+        color.g = ((color.g * src_factor) + (dst.g * dst_factor)) / 0xFF;
+        color.b = ((color.b * src_factor) + (dst.b * dst_factor)) / 0xFF;
+
+        // add with saturation
+        if (color.r > 0xFF) color.r = 0xFF;
+        if (color.g > 0xFF) color.g = 0xFF;
+        if (color.b > 0xFF) color.b = 0xFF;
+    }
+
+    nv3_render_d3d5_write_color(params, color_addr, color);
+}
+
+/* Wrap a texel coordinate into a texture that is size texels wide */
+static inline int32_t nv3_render_d3d5_wrap(int32_t coord, int32_t size, uint32_t wrap_mode)
+{
+    switch (wrap_mode)
+    {
+        case nv3_d3d5_texture_wrap_mode_mirror:
+            return (coord & size) ? ((size - 1) - (coord & (size - 1))) : (coord & (size - 1));
+        case nv3_d3d5_texture_wrap_mode_clamp:
+            return (coord < 0) ? 0 : ((coord >= size) ? (size - 1) : coord);
+        default: // wrap, and cylindrical which is the same thing for a single triangle
+            return coord & (size - 1);
+    }
+}
+
+/* Fetch one texel as A8R8G8B8. Returns false if it was colour keyed out */
+static inline bool nv3_render_d3d5_fetch_texel(const nv3_d3d5_params_t* params, int32_t s, int32_t t, uint32_t size_log2, nv3_d3d5_color_t* texel)
+{
+    uint32_t size = 1 << size_log2;
+    uint32_t wrap_u = (params->control_out >> NV3_D3D5_CONTROL_OUT_WRAP_U) & 0x03;
+    uint32_t wrap_v = (params->control_out >> NV3_D3D5_CONTROL_OUT_WRAP_V) & 0x03;
+
+    s = nv3_render_d3d5_wrap(s, size, wrap_u);
+    t = nv3_render_d3d5_wrap(t, size, wrap_v);
+
+    uint32_t addr = (params->texture_offset + (((t << size_log2) + s) << 1)) & nv3->nvbase.svga.vram_mask & ~1;
+    uint16_t pixel = *(uint16_t*)&nv3->nvbase.svga.vram[addr];
+
+    if (((params->texture_format >> NV3_D3D5_TEXTURE_FORMAT_COLOR_KEY_ENABLED) & 0x01)
+    && pixel == (params->texture_format & 0xFFFF))
+        return false;
+
+    switch ((params->texture_format >> NV3_D3D5_TEXTURE_FORMAT_COLOR) & 0x03)
+    {
+        case nv3_d3d5_pixel_format_le_a1r5g5b5:
+        case nv3_d3d5_pixel_format_le_x1r5g5b5:
+            texel->a = (((params->texture_format >> NV3_D3D5_TEXTURE_FORMAT_COLOR) & 0x03) == nv3_d3d5_pixel_format_le_x1r5g5b5
+                || (pixel >> 15)) ? 0xFF : 0x00;
+            texel->r = ((pixel >> 10) & 0x1F) << 3;
+            texel->g = ((pixel >> 5) & 0x1F) << 3;
+            texel->b = (pixel & 0x1F) << 3;
+            break;
+        case nv3_d3d5_pixel_format_le_a4r4g4b4:
+            texel->a = ((pixel >> 12) & 0x0F) * 0x11;
+            texel->r = ((pixel >> 8) & 0x0F) * 0x11;
+            texel->g = ((pixel >> 4) & 0x0F) * 0x11;
+            texel->b = (pixel & 0x0F) * 0x11;
+            break;
+        case nv3_d3d5_pixel_format_le_r5g6b5:
+            texel->a = 0xFF;
+            texel->r = ((pixel >> 11) & 0x1F) << 3;
+            texel->g = ((pixel >> 5) & 0x3F) << 2;
+            texel->b = (pixel & 0x1F) << 3;
+            break;
+    }
+
+    return true;
+}
+
+/* Sample the texture at u,v (0.0-1.0 covers the whole texture). Returns false if the pixel was colour keyed out */
+static bool nv3_render_d3d5_sample(const nv3_d3d5_params_t* params, float u, float v, nv3_d3d5_color_t* texel)
+{
+    uint32_t size_log2 = (params->texture_format >> NV3_D3D5_TEXTURE_FORMAT_SIZE_MAX) & 0x0F;
+    float size = (float)(1 << size_log2);
+    uint32_t interpolator = (params->control_out >> NV3_D3D5_CONTROL_OUT_INTERPOLATOR) & 0x03;
+
+    /* Zero-order hold = nearest */
+    if (interpolator != nv3_d3d5_interpolator_foh)
+        return nv3_render_d3d5_fetch_texel(params, (int32_t)floorf(u * size), (int32_t)floorf(v * size), size_log2, texel);
+
+    /* First-order hold = bilinear, with 8 bits of fraction */
+    int32_t s_fixed = (int32_t)floorf((u * size - 0.5f) * 256.0f);
+    int32_t t_fixed = (int32_t)floorf((v * size - 0.5f) * 256.0f);
+    int32_t s = s_fixed >> 8, t = t_fixed >> 8;
+    int32_t s_frac = s_fixed & 0xFF, t_frac = t_fixed & 0xFF;
+    int32_t weights[4] = { (0x100 - s_frac) * (0x100 - t_frac), s_frac * (0x100 - t_frac), (0x100 - s_frac) * t_frac, s_frac * t_frac };
+    nv3_d3d5_color_t texels[4] = {0};
+    int32_t total = 0;
+
+    if (!nv3_render_d3d5_fetch_texel(params, s, t, size_log2, &texels[0])) weights[0] = 0;
+    if (!nv3_render_d3d5_fetch_texel(params, s + 1, t, size_log2, &texels[1])) weights[1] = 0;
+    if (!nv3_render_d3d5_fetch_texel(params, s, t + 1, size_log2, &texels[2])) weights[2] = 0;
+    if (!nv3_render_d3d5_fetch_texel(params, s + 1, t + 1, size_log2, &texels[3])) weights[3] = 0;
+
+    memset(texel, 0, sizeof(nv3_d3d5_color_t));
+
+    for (int32_t i = 0; i < 4; i++)
+    {
+        texel->a += texels[i].a * weights[i];
+        texel->r += texels[i].r * weights[i];
+        texel->g += texels[i].g * weights[i];
+        texel->b += texels[i].b * weights[i];
+        total += weights[i];
+    }
+
+    /* All four were keyed out */
+    if (!total)
+        return false;
+
+    texel->a /= total;
+    texel->r /= total;
+    texel->g /= total;
+    texel->b /= total;
+    return true;
+}
+
+/* Clamp an interpolated colour channel */
+static inline int32_t nv3_render_d3d5_clamp_channel(float value)
+{
+    if (value <= 0.0f)
+        return 0;
+    if (value >= 255.0f)
+        return 0xFF;
+
+    return (int32_t)value;
+}
+
+/* Draw the lines of a triangle that belong to one render thread */
+static void nv3_render_d3d5_rasterise(const nv3_d3d5_params_t* params, int32_t thread)
+{
+    int32_t render_threads = nv3->d3d5.render_threads;
+    uint32_t source_color = (params->control_out >> NV3_D3D5_CONTROL_OUT_SOURCE_COLOR) & 0x03;
+    nv3_d3d5_color_t fog_color = {0};
+    const nv3_d3d5_gradient_t* gradients = params->gradients;
+
+    fog_color.r = (params->fog_color >> 16) & 0xFF;
+    fog_color.g = (params->fog_color >> 8) & 0xFF;
+    fog_color.b = params->fog_color & 0xFF;
+
+    /* Pixel centres are at +0.5 */
+    int32_t y_start = (int32_t)ceilf(params->y[0] - 0.5f);
+    int32_t y_end = (int32_t)ceilf(params->y[2] - 0.5f);
+
+    if (y_start < params->clip_top)
+        y_start = params->clip_top;
+
+    if (y_end > (params->clip_bottom + 1))
+        y_end = params->clip_bottom + 1;
+
+    for (int32_t y = y_start; y < y_end; y++)
+    {
+        /* Not our band */
+        if (render_threads > 1
+        && ((y >> NV3_D3D5_BAND_SHIFT) % render_threads) != thread)
+            continue;
+
+        float y_centre = (float)y + 0.5f;
+
+        /* Long edge goes from the top vertex to the bottom one, the short edges go through the middle one */
+        float x_long = params->x[0] + ((y_centre - params->y[0]) * (params->x[2] - params->x[0]) / (params->y[2] - params->y[0]));
+        float x_short;
+
+        if (y_centre < params->y[1])
+            x_short = params->x[0] + ((y_centre - params->y[0]) * (params->x[1] - params->x[0]) / (params->y[1] - params->y[0]));
+        else
+            x_short = params->x[1] + ((y_centre - params->y[1]) * (params->x[2] - params->x[1]) / (params->y[2] - params->y[1]));
+
+        float x_left_edge = (x_long < x_short) ? x_long : x_short;
+        float x_right_edge = (x_long < x_short) ? x_short : x_long;
+        int32_t x_start = (int32_t)ceilf(x_left_edge - 0.5f);
+        int32_t x_end = (int32_t)ceilf(x_right_edge - 0.5f);
+
+        if (x_start < params->clip_left)
+            x_start = params->clip_left;
+
+        if (x_end > (params->clip_right + 1))
+            x_end = params->clip_right + 1;
+
+        if (x_start >= x_end)
+            continue;
+
+        /* Work out every attribute at the first pixel, then just step them along the row */
+        float attributes[nv3_d3d5_attribute_count];
+
+        for (int32_t i = 0; i < nv3_d3d5_attribute_count; i++)
+            attributes[i] = gradients[i].start + (gradients[i].dx * ((float)x_start + 0.5f)) + (gradients[i].dy * y_centre);
+
+        for (int32_t x = x_start; x < x_end; x++)
+        {
+            nv3_d3d5_color_t color = {0};
+            nv3_d3d5_color_t texel = {0};
+            float w = (attributes[nv3_d3d5_attribute_m] != 0.0f) ? (1.0f / attributes[nv3_d3d5_attribute_m]) : 0.0f;
+
+            /* Perspective correct texture coordinates */
+            if (nv3_render_d3d5_sample(params, attributes[nv3_d3d5_attribute_um] * w, attributes[nv3_d3d5_attribute_vm] * w, &texel))
+            {
+                switch (source_color)
+                {
+                    case nv3_d3d5_source_color_inverse:
+                        texel.r = 0xFF - texel.r;
+                        texel.g = 0xFF - texel.g;
+                        texel.b = 0xFF - texel.b;
+                        break;
+                    case nv3_d3d5_source_color_alpha_inverse:
+                        texel.a = 0xFF - texel.a;
+                        break;
+                    case nv3_d3d5_source_color_alpha_one:
+                        texel.a = 0xFF;
+                        break;
+                }
+
+                /* Modulate with the Gouraud shaded diffuse colour */
+                color.a = (texel.a * nv3_render_d3d5_clamp_channel(attributes[nv3_d3d5_attribute_a])) / 0xFF;
+                color.r = (texel.r * nv3_render_d3d5_clamp_channel(attributes[nv3_d3d5_attribute_r])) / 0xFF;
+                color.g = (texel.g * nv3_render_d3d5_clamp_channel(attributes[nv3_d3d5_attribute_g])) / 0xFF;
+                color.b = (texel.b * nv3_render_d3d5_clamp_channel(attributes[nv3_d3d5_attribute_b])) / 0xFF;
+
+                /* Vertex fog: 0xFF is no fog at all */
+                int32_t fog = nv3_render_d3d5_clamp_channel(attributes[nv3_d3d5_attribute_fog]);
+
+                color.r = ((color.r * fog) + (fog_color.r * (0xFF - fog))) / 0xFF;
+                color.g = ((color.g * fog) + (fog_color.g * (0xFF - fog))) / 0xFF;
+                color.b = ((color.b * fog) + (fog_color.b * (0xFF - fog))) / 0xFF;
+
+                float z = attributes[nv3_d3d5_attribute_z];
+                uint32_t zeta = (z <= 0.0f) ? 0 : ((z >= 1.0f) ? 0xFFFF : (uint32_t)(z * 65535.0f));
+
+                nv3_render_d3d5_output(params, x, y, color, zeta);
+            }
+
+            for (int32_t i = 0; i < nv3_d3d5_attribute_count; i++)
+                attributes[i] += gradients[i].dx;
+        }
+    }
+}
+
+/* Wake up the render threads if they are idle */
+static void nv3_render_d3d5_wake_threads(void)
+{
+    for (int32_t i = 0; i < nv3->d3d5.render_threads; i++)
+        thread_set_event(nv3->d3d5.wake_render_thread[i]);
+}
+
+/* A render thread. Draws its bands of every triangle in the ring buffer, then goes to sleep until there are more */
+static void nv3_render_d3d5_thread(void* param)
+{
+    int32_t thread = (int32_t)(intptr_t)param;
+
+    while (nv3->d3d5.render_thread_run[thread])
+    {
+        thread_set_event(nv3->d3d5.render_not_full_event[thread]);
+        thread_wait_event(nv3->d3d5.wake_render_thread[thread], -1);
+        thread_reset_event(nv3->d3d5.wake_render_thread[thread]);
+        nv3->d3d5.render_busy[thread] = 1;
+
+        while (!NV3_D3D5_PARAMS_EMPTY(thread))
+        {
+            nv3_d3d5_params_t* params = &nv3->d3d5.params_buffer[nv3->d3d5.params_read_idx[thread] & NV3_D3D5_PARAMS_MASK];
+
+            nv3_render_d3d5_rasterise(params, thread);
+
+            nv3->d3d5.params_read_idx[thread]++;
+
+            if (NV3_D3D5_PARAMS_ENTRIES(thread) > (NV3_D3D5_PARAMS_SIZE - 10))
+                thread_set_event(nv3->d3d5.render_not_full_event[thread]);
+        }
+
+        nv3->d3d5.render_busy[thread] = 0;
+    }
+}
+
+/* Start the render threads. With only one, triangles are drawn straight away on the emulation thread */
+void nv3_render_d3d5_init(int32_t render_threads)
+{
+    if (render_threads < 1)
+        render_threads = 1;
+
+    if (render_threads > NV3_D3D5_RENDER_THREADS_MAX)
+        render_threads = NV3_D3D5_RENDER_THREADS_MAX;
+
+    nv3->d3d5.render_threads = render_threads;
+    nv3->d3d5.params_write_idx = 0;
+
+    if (render_threads == 1)
+        return;
+
+    nv_log("Starting %d D3D5 render threads\n", render_threads);
+
+    for (int32_t i = 0; i < render_threads; i++)
+    {
+        nv3->d3d5.params_read_idx[i] = 0;
+        nv3->d3d5.render_busy[i] = 0;
+        nv3->d3d5.render_thread_run[i] = 1;
+        nv3->d3d5.wake_render_thread[i] = thread_create_event();
+        nv3->d3d5.render_not_full_event[i] = thread_create_event();
+        nv3->d3d5.render_thread[i] = thread_create(nv3_render_d3d5_thread, (void*)(intptr_t)i);
+    }
+}
+
+/* Stop the render threads */
+void nv3_render_d3d5_close(void)
+{
+    if (nv3->d3d5.render_threads <= 1)
+        return;
+
+    nv3_render_d3d5_wait_idle();
+
+    for (int32_t i = 0; i < nv3->d3d5.render_threads; i++)
+    {
+        nv3->d3d5.render_thread_run[i] = 0;
+        thread_set_event(nv3->d3d5.wake_render_thread[i]);
+        thread_wait(nv3->d3d5.render_thread[i]);
+        thread_destroy_event(nv3->d3d5.wake_render_thread[i]);
+        thread_destroy_event(nv3->d3d5.render_not_full_event[i]);
+    }
+
+    nv3->d3d5.render_threads = 1;
+}
+
+/* Wait for the render threads to draw everything. Anything that touches VRAM outside of class 0x17 has to call this first */
+void nv3_render_d3d5_wait_idle(void)
+{
+    if (!nv3
+    || nv3->d3d5.render_threads <= 1)
+        return;
+
+    for (int32_t i = 0; i < nv3->d3d5.render_threads; i++)
+    {
+        while (!NV3_D3D5_PARAMS_EMPTY(i) || nv3->d3d5.render_busy[i])
+        {
+            nv3_render_d3d5_wake_threads();
+            thread_wait_event(nv3->d3d5.render_not_full_event[i], 1);
+        }
+    }
+}
+
+/* Put a triangle in the ring buffer, once there is room for it */
+static void nv3_render_d3d5_queue(const nv3_d3d5_params_t* params)
+{
+    int32_t render_threads = nv3->d3d5.render_threads;
+
+    for (int32_t i = 0; i < render_threads; i++)
+    {
+        while (NV3_D3D5_PARAMS_FULL(i))
+        {
+            thread_reset_event(nv3->d3d5.render_not_full_event[i]);
+
+            if (NV3_D3D5_PARAMS_FULL(i))
+                thread_wait_event(nv3->d3d5.render_not_full_event[i], -1); /* Wait for room in the ring buffer */
+        }
+    }
+
+    memcpy(&nv3->d3d5.params_buffer[nv3->d3d5.params_write_idx & NV3_D3D5_PARAMS_MASK], params, sizeof(nv3_d3d5_params_t));
+
+    nv3->d3d5.params_write_idx++;
+
+    for (int32_t i = 0; i < render_threads; i++)
+    {
+        if (NV3_D3D5_PARAMS_ENTRIES(i) < 4)
+        {
+            nv3_render_d3d5_wake_threads();
+            break;
+        }
+    }
+}
+
+/* Get the plane equation of an attribute from its value at the three vertices */
+static void nv3_render_d3d5_gradient(nv3_d3d5_gradient_t* gradient, const float* x, const float* y, float a0, float a1, float a2, float area)
+{
+    gradient->dx = (((a1 - a0) * (y[2] - y[0])) - ((a2 - a0) * (y[1] - y[0]))) / area;
+    gradient->dy = (((a2 - a0) * (x[1] - x[0])) - ((a1 - a0) * (x[2] - x[0]))) / area;
+    gradient->start = a0 - (x[0] * gradient->dx) - (y[0] * gradient->dy);
+}
+
+/* Set up a triangle from three of the submitted vertices, and queue it for drawing */
+void nv3_render_d3d5_triangle(nv3_grobj_t grobj, uint32_t vertex0, uint32_t vertex1, uint32_t vertex2)
+{
+    nv3_d3d5_params_t params = {0};
+    const nv3_d3d5_vertex_t* vertices[3] =
+    {
+        &nv3->d3d5.vertices[vertex0 % NV3_D3D5_VERTICES],
+        &nv3->d3d5.vertices[vertex1 % NV3_D3D5_VERTICES],
+        &nv3->d3d5.vertices[vertex2 % NV3_D3D5_VERTICES],
+    };
+
+    if (nv3->nvbase.svga.bpp == 8)
+    {
+        nv_log("D3D5 triangle in 8bpp mode, ignoring\n");
+        return;
+    }
+
+    float x[3] = { vertices[0]->x, vertices[1]->x, vertices[2]->x };
+    float y[3] = { vertices[0]->y, vertices[1]->y, vertices[2]->y };
+
+    /* Twice the signed area. Positive is clockwise on the screen, because y goes down */
+    float area = ((x[1] - x[0]) * (y[2] - y[0])) - ((x[2] - x[0]) * (y[1] - y[0]));
+
+    if (area == 0.0f
+    || isnan(area))
+        return;
+
+    switch ((nv3->d3d5.control_out >> NV3_D3D5_CONTROL_OUT_CULLING) & 0x03)
+    {
+        case nv3_d3d5_culling_algorithm_clockwise:
+            if (area > 0.0f)
+                return;
+            break;
+        case nv3_d3d5_culling_algorithm_counterclockwise:
+            if (area < 0.0f)
+                return;
+            break;
+    }
+
+    nv3_render_d3d5_setup_params(&params, grobj, nv3->d3d5.control_out, nv3->d3d5.alpha_control);
+
+    /* Work out the plane equations before sorting, so they don't depend on the vertex order */
+    float values[nv3_d3d5_attribute_count][3];
+
+    for (int32_t i = 0; i < 3; i++)
+    {
+        values[nv3_d3d5_attribute_z][i] = vertices[i]->z;
+        values[nv3_d3d5_attribute_m][i] = vertices[i]->m;
+        values[nv3_d3d5_attribute_um][i] = vertices[i]->u * vertices[i]->m;
+        values[nv3_d3d5_attribute_vm][i] = vertices[i]->v * vertices[i]->m;
+        values[nv3_d3d5_attribute_a][i] = (float)((vertices[i]->color >> 24) & 0xFF);
+        values[nv3_d3d5_attribute_r][i] = (float)((vertices[i]->color >> 16) & 0xFF);
+        values[nv3_d3d5_attribute_g][i] = (float)((vertices[i]->color >> 8) & 0xFF);
+        values[nv3_d3d5_attribute_b][i] = (float)(vertices[i]->color & 0xFF);
+        values[nv3_d3d5_attribute_fog][i] = (float)((vertices[i]->specular >> 24) & 0xFF);
+    }
+
+    for (int32_t i = 0; i < nv3_d3d5_attribute_count; i++)
+        nv3_render_d3d5_gradient(&params.gradients[i], x, y, values[i][0], values[i][1], values[i][2], area);
+
+    /* Sort the vertices top to bottom for edge walking */
+    int32_t order[3] = { 0, 1, 2 };
+    int32_t swap;
+
+    if (y[order[1]] < y[order[0]]) { swap = order[0]; order[0] = order[1]; order[1] = swap; }
+    if (y[order[2]] < y[order[1]]) { swap = order[1]; order[1] = order[2]; order[2] = swap; }
+    if (y[order[1]] < y[order[0]]) { swap = order[0]; order[0] = order[1]; order[1] = swap; }
+
+    for (int32_t i = 0; i < 3; i++)
+    {
+        params.x[i] = x[order[i]];
+        params.y[i] = y[order[i]];
+    }
+
+    /* Work out what will be drawn, clipped, so it can be marked as dirty now instead of from the render threads */
+    float x_min = fminf(x[0], fminf(x[1], x[2]));
+    float x_max = fmaxf(x[0], fmaxf(x[1], x[2]));
+    int32_t left = (int32_t)ceilf(x_min - 0.5f);
+    int32_t right = (int32_t)ceilf(x_max - 0.5f) - 1;
+    int32_t top = (int32_t)ceilf(params.y[0] - 0.5f);
+    int32_t bottom = (int32_t)ceilf(params.y[2] - 0.5f) - 1;
+
+    if (left < params.clip_left) left = params.clip_left;
+    if (right > params.clip_right) right = params.clip_right;
+    if (top < params.clip_top) top = params.clip_top;
+    if (bottom > params.clip_bottom) bottom = params.clip_bottom;
+
+    if (left > right
+    || top > bottom)
+        return;
+
+    uint32_t bytes = (params.bpp == 32) ? 4 : 2;
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+    uint32_t first_addr = (params.color_offset + (params.color_pitch * top) + (left * bytes)) & vram_mask;
+    uint32_t last_addr = (params.color_offset + (params.color_pitch * bottom) + (right * bytes)) & vram_mask;
+
+    /* If it wrapped around the end of VRAM, just mark everything from the start of it */
+    if (last_addr < first_addr)
+        last_addr = vram_mask;
+
+    for (uint32_t page = (first_addr >> 12); page <= (last_addr >> 12); page++)
+        nv3->nvbase.svga.changedvram[page] = changeframecount;
+
+    nv3_cursor_vram_written(first_addr, (last_addr - first_addr) + bytes);
+
+    /* The colour buffer may not be the screen, or may have a different pitch, so go from where each row is in VRAM */
+    nv3_render_dirty_rect_t dirty = {0}, row_rect = {0};
+    bool any_dirty = false;
+
+    for (int32_t row = top; row <= bottom; row++)
+    {
+        uint32_t row_addr = (params.color_offset + (params.color_pitch * row) + (left * bytes)) & vram_mask;
+
+        if (!nv3_render_vram_to_rect(row_addr, ((right - left) + 1) * bytes, &row_rect))
+            continue;
+
+        if (!any_dirty)
+            dirty = row_rect;
+        else
+        {
+            if (row_rect.left < dirty.left) dirty.left = row_rect.left;
+            if (row_rect.right > dirty.right) dirty.right = row_rect.right;
+            if (row_rect.top < dirty.top) dirty.top = row_rect.top;
+            if (row_rect.bottom > dirty.bottom) dirty.bottom = row_rect.bottom;
+        }
+
+        any_dirty = true;
+    }
+
+    if (any_dirty)
+    {
+        nv3_position_16_t position = {0};
+        nv3_size_16_t size = {0};
+        position.x = dirty.left;
+        position.y = dirty.top;
+        size.w = (dirty.right - dirty.left) + 1;
+        size.h = (dirty.bottom - dirty.top) + 1;
+        nv3_render_mark_dirty(position, size);
+    }
+
+    if (nv3->d3d5.render_threads <= 1)
+        nv3_render_d3d5_rasterise(&params, 0);
+    else
+        nv3_render_d3d5_queue(&params);
+}
+
+/* Draw one point with a zeta buffer (class 0x18). Points have no texture, so only the output part of the pipeline is used */
+void nv3_render_d3d5_point(nv3_grobj_t grobj, nv3_position_16_t position, uint32_t color, uint32_t zeta)
+{
+    nv3_d3d5_params_t params = {0};
+    nv3_d3d5_color_t point_color = {0};
+
+    if (nv3->nvbase.svga.bpp == 8)
+        return;
+
+    nv3_render_d3d5_setup_params(&params, grobj, nv3->d3d5.point_control_out, nv3->d3d5.point_alpha_control);
+
+    if (position.x < params.clip_left
+    || position.x > params.clip_right
+    || position.y < params.clip_top
+    || position.y > params.clip_bottom)
+        return;
+
+    point_color.a = (color >> 24) & 0xFF;
+    point_color.r = (color >> 16) & 0xFF;
+    point_color.g = (color >> 8) & 0xFF;
+    point_color.b = color & 0xFF;
+
+    nv3_render_d3d5_output(&params, position.x, position.y, point_color, zeta & 0xFFFF);
+
+    uint32_t bytes = (params.bpp == 32) ? 4 : 2;
+    uint32_t addr = (params.color_offset + (params.color_pitch * position.y) + (position.x * bytes)) & nv3->nvbase.svga.vram_mask;
+    nv3->nvbase.svga.changedvram[addr >> 12] = changeframecount;
+    nv3_render_mark_vram_dirty(addr, bytes);
+}
@@ -0,0 +1,278 @@
+/*
+* 86Box    A hypervisor and IBM PC system emulator that specializes in
+*          running old operating systems and software designed for IBM
+*          PC systems and compatibles from 1981 through fairly recent
+*          system designs based on the PCI bus.
+*
+*          This file is part of the 86Box distribution.
+*
+*          NV3 video overlay (PVIDEO) scanout
+*
+*          The overlay is never drawn into VRAM. Once the screen has been presented at vsync, the rows of the monitor's buffer that the overlay
+*          window covers have the YUV surface converted to RGB and put over them, so a video player only ever pays for converting what is visible.
+*
+* Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+*
+*          Copyright 2024-2025 Connor Hyde
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/pci.h>
+#include <86box/rom.h>
+#include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PVIDEO
+#include <86box/nv/vid_nv.h>
+#include <86box/nv/vid_nv3.h>
+/* The NEON kernel hasn't been checked against the scalar path on an ARM64 build yet, so ARM uses the scalar path unless this is defined */
+//#define NV3_RENDER_OVERLAY_NEON
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(NV3_RENDER_OVERLAY_NEON)
+#include <arm_neon.h>
+#endif
+
+#define NV3_RENDER_OVERLAY_MAX_WIDTH    2048                    // Most source pixels converted for one row
+#define NV3_RENDER_OVERLAY_STEP_ONE     0x800                   // 1:1 in PVIDEO_STEP_SIZE (1.11)
+
+/*
+    BT.601 studio range, in 10.6 fixed point so that the vector kernels can work in 16-bit lanes:
+    R = 1.164(Y - 16) + 1.596(V - 128)
+    G = 1.164(Y - 16) - 0.391(U - 128) - 0.813(V - 128)
+    B = 1.164(Y - 16) + 2.018(U - 128)
+*/
+#define NV3_RENDER_OVERLAY_Y            75
+#define NV3_RENDER_OVERLAY_V_R          102
+#define NV3_RENDER_OVERLAY_U_G          25
+#define NV3_RENDER_OVERLAY_V_G          52
+#define NV3_RENDER_OVERLAY_U_B          129
+
+static uint32_t nv3_render_overlay_line[NV3_RENDER_OVERLAY_MAX_WIDTH];
+
+static inline uint32_t nv3_render_overlay_clamp(int32_t value)
+{
+    value >>= 6;
+
+    if (value < 0)
+        return 0;
+    else if (value > 0xFF)
+        return 0xFF;
+
+    return (uint32_t)value;
+}
+
+/* Convert one pixel. The vector kernels give exactly the same result: they only saturate when this would clamp anyway */
+static inline uint32_t nv3_render_overlay_pixel(int32_t y, int32_t u, int32_t v)
+{
+    y = ((y - 16) * NV3_RENDER_OVERLAY_Y) + 32;
+    u -= 128;
+    v -= 128;
+
+    uint32_t r = nv3_render_overlay_clamp(y + (v * NV3_RENDER_OVERLAY_V_R));
+    uint32_t g = nv3_render_overlay_clamp(y - (u * NV3_RENDER_OVERLAY_U_G) - (v * NV3_RENDER_OVERLAY_V_G));
+    uint32_t b = nv3_render_overlay_clamp(y + (u * NV3_RENDER_OVERLAY_U_B));
+
+    return (r << 16) | (g << 8) | b;
+}
+
+/*
+    Convert pixels (which must be even) from a YUY2 (Y0 U Y1 V) or CCIR 601 (U Y0 V Y1) surface to x8r8g8b8.
+    8 pixels at a time with SSE2 (or NEON, with NV3_RENDER_OVERLAY_NEON), then the rest two at a time.
+*/
+static void nv3_render_overlay_convert(uint32_t* dst, const uint8_t* src, uint32_t pixels, bool yuy2)
+{
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+    const __m128i low_words = _mm_set1_epi32(0x0000FFFF);
+    const __m128i black = _mm_set1_epi16(16);
+    const __m128i grey = _mm_set1_epi16(128);
+    const __m128i round = _mm_set1_epi16(32);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; (i + 8) <= pixels; i += 8)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i*)&src[i << 1]);
+        __m128i luma = (yuy2) ? _mm_and_si128(in, low_bytes) : _mm_srli_epi16(in, 8);
+        __m128i chroma = (yuy2) ? _mm_srli_epi16(in, 8) : _mm_and_si128(in, low_bytes);
+
+        /* chroma is U V U V..., give every pixel its pair's U and V */
+        __m128i u = _mm_and_si128(chroma, low_words);
+        __m128i v = _mm_srli_epi32(chroma, 16);
+        u = _mm_sub_epi16(_mm_or_si128(u, _mm_slli_epi32(u, 16)), grey);
+        v = _mm_sub_epi16(_mm_or_si128(v, _mm_slli_epi32(v, 16)), grey);
+
+        __m128i y = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(luma, black), _mm_set1_epi16(NV3_RENDER_OVERLAY_Y)), round);
+
+        __m128i r = _mm_adds_epi16(y, _mm_mullo_epi16(v, _mm_set1_epi16(NV3_RENDER_OVERLAY_V_R)));
+        __m128i g = _mm_subs_epi16(_mm_subs_epi16(y, _mm_mullo_epi16(u, _mm_set1_epi16(NV3_RENDER_OVERLAY_U_G))),
+            _mm_mullo_epi16(v, _mm_set1_epi16(NV3_RENDER_OVERLAY_V_G)));
+        __m128i b = _mm_adds_epi16(y, _mm_mullo_epi16(u, _mm_set1_epi16(NV3_RENDER_OVERLAY_U_B)));
+
+        r = _mm_packus_epi16(_mm_srai_epi16(r, 6), zero);
+        g = _mm_packus_epi16(_mm_srai_epi16(g, 6), zero);
+        b = _mm_packus_epi16(_mm_srai_epi16(b, 6), zero);
+
+        /* B G R 0 in memory is x8r8g8b8 */
+        __m128i bg = _mm_unpacklo_epi8(b, g);
+        __m128i r0 = _mm_unpacklo_epi8(r, zero);
+
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_unpacklo_epi16(bg, r0));
+        _mm_storeu_si128((__m128i*)&dst[i + 4], _mm_unpackhi_epi16(bg, r0));
+    }
+#elif defined(__ARM_NEON) && defined(NV3_RENDER_OVERLAY_NEON)
+    const uint16x8_t low_bytes = vdupq_n_u16(0x00FF);
+    const uint32x4_t low_words = vdupq_n_u32(0x0000FFFF);
+    const int16x8_t black = vdupq_n_s16(16);
+    const int16x8_t grey = vdupq_n_s16(128);
+    const int16x8_t round = vdupq_n_s16(32);
+
+    for (; (i + 8) <= pixels; i += 8)
+    {
+        uint16x8_t in = vreinterpretq_u16_u8(vld1q_u8(&src[i << 1]));
+        uint16x8_t luma = (yuy2) ? vandq_u16(in, low_bytes) : vshrq_n_u16(in, 8);
+        uint16x8_t chroma = (yuy2) ? vshrq_n_u16(in, 8) : vandq_u16(in, low_bytes);
+
+        /* chroma is U V U V..., give every pixel its pair's U and V */
+        uint32x4_t u_pair = vandq_u32(vreinterpretq_u32_u16(chroma), low_words);
+        uint32x4_t v_pair = vshrq_n_u32(vreinterpretq_u32_u16(chroma), 16);
+        int16x8_t u = vsubq_s16(vreinterpretq_s16_u32(vorrq_u32(u_pair, vshlq_n_u32(u_pair, 16))), grey);
+        int16x8_t v = vsubq_s16(vreinterpretq_s16_u32(vorrq_u32(v_pair, vshlq_n_u32(v_pair, 16))), grey);
+
+        int16x8_t y = vaddq_s16(vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(luma), black), NV3_RENDER_OVERLAY_Y), round);
+
+        int16x8_t r = vqaddq_s16(y, vmulq_n_s16(v, NV3_RENDER_OVERLAY_V_R));
+        int16x8_t g = vqsubq_s16(vqsubq_s16(y, vmulq_n_s16(u, NV3_RENDER_OVERLAY_U_G)), vmulq_n_s16(v, NV3_RENDER_OVERLAY_V_G));
+        int16x8_t b = vqaddq_s16(y, vmulq_n_s16(u, NV3_RENDER_OVERLAY_U_B));
+
+        uint8x8x4_t out;
+        out.val[0] = vqmovun_s16(vshrq_n_s16(b, 6));
+        out.val[1] = vqmovun_s16(vshrq_n_s16(g, 6));
+        out.val[2] = vqmovun_s16(vshrq_n_s16(r, 6));
+        out.val[3] = vdup_n_u8(0);
+
+        vst4_u8((uint8_t*)&dst[i], out);
+    }
+#endif
+
+    for (; (i + 2) <= pixels; i += 2)
+    {
+        const uint8_t* pair = &src[i << 1];
+        int32_t y0 = (yuy2) ? pair[0] : pair[1];
+        int32_t y1 = (yuy2) ? pair[2] : pair[3];
+        int32_t u = (yuy2) ? pair[1] : pair[0];
+        int32_t v = (yuy2) ? pair[3] : pair[2];
+
+        dst[i] = nv3_render_overlay_pixel(y0, u, v);
+        dst[i + 1] = nv3_render_overlay_pixel(y1, u, v);
+    }
+}
+
+/*
+    Put the overlay over the parts of the monitor's buffer that it covers. Called at vsync once the screen has been presented.
+    Doing it again over the same frame gives the same result, because the colour key is tested against VRAM rather than what's on the monitor.
+*/
+void nv3_render_overlay(svga_t* svga, uint32_t display_start, uint32_t pitch, int32_t width, int32_t height)
+{
+    nv3_pvideo_t* pvideo = &nv3->pvideo;
+
+    if (!((pvideo->overlay_settings >> NV3_PVIDEO_OVERLAY_VIDEO_IS_ON) & 0x01)
+    || !((nv3->pmc.enable >> NV3_PMC_ENABLE_PVIDEO) & NV3_PMC_ENABLE_PVIDEO_ENABLED))
+        return;
+
+    int32_t left = pvideo->window_start.x;
+    int32_t top = pvideo->window_start.y;
+    int32_t right = left + pvideo->window_size.w - 1;
+    int32_t bottom = top + pvideo->window_size.h - 1;
+
+    if (right >= width) right = width - 1;
+    if (bottom >= height) bottom = height - 1;
+    if ((right - left + 1) > NV3_RENDER_OVERLAY_MAX_WIDTH) right = left + NV3_RENDER_OVERLAY_MAX_WIDTH - 1;
+
+    if (left > right
+    || top > bottom)
+        return;
+
+    uint32_t buffer = pvideo->oe_state & 0x01;
+    uint32_t base = pvideo->buffer_start[buffer] + pvideo->buffer_offset[buffer];
+    uint32_t src_pitch = pvideo->buffer_pitch[buffer];
+    uint32_t step = (pvideo->step_size) ? pvideo->step_size : NV3_RENDER_OVERLAY_STEP_ONE;
+    bool yuy2 = (pvideo->overlay_settings >> NV3_PVIDEO_OVERLAY_FORMAT) & 0x01;
+    bool keyed = (pvideo->overlay_settings >> NV3_PVIDEO_OVERLAY_KEY_ENABLED) & 0x01;
+    uint32_t bytes = (svga->bpp + 1) >> 3;
+    uint32_t key_mask = (bytes == 4) ? 0xFFFFFF : ((1u << (bytes << 3)) - 1);
+    uint32_t key = pvideo->key & key_mask;
+
+    /* Only convert as much of each source row as the window shows, rounded up to whole YUV pairs */
+    uint32_t count = (right - left) + 1;
+    uint32_t src_pixels = ((((count - 1) * step) >> 11) + 2) & ~1;
+
+    if (src_pixels > NV3_RENDER_OVERLAY_MAX_WIDTH)
+        src_pixels = NV3_RENDER_OVERLAY_MAX_WIDTH;
+
+    for (int32_t y = top; y <= bottom; y++)
+    {
+        uint32_t src_row = ((y - pvideo->window_start.y) * step) >> 11;
+        uint32_t src_address = base + (src_row * src_pitch);
+
+        /* Off the end of VRAM */
+        if ((src_address + (src_pixels << 1)) > svga->vram_max)
+            continue;
+
+        nv3_render_overlay_convert(nv3_render_overlay_line, &svga->vram[src_address], src_pixels, yuy2);
+
+        uint32_t* p = &svga->monitor->target_buffer->line[y][left];
+        uint32_t fb_address = display_start + (y * pitch) + (left * bytes);
+
+        /* Most players don't scale and let the overlay cover the whole window */
+        if (!keyed
+        && step == NV3_RENDER_OVERLAY_STEP_ONE)
+        {
+            memcpy(p, nv3_render_overlay_line, count << 2);
+            continue;
+        }
+
+        uint32_t src_x = 0;
+
+        for (uint32_t x = 0; x < count; x++, src_x += step, fb_address += bytes)
+        {
+            uint32_t column = src_x >> 11;
+
+            if (column >= src_pixels)
+                column = src_pixels - 1;
+
+            if (keyed)
+            {
+                uint32_t fb_pixel = 0;
+
+                fb_address &= svga->vram_display_mask;
+
+                switch (bytes)
+                {
+                    case 1:
+                        fb_pixel = svga->vram[fb_address];
+                        break;
+                    case 2:
+                        fb_pixel = *(uint16_t*)&svga->vram[fb_address];
+                        break;
+                    case 4:
+                        fb_pixel = *(uint32_t*)&svga->vram[fb_address];
+                        break;
+                }
+
+                if ((fb_pixel & key_mask) != key)
+                    continue;
+            }
+
+            p[x] = nv3_render_overlay_line[column];
+        }
+    }
+}
@@ -0,0 +1,232 @@
+/*
+* 86Box    A hypervisor and IBM PC system emulator that specializes in
+*          running old operating systems and software designed for IBM
+*          PC systems and compatibles from 1981 through fairly recent
+*          system designs based on the PCI bus.
+*
+*          This file is part of the 86Box distribution.
+*
+*          NV3 pixel pipelines: span routines specialised for the PGRAPH state
+*
+*          Every combination of pixel size, chroma key, 15bpp alpha test and pattern transparency gets its own write-back routine,
+*          generated at compile time, so the per-pixel loop is straight-line code. The ROP itself is done a chunk at a time by the
+*          row kernels from the video stdlib.
+*
+* Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+*
+*          Copyright 2024-2025 Connor Hyde
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/pci.h>
+#include <86box/rom.h>
+#include <86box/video.h>
+#include <86box/nv/vid_nv.h>
+#include <86box/nv/vid_nv3.h>
+#include <86box/utils/video_stdlib.h>
+
+/* How many pixels a pipeline does at once */
+#define NV3_RENDER_PIPELINE_CHUNK       64
+
+/*
+    Generate a write-back routine. The tests are compile time constants, so the ones that are turned off don't exist in the loop at all.
+    chroma: skip source pixels that are the chroma key colour
+    alpha: skip source pixels with alpha=0 (x1r5g5b5 only)
+    pattern: skip pixels where the pattern colour is transparent
+*/
+#define NV3_RENDER_PIPELINE_WRITER(name, type, chroma, alpha, pattern)                                                      \
+static void name(const nv3_render_span_state_t* state, uint8_t* dst, const uint8_t* result, const uint8_t* src,            \
+    uint64_t pattern_row, uint32_t x_mask, int32_t x_start, uint32_t count)                                                 \
+{                                                                                                                           \
+    type* dst_pixels = (type*)dst;                                                                                          \
+    const type* result_pixels = (const type*)result;                                                                        \
+    const type* src_pixels = (const type*)src;                                                                              \
+                                                                                                                            \
+    for (uint32_t i = 0; i < count; i++)                                                                                    \
+    {                                                                                                                       \
+        if (chroma && (uint32_t)src_pixels[i] == state->chroma_color)                                                       \
+            continue;                                                                                                       \
+                                                                                                                            \
+        if (alpha && !(src_pixels[i] & 0x8000))                                                                             \
+            continue;                                                                                                       \
+                                                                                                                            \
+        if (pattern && !state->pattern_opaque[(pattern_row >> ((x_start + i) & x_mask)) & 0x01])                            \
+            continue;                                                                                                       \
+                                                                                                                            \
+        dst_pixels[i] = result_pixels[i];                                                                                   \
+    }                                                                                                                       \
+}
+
+/*
+    Every test combination for one pixel size. The variant with no tests at all is never used (the kernel writes straight to VRAM instead),
+    but it keeps the table simple.
+*/
+#define NV3_RENDER_PIPELINE_WRITERS(bits, type)                                                                             \
+    NV3_RENDER_PIPELINE_WRITER(nv3_render_pipeline_write_##bits##_none, type, false, false, false)                         \
+    NV3_RENDER_PIPELINE_WRITER(nv3_render_pipeline_write_##bits##_p, type, false, false, true)                             \
+    NV3_RENDER_PIPELINE_WRITER(nv3_render_pipeline_write_##bits##_a, type, false, true, false)                             \
+    NV3_RENDER_PIPELINE_WRITER(nv3_render_pipeline_write_##bits##_ap, type, false, true, true)                             \
+    NV3_RENDER_PIPELINE_WRITER(nv3_render_pipeline_write_##bits##_c, type, true, false, false)                             \
+    NV3_RENDER_PIPELINE_WRITER(nv3_render_pipeline_write_##bits##_cp, type, true, false, true)                             \
+    NV3_RENDER_PIPELINE_WRITER(nv3_render_pipeline_write_##bits##_ca, type, true, true, false)                             \
+    NV3_RENDER_PIPELINE_WRITER(nv3_render_pipeline_write_##bits##_cap, type, true, true, true)
+
+NV3_RENDER_PIPELINE_WRITERS(8, uint8_t)
+NV3_RENDER_PIPELINE_WRITERS(16, uint16_t)
+NV3_RENDER_PIPELINE_WRITERS(32, uint32_t)
+
+#define NV3_RENDER_PIPELINE_WRITER_TABLE(bits)                                                                              \
+    {                                                                                                                       \
+        nv3_render_pipeline_write_##bits##_none, nv3_render_pipeline_write_##bits##_p,                                      \
+        nv3_render_pipeline_write_##bits##_a, nv3_render_pipeline_write_##bits##_ap,                                        \
+        nv3_render_pipeline_write_##bits##_c, nv3_render_pipeline_write_##bits##_cp,                                        \
+        nv3_render_pipeline_write_##bits##_ca, nv3_render_pipeline_write_##bits##_cap,                                      \
+    }
+
+/* Indexed by [pixel size][(chroma << 2) | (alpha << 1) | pattern] */
+static const nv3_render_pipeline_write_t nv3_render_pipeline_writers[3][8] =
+{
+    NV3_RENDER_PIPELINE_WRITER_TABLE(8),
+    NV3_RENDER_PIPELINE_WRITER_TABLE(16),
+    NV3_RENDER_PIPELINE_WRITER_TABLE(32),
+};
+
+#undef NV3_RENDER_PIPELINE_WRITER_TABLE
+#undef NV3_RENDER_PIPELINE_WRITERS
+#undef NV3_RENDER_PIPELINE_WRITER
+
+/* Put together the pipeline for a framebuffer bpp, ROP, and set of per-pixel tests */
+void nv3_render_pipeline_build(nv3_render_pipeline_t* pipeline, uint32_t bpp, uint8_t rop, bool chroma, bool alpha, bool pattern)
+{
+    uint32_t size = 0;
+
+    switch (bpp)
+    {
+        case 8:
+            size = 0;
+            pipeline->bytes = 1;
+            alpha = false;  // only x1r5g5b5 has an alpha bit
+            break;
+        case 15:
+        case 16:
+            size = 1;
+            pipeline->bytes = 2;
+            break;
+        default:
+            size = 2;
+            pipeline->bytes = 4;
+            alpha = false;  // only x1r5g5b5 has an alpha bit
+            break;
+    }
+
+    /* The high nibble of a ternary ROP is the result when the pattern bit is 1, the low nibble when it is 0 */
+    pipeline->uses_pattern = (((rop >> 4) & 0x0F) != (rop & 0x0F));
+    pipeline->rop_kernel = video_rop_get_row_kernel(rop);
+
+    if (!chroma && !alpha && !pattern)
+        pipeline->write = NULL;
+    else
+        pipeline->write = nv3_render_pipeline_writers[size][(chroma << 2) | (alpha << 1) | pattern];
+}
+
+/* Copy size bytes out of VRAM, wrapping around the end of it */
+static inline void nv3_render_pipeline_gather(uint8_t* dst, uint32_t addr, uint32_t size)
+{
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+
+    if ((addr + size - 1) <= vram_mask)
+        memcpy(dst, &nv3->nvbase.svga.vram[addr], size);
+    else
+    {
+        for (uint32_t i = 0; i < size; i++)
+            dst[i] = nv3->nvbase.svga.vram[(addr + i) & vram_mask];
+    }
+}
+
+/* Copy size bytes into VRAM, wrapping around the end of it */
+static inline void nv3_render_pipeline_scatter(const uint8_t* src, uint32_t addr, uint32_t size)
+{
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+
+    for (uint32_t i = 0; i < size; i++)
+        nv3->nvbase.svga.vram[(addr + i) & vram_mask] = src[i];
+}
+
+/*
+    Run a pipeline over count pixels of a row, starting at dst_addr_vram.
+    src is either one pixel that is used for the whole row (src_solid), or the VRAM address of a row of source pixels.
+    If src_buffer is not NULL, the source pixels come from there instead (e.g. pixels the CPU sent), and src is ignored.
+    The row is done a chunk at a time, and each chunk of the source is read before anything is written, so the source and destination
+    can overlap as long as backwards is set when the destination is after the source.
+*/
+void nv3_render_pipeline_run(const nv3_render_pipeline_t* pipeline, nv3_render_span_state_t* state, uint32_t dst_addr_vram, uint32_t src,
+    const uint8_t* src_buffer, bool src_solid, bool backwards, int32_t x_start, uint32_t count, uint64_t pattern_row, uint32_t x_mask)
+{
+    /* Big enough for a chunk at 32bpp */
+    uint8_t src_row[NV3_RENDER_PIPELINE_CHUNK * 4];
+    uint8_t pattern[NV3_RENDER_PIPELINE_CHUNK * 4] = {0};
+    uint8_t dst_row[NV3_RENDER_PIPELINE_CHUNK * 4];
+    uint8_t result[NV3_RENDER_PIPELINE_CHUNK * 4];
+    uint32_t bytes = pipeline->bytes;
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+    uint32_t chunks = (count + NV3_RENDER_PIPELINE_CHUNK - 1) / NV3_RENDER_PIPELINE_CHUNK;
+
+    /* A solid source colour is the same for the whole span, so only expand it once */
+    if (src_solid)
+        video_rop_fill_row(src_row, src, bytes << 3, (count < NV3_RENDER_PIPELINE_CHUNK) ? count : NV3_RENDER_PIPELINE_CHUNK);
+
+    for (uint32_t n = 0; n < chunks; n++)
+    {
+        uint32_t chunk_index = (backwards) ? (chunks - 1 - n) : n;
+        uint32_t done = chunk_index * NV3_RENDER_PIPELINE_CHUNK;
+        uint32_t chunk = count - done;
+
+        if (chunk > NV3_RENDER_PIPELINE_CHUNK)
+            chunk = NV3_RENDER_PIPELINE_CHUNK;
+
+        uint32_t chunk_bytes = chunk * bytes;
+        uint32_t chunk_dst_addr = (dst_addr_vram + (done * bytes)) & vram_mask;
+        bool dst_wraps = (chunk_dst_addr + chunk_bytes - 1) > vram_mask;
+
+        const uint8_t* src_chunk = src_row;
+
+        if (src_buffer)
+            src_chunk = &src_buffer[done * bytes];
+        else if (!src_solid)
+            nv3_render_pipeline_gather(src_row, (src + (done * bytes)) & vram_mask, chunk_bytes);
+
+        if (pipeline->uses_pattern)
+        {
+            for (uint32_t i = 0; i < chunk; i++)
+            {
+                bool use_color1 = (pattern_row >> ((x_start + done + i) & x_mask)) & 0x01;
+                memcpy(&pattern[i * bytes], &state->pattern_color[use_color1], bytes);
+            }
+        }
+
+        /* Work on VRAM directly unless the chunk wraps around the end of it */
+        uint8_t* dst = (dst_wraps) ? dst_row : &nv3->nvbase.svga.vram[chunk_dst_addr];
+
+        if (dst_wraps)
+            nv3_render_pipeline_gather(dst_row, chunk_dst_addr, chunk_bytes);
+
+        if (!pipeline->write)
+            pipeline->rop_kernel(dst, src_chunk, pattern, chunk_bytes);
+        else
+        {
+            memcpy(result, dst, chunk_bytes);
+            pipeline->rop_kernel(result, src_chunk, pattern, chunk_bytes);
+            pipeline->write(state, dst, result, src_chunk, pattern_row, x_mask, x_start + done, chunk);
+        }
+
+        if (dst_wraps)
+            nv3_render_pipeline_scatter(dst_row, chunk_dst_addr, chunk_bytes);
+    }
+}
@@ -31,325 +31,257 @@
 
 void nv3_render_rect(nv3_position_16_t position, nv3_size_16_t size, uint32_t color, nv3_grobj_t grobj)
 {
-    nv3_position_16_t current_pos = {0};
+    nv3_render_span_state_t state;
 
-    for (int32_t y = position.y; y < (position.y + size.h); y++)
-    {
-        current_pos.y = y; 
+    nv3_render_span_begin(&state, grobj);
 
-        for (int32_t x = position.x; x < (position.x + size.w); x++)
-        {
-            current_pos.x = x;
+    for (int32_t y = position.y; y < (position.y + size.h); y++)
+        nv3_render_span_fill(&state, position.x, y, size.w, color);
 
-            nv3_render_write_pixel(current_pos, color, grobj);
-        }
-    }
+    nv3_render_span_end(&state);
 }
 
 /* Render GDI-B clipped rectangle */
 void nv3_render_rect_clipped(nv3_clip_16_t clip, uint32_t color, nv3_grobj_t grobj)
 {
-    nv3_position_16_t current_pos = {0};
+    /* compare against the global clip too, once, instead of for every pixel */
+    int32_t left = (clip.left > nv3->pgraph.win95_gdi_text.clip_b.left) ? clip.left : nv3->pgraph.win95_gdi_text.clip_b.left;
+    int32_t top = (clip.top > nv3->pgraph.win95_gdi_text.clip_b.top) ? clip.top : nv3->pgraph.win95_gdi_text.clip_b.top;
 
-    for (int32_t y = clip.top; y < clip.bottom; y++)
-    {
-        current_pos.y = y; 
-
-        for (int32_t x = clip.left; x < clip.right; x++)
-        {
-            current_pos.x = x;
+    /* The rect excludes right/bottom, the global clip includes them */
+    int32_t right = ((clip.right - 1) < nv3->pgraph.win95_gdi_text.clip_b.right) ? (clip.right - 1) : nv3->pgraph.win95_gdi_text.clip_b.right;
+    int32_t bottom = ((clip.bottom - 1) < nv3->pgraph.win95_gdi_text.clip_b.bottom) ? (clip.bottom - 1) : nv3->pgraph.win95_gdi_text.clip_b.bottom;
 
-            /* compare against the global clip too */
-            if (current_pos.x >= nv3->pgraph.win95_gdi_text.clip_b.left
-            && current_pos.x <= nv3->pgraph.win95_gdi_text.clip_b.right
-            && current_pos.y >= nv3->pgraph.win95_gdi_text.clip_b.top
-            && current_pos.y <= nv3->pgraph.win95_gdi_text.clip_b.bottom)
-            {
-                nv3_render_write_pixel(current_pos, color, grobj);
-            }
-        }
-    }
-}
-
-void nv3_render_gdi_transparent_bitmap_blit(bool bit, bool clip, uint32_t color, nv3_grobj_t grobj)
-{
-    /* If the bit is set, and cliping is enabled (Type D) tru and lcip */
-    if (bit && clip)
-    {
-        /* Turn the bit off if we need to clip (Type D ) */
-        if (nv3->pgraph.win95_gdi_text_current_position.x < nv3->pgraph.win95_gdi_text.clip_d.left
-        || nv3->pgraph.win95_gdi_text_current_position.x > nv3->pgraph.win95_gdi_text.clip_d.right
-        || nv3->pgraph.win95_gdi_text_current_position.y < nv3->pgraph.win95_gdi_text.clip_d.top
-        || nv3->pgraph.win95_gdi_text_current_position.y > nv3->pgraph.win95_gdi_text.clip_d.bottom)
-        {
-            bit = false; 
-        }   
-
-        /* 
-           Also clip if we are outside of the SIZE_OUT range 
-           We only need to do this in one direction just to get rid of the crud sent by NV
-        */
-        uint32_t clip_x = nv3->pgraph.win95_gdi_text.point_d.x + (nv3->pgraph.win95_gdi_text.size_out_d.w);
-        uint32_t clip_y = nv3->pgraph.win95_gdi_text.point_d.y + (nv3->pgraph.win95_gdi_text.size_out_d.h);
-
-        if (nv3->pgraph.win95_gdi_text_current_position.x >= clip_x
-        || nv3->pgraph.win95_gdi_text_current_position.y >= clip_y)
-            bit = false; 
-    }
-
-    /* We don't need to and it, because it seems the Riva only uses non-packed bpp formats for this class */
-    if (bit)
-        nv3_render_write_pixel(nv3->pgraph.win95_gdi_text_current_position, color, grobj);
-
-    /* 
-       Check if we've reached the bottom
-       Because we check the bits in reverse, we go forward (bits 7,6,5 were set for a 1x3 bitmap)
-    */
-
-    uint32_t end_x = (clip) ? nv3->pgraph.win95_gdi_text.point_d.x + nv3->pgraph.win95_gdi_text.size_in_d.w : nv3->pgraph.win95_gdi_text.point_c.x + nv3->pgraph.win95_gdi_text.size_c.w;
+    if (left > right
+    || top > bottom)
+        return;
 
-    nv3->pgraph.win95_gdi_text_current_position.x++;
+    nv3_render_span_state_t state;
 
-    if (nv3->pgraph.win95_gdi_text_current_position.x >= end_x)
-    {
-        nv3->pgraph.win95_gdi_text_current_position.y++; 
+    nv3_render_span_begin(&state, grobj);
 
-        if (!clip)
-            nv3->pgraph.win95_gdi_text_current_position.x = nv3->pgraph.win95_gdi_text.point_c.x;
-        else 
-            nv3->pgraph.win95_gdi_text_current_position.x = nv3->pgraph.win95_gdi_text.point_d.x;
-    }
+    for (int32_t y = top; y <= bottom; y++)
+        nv3_render_span_fill(&state, left, y, (right - left) + 1, color);
 
+    nv3_render_span_end(&state);
 }
 
-/* Originally written 23 March 2025, but then, redone, properly, on 30 March 2025 */
-void nv3_render_gdi_transparent_bitmap(bool clip, uint32_t color, uint32_t bitmap_data, nv3_grobj_t grobj)
-{
-    /* 
-        First, we need to figure out how many bits we have left.
-        If we have less than 32, don't process all of the bits. 
-
-        Bits are processed in the following order: [7-0] [15-8] [23-16] [31-24]
-        TODO: Store this somewhere, so it doesn't need to be recalculated.
-
-        We store a global bit count for this purpose.
-    */
-
-    uint32_t bitmap_size = (clip) ? nv3->pgraph.win95_gdi_text.size_in_d.w * nv3->pgraph.win95_gdi_text.size_in_d.h : nv3->pgraph.win95_gdi_text.size_c.w * nv3->pgraph.win95_gdi_text.size_c.h;
-    uint32_t bits_remaining_in_bitmap = bitmap_size - nv3->pgraph.win95_gdi_text_bit_count;
+/* 
+    GDI text.
+    The bitmap is sent a dword at a time, and the rows of the glyph follow straight on from each other, so a byte can have bits from two rows in it.
+    Each byte (or the part of it that is in one row) is turned into runs of pixels with a lookup table, and every run is drawn with one span,
+    with the clipping worked out once for the row instead of for every pixel.
+*/
 
-    /* we have to interpret every bit in reverse bit order but in the right byte order */
+/* The runs of set bits in a byte. The first pixel is the top bit, like GDI */
+typedef struct nv3_render_gdi_runs_s
+{
+    uint8_t count;
+    uint8_t start[4];                   // A byte can't have more than 4 runs (10101010)
+    uint8_t length[4];
+} nv3_render_gdi_runs_t;
 
-    bool current_bit = false;
+static nv3_render_gdi_runs_t nv3_render_gdi_runs[256];
+static bool nv3_render_gdi_runs_built = false;
 
-    /* Start by rendering bits 7 through 0 */
-    for (int32_t bit = 7; bit >= 0; bit--)
+/* Everything about the glyph being drawn that doesn't change from bit to bit */
+typedef struct nv3_render_gdi_glyph_s
+{
+    int32_t origin_x;                   // x of the first pixel of every row
+    int32_t end_x;                      // x after the last pixel of every row
+    uint32_t size;                      // Number of bits in the whole bitmap
+
+    /* Nothing outside of these is drawn (inclusive). The global clip is done by the span rasteriser */
+    int32_t clip_left;
+    int32_t clip_top;
+    int32_t clip_right;
+    int32_t clip_bottom;
+
+    bool opaque;                        // Clear bits are drawn in color0 (Type E), instead of being skipped
+    uint32_t color0;
+    uint32_t color1;
+} nv3_render_gdi_glyph_t;
+
+static void nv3_render_gdi_build_runs(void)
+{
+    for (uint32_t byte = 0; byte < 256; byte++)
     {
-        current_bit = (bitmap_data >> bit) & 0x01;
+        nv3_render_gdi_runs_t* runs = &nv3_render_gdi_runs[byte];
 
-        nv3_render_gdi_transparent_bitmap_blit(current_bit, clip, color, grobj);
-        nv3->pgraph.win95_gdi_text_bit_count++;
-        bits_remaining_in_bitmap--;
+        runs->count = 0;
 
-        if (!bits_remaining_in_bitmap)
-            break;
+        for (uint32_t pixel = 0; pixel < 8; pixel++)
+        {
+            if (!((byte >> (7 - pixel)) & 0x01))
+                continue;
+
+            /* Carry on with the run if the pixel before this one was set too */
+            if (pixel > 0 
+            && ((byte >> (8 - pixel)) & 0x01))
+                runs->length[runs->count - 1]++;
+            else
+            {
+                runs->start[runs->count] = pixel;
+                runs->length[runs->count] = 1;
+                runs->count++;
+            }
+        }
     }
 
-    /* IF we're done, let's return */
-    if (!bits_remaining_in_bitmap)
-        return;
-
-    /* Now for 15 through 8 */
-    for (int32_t bit = 15; bit >= 8; bit--)
-    {
-        current_bit = (bitmap_data >> bit) & 0x01;
-
-        nv3_render_gdi_transparent_bitmap_blit(current_bit, clip, color, grobj);
-        nv3->pgraph.win95_gdi_text_bit_count++;
-        bits_remaining_in_bitmap--;
-
-        if (!bits_remaining_in_bitmap)
-            break;
-    }
+    nv3_render_gdi_runs_built = true;
+}
 
-    /* IF we're done, let's return */
-    if (!bits_remaining_in_bitmap)
-        return;
+/* Draw the runs of a byte that are between pixel first and pixel last of it (inclusive). x is where pixel 0 of the byte goes */
+static void nv3_render_gdi_draw_runs(nv3_render_span_state_t* state, uint32_t bits, int32_t x, int32_t y, int32_t first, int32_t last, uint32_t color)
+{
+    const nv3_render_gdi_runs_t* runs = &nv3_render_gdi_runs[bits];
 
-    /* Now for 23 through 16 */
-    for (int32_t bit = 23; bit >= 16; bit--)
+    for (uint32_t run = 0; run < runs->count; run++)
     {
-        current_bit = (bitmap_data >> bit) & 0x01;
+        int32_t start = runs->start[run];
+        int32_t end = start + runs->length[run] - 1;
 
-        nv3_render_gdi_transparent_bitmap_blit(current_bit, clip, color, grobj);
-        nv3->pgraph.win95_gdi_text_bit_count++;
-        bits_remaining_in_bitmap--;
+        if (start < first) start = first;
+        if (end > last) end = last;
 
-        if (!bits_remaining_in_bitmap)
-            break;
+        if (start <= end)
+            nv3_render_span_fill(state, x + start, y, (end - start) + 1, color);
     }
+}
 
-    /* IF we're done, let's return */
-    if (!bits_remaining_in_bitmap)
+/* Draw count pixels of one row of the glyph at (x, y). bits has the pixels in its top count bits and nothing else */
+static void nv3_render_gdi_row(nv3_render_span_state_t* state, const nv3_render_gdi_glyph_t* glyph, int32_t x, int32_t y, uint32_t count, uint32_t bits)
+{
+    if (y < glyph->clip_top
+    || y > glyph->clip_bottom)
         return;
 
-    /* Now for 31 through 24 */
-    for (int32_t bit = 31; bit >= 24; bit--)
-    {
-        current_bit = (bitmap_data >> bit) & 0x01;
-
-        nv3_render_gdi_transparent_bitmap_blit(current_bit, clip, color, grobj);
-        nv3->pgraph.win95_gdi_text_bit_count++;
-        bits_remaining_in_bitmap--;
-
-        if (!bits_remaining_in_bitmap)
-            break;
-    }
+    int32_t first = (x < glyph->clip_left) ? (glyph->clip_left - x) : 0;
+    int32_t last = ((x + (int32_t)count - 1) > glyph->clip_right) ? (glyph->clip_right - x) : ((int32_t)count - 1);
 
-    /* IF we're done, let's return */
-    if (!bits_remaining_in_bitmap)
+    if (first > last)
         return;
 
+    nv3_render_gdi_draw_runs(state, bits, x, y, first, last, glyph->color1);
+
+    if (glyph->opaque)
+        nv3_render_gdi_draw_runs(state, (~bits) & (0xFF00 >> count) & 0xFF, x, y, first, last, glyph->color0);
 }
 
-void nv3_render_gdi_1bpp_bitmap_blit(bool bit, uint32_t color0, uint32_t color1, nv3_grobj_t grobj)
+/* Draw one dword of a glyph, carrying on from wherever the last one got to */
+static void nv3_render_gdi_bits(nv3_render_span_state_t* state, const nv3_render_gdi_glyph_t* glyph, uint32_t bitmap_data)
 {
-    /* We can't force the bit off because this is a 1bpp bitmap */
-    bool skip = false; 
-
-    /* For Type E, always clip */
-        /* Turn the bit off if we need to clip (Type D ) */
-    if (nv3->pgraph.win95_gdi_text_current_position.x < nv3->pgraph.win95_gdi_text.clip_e.left
-    || nv3->pgraph.win95_gdi_text_current_position.x > nv3->pgraph.win95_gdi_text.clip_e.right
-    || nv3->pgraph.win95_gdi_text_current_position.y < nv3->pgraph.win95_gdi_text.clip_e.top
-    || nv3->pgraph.win95_gdi_text_current_position.y > nv3->pgraph.win95_gdi_text.clip_e.bottom)
-    {
-        skip = true; 
-    }   
-
-    /* 
-        Also clip if we are outside of the SIZE_OUT range 
-        We only need to do this in one direction just to get rid of the crud sent by NV
-    */
-    uint32_t clip_x = nv3->pgraph.win95_gdi_text.point_e.x + (nv3->pgraph.win95_gdi_text.size_out_e.w);
-    uint32_t clip_y = nv3->pgraph.win95_gdi_text.point_e.y + (nv3->pgraph.win95_gdi_text.size_out_e.h);
-
-    if (nv3->pgraph.win95_gdi_text_current_position.x >= clip_x
-    || nv3->pgraph.win95_gdi_text_current_position.y >= clip_y)
-        skip = true;
-
-    /* We don't need to and it, because it seems the Riva only uses non-packed bpp formats for this class */
-    if (!skip)
-    {
-        if (bit)
-            nv3_render_write_pixel(nv3->pgraph.win95_gdi_text_current_position, nv3->pgraph.win95_gdi_text.color1_e, grobj);
-        else 
-            nv3_render_write_pixel(nv3->pgraph.win95_gdi_text_current_position, nv3->pgraph.win95_gdi_text.color0_e, grobj);
-    }
-       
+    nv3_position_16_t* position = &nv3->pgraph.win95_gdi_text_current_position;
 
-    /* 
-       Check if we've reached the bottom, if so, advance to the next horizontal lin
-       Because we check the bits in reverse, we go forward (bits 7,6,5 were set for a 1x3 bitmap)
-    */
+    if (!nv3_render_gdi_runs_built)
+        nv3_render_gdi_build_runs();
 
-    uint32_t end_x = nv3->pgraph.win95_gdi_text.point_e.x + nv3->pgraph.win95_gdi_text.size_in_e.w;
+    /* If we have less than 32 bits left, don't process all of the bits */
+    if (nv3->pgraph.win95_gdi_text_bit_count >= glyph->size)
+        return;
 
-    nv3->pgraph.win95_gdi_text_current_position.x++;
+    uint32_t bits_remaining = glyph->size - nv3->pgraph.win95_gdi_text_bit_count;
 
-    if (nv3->pgraph.win95_gdi_text_current_position.x >= end_x)
+    /* Bits are processed in the following order: [7-0] [15-8] [23-16] [31-24] */
+    for (uint32_t byte_index = 0; byte_index < 4 && bits_remaining; byte_index++)
     {
-        nv3->pgraph.win95_gdi_text_current_position.y++; 
-        nv3->pgraph.win95_gdi_text_current_position.x = nv3->pgraph.win95_gdi_text.point_e.x;
-    }
-}
-
-
-/* Originally written 23 March 2025, but then, redone, properly, on 30 March 2025 */
-void nv3_render_gdi_1bpp_bitmap(uint32_t color0, uint32_t color1, uint32_t bitmap_data, nv3_grobj_t grobj)
-{
-    /* 
-        First, we need to figure out how many bits we have left.
-        If we have less than 32, don't process all of the bits. 
+        uint32_t byte = (bitmap_data >> (byte_index << 3)) & 0xFF;
+        uint32_t consumed = 0;
 
-        Bits are processed in the following order: [7-0] [15-8] [23-16] [31-24]
-        TODO: Store this somewhere, so it doesn't need to be recalculated.
-
-        We store a global bit count for this purpose.
-    */
+        while (consumed < 8 && bits_remaining)
+        {
+            int32_t x = position->x;
+            int32_t y = position->y;
+            int32_t row_left = glyph->end_x - x;
+            uint32_t count = 8 - consumed;
 
-    uint32_t bitmap_size = nv3->pgraph.win95_gdi_text.size_in_e.w * nv3->pgraph.win95_gdi_text.size_in_e.h;
-    uint32_t bits_remaining_in_bitmap = bitmap_size - nv3->pgraph.win95_gdi_text_bit_count;
+            /* Every pixel is a row of its own if the glyph is 0 wide */
+            if (row_left < 1)
+                row_left = 1;
 
-    /* we have to interpret every bit in reverse bit order but in the right byte order */
+            if (count > (uint32_t)row_left) count = row_left;
+            if (count > bits_remaining) count = bits_remaining;
 
-    bool current_bit = false;
+            /* The bits for this row, moved up to the top of the byte, with the ones after them cleared */
+            uint32_t bits = (byte << consumed) & (0xFF00 >> count) & 0xFF;
 
-    /* Start by rendering bits 7 through 0 */
-    for (int32_t bit = 7; bit >= 0; bit--)
-    {
-        current_bit = (bitmap_data >> bit) & 0x01;
+            nv3_render_gdi_row(state, glyph, x, y, count, bits);
 
-        nv3_render_gdi_1bpp_bitmap_blit(current_bit, color0, color1, grobj);
-        nv3->pgraph.win95_gdi_text_bit_count++;
-        bits_remaining_in_bitmap--;
+            consumed += count;
+            bits_remaining -= count;
+            nv3->pgraph.win95_gdi_text_bit_count += count;
+            position->x += count;
 
-        if (!bits_remaining_in_bitmap)
-            break;
+            /* Reached the end of the row, so go to the next one */
+            if (position->x >= glyph->end_x)
+            {
+                position->y++;
+                position->x = glyph->origin_x;
+            }
+        }
     }
+}
 
-    /* IF we're done, let's return */
-    if (!bits_remaining_in_bitmap)
-        return;
-
-    /* Now for 15 through 8 */
-    for (int32_t bit = 15; bit >= 8; bit--)
-    {
-        current_bit = (bitmap_data >> bit) & 0x01;
-
-        nv3_render_gdi_1bpp_bitmap_blit(current_bit, color0, color1, grobj);
-        nv3->pgraph.win95_gdi_text_bit_count++;
-        bits_remaining_in_bitmap--;
-
-        if (!bits_remaining_in_bitmap)
-            break;
-    }
+/* GDI Type C/D: Transparent 1bpp bitmap. One dword of the bitmap at a time. */
+void nv3_render_gdi_transparent_bitmap(bool clip, uint32_t color, uint32_t bitmap_data, nv3_grobj_t grobj)
+{
+    nv3_render_gdi_glyph_t glyph = {0};
 
-    /* IF we're done, let's return */
-    if (!bits_remaining_in_bitmap)
-        return;
+    glyph.color1 = color;
 
-    /* Now for 23 through 16 */
-    for (int32_t bit = 23; bit >= 16; bit--)
+    if (clip)
     {
-        current_bit = (bitmap_data >> bit) & 0x01;
-
-        nv3_render_gdi_1bpp_bitmap_blit(current_bit, color0, color1, grobj);
-        nv3->pgraph.win95_gdi_text_bit_count++;
-        bits_remaining_in_bitmap--;
-
-        if (!bits_remaining_in_bitmap)
-            break;
+        /* Type D also clips to SIZE_OUT, just to get rid of the crud sent by NV */
+        int32_t out_right = nv3->pgraph.win95_gdi_text.point_d.x + nv3->pgraph.win95_gdi_text.size_out_d.w - 1;
+        int32_t out_bottom = nv3->pgraph.win95_gdi_text.point_d.y + nv3->pgraph.win95_gdi_text.size_out_d.h - 1;
+
+        glyph.origin_x = nv3->pgraph.win95_gdi_text.point_d.x;
+        glyph.end_x = nv3->pgraph.win95_gdi_text.point_d.x + nv3->pgraph.win95_gdi_text.size_in_d.w;
+        glyph.size = nv3->pgraph.win95_gdi_text.size_in_d.w * nv3->pgraph.win95_gdi_text.size_in_d.h;
+        glyph.clip_left = nv3->pgraph.win95_gdi_text.clip_d.left;
+        glyph.clip_top = nv3->pgraph.win95_gdi_text.clip_d.top;
+        glyph.clip_right = (nv3->pgraph.win95_gdi_text.clip_d.right < out_right) ? nv3->pgraph.win95_gdi_text.clip_d.right : out_right;
+        glyph.clip_bottom = (nv3->pgraph.win95_gdi_text.clip_d.bottom < out_bottom) ? nv3->pgraph.win95_gdi_text.clip_d.bottom : out_bottom;
     }
-
-    /* IF we're done, let's return */
-    if (!bits_remaining_in_bitmap)
-        return;
-
-    /* Now for 31 through 24 */
-    for (int32_t bit = 31; bit >= 24; bit--)
+    else
     {
-        current_bit = (bitmap_data >> bit) & 0x01;
+        glyph.origin_x = nv3->pgraph.win95_gdi_text.point_c.x;
+        glyph.end_x = nv3->pgraph.win95_gdi_text.point_c.x + nv3->pgraph.win95_gdi_text.size_c.w;
+        glyph.size = nv3->pgraph.win95_gdi_text.size_c.w * nv3->pgraph.win95_gdi_text.size_c.h;
+        glyph.clip_left = glyph.clip_top = INT32_MIN;
+        glyph.clip_right = glyph.clip_bottom = INT32_MAX;
+    }
 
-        nv3_render_gdi_1bpp_bitmap_blit(current_bit, color0, color1, grobj);
-        nv3->pgraph.win95_gdi_text_bit_count++;
-        bits_remaining_in_bitmap--;
+    nv3_render_span_state_t state;
 
-        if (!bits_remaining_in_bitmap)
-            break;
-    }
+    nv3_render_span_begin(&state, grobj);
+    nv3_render_gdi_bits(&state, &glyph, bitmap_data);
+    nv3_render_span_end(&state);
+}
 
-    /* IF we're done, let's return */
-    if (!bits_remaining_in_bitmap)
-        return;
-}
\ No newline at end of file
+/* GDI Type E: Clipped 1bpp colour-expanded bitmap. One dword of the bitmap at a time. */
+void nv3_render_gdi_1bpp_bitmap(uint32_t color0, uint32_t color1, uint32_t bitmap_data, nv3_grobj_t grobj)
+{
+    nv3_render_gdi_glyph_t glyph = {0};
+
+    /* Also clip to SIZE_OUT, to get rid of the crud sent by NV */
+    int32_t out_right = nv3->pgraph.win95_gdi_text.point_e.x + nv3->pgraph.win95_gdi_text.size_out_e.w - 1;
+    int32_t out_bottom = nv3->pgraph.win95_gdi_text.point_e.y + nv3->pgraph.win95_gdi_text.size_out_e.h - 1;
+
+    glyph.opaque = true;
+    glyph.color0 = color0;
+    glyph.color1 = color1;
+    glyph.origin_x = nv3->pgraph.win95_gdi_text.point_e.x;
+    glyph.end_x = nv3->pgraph.win95_gdi_text.point_e.x + nv3->pgraph.win95_gdi_text.size_in_e.w;
+    glyph.size = nv3->pgraph.win95_gdi_text.size_in_e.w * nv3->pgraph.win95_gdi_text.size_in_e.h;
+    glyph.clip_left = nv3->pgraph.win95_gdi_text.clip_e.left;
+    glyph.clip_top = nv3->pgraph.win95_gdi_text.clip_e.top;
+    glyph.clip_right = (nv3->pgraph.win95_gdi_text.clip_e.right < out_right) ? nv3->pgraph.win95_gdi_text.clip_e.right : out_right;
+    glyph.clip_bottom = (nv3->pgraph.win95_gdi_text.clip_e.bottom < out_bottom) ? nv3->pgraph.win95_gdi_text.clip_e.bottom : out_bottom;
+
+    nv3_render_span_state_t state;
+
+    nv3_render_span_begin(&state, grobj);
+    nv3_render_gdi_bits(&state, &glyph, bitmap_data);
+    nv3_render_span_end(&state);
+}
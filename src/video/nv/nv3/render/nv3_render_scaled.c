@@ -0,0 +1,385 @@
+/*
+* 86Box    A hypervisor and IBM PC system emulator that specializes in
+*          running old operating systems and software designed for IBM
+*          PC systems and compatibles from 1981 through fairly recent
+*          system designs based on the PCI bus.
+*
+*          This file is part of the 86Box distribution.
+*
+*          NV3 scaled image from memory (class 0x0E) and stretched image from CPU (class 0x15)
+*
+*          Both are a DDA over the destination in 12.20 fixed point. The source column for each destination column is worked out once per image,
+*          so a destination row is a gather from one (or, when filtering, two) source rows, drawn with one span.
+*
+* Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+*
+*          Copyright 2024-2025 Connor Hyde
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/pci.h>
+#include <86box/rom.h>
+#include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_RENDER
+#include <86box/nv/vid_nv.h>
+#include <86box/nv/vid_nv3.h>
+
+#define NV3_RENDER_SCALED_FRACTION      20                                  // Bits of fraction in a coordinate
+#define NV3_RENDER_SCALED_ONE           (1LL << NV3_RENDER_SCALED_FRACTION)
+
+/* Set up everything that is the same for both classes. The clip rectangle is inclusive of clip_point, exclusive of clip_point + clip_size */
+static bool nv3_render_scaled_begin(nv3_render_scaled_t* scaled, nv3_grobj_t grobj, int32_t left, int32_t top, int32_t right, int32_t bottom,
+    nv3_position_16_t clip_point, nv3_size_16_t clip_size, uint32_t src_width, uint32_t src_height, bool bilinear)
+{
+    scaled->grobj = grobj;
+    scaled->src_width = src_width;
+    scaled->src_height = src_height;
+    scaled->src_row = scaled->src_x = 0;
+    scaled->src_line_row[0] = scaled->src_line_row[1] = -1;
+
+    switch (nv3->nvbase.svga.bpp)
+    {
+        case 8:
+            scaled->bytes = 1;
+            bilinear = false;   // can't blend palette indices
+            break;
+        case 15:
+        case 16:
+            scaled->bytes = 2;
+            break;
+        default:
+            scaled->bytes = 4;
+            break;
+    }
+
+    scaled->bilinear = bilinear;
+
+    if (left < clip_point.x) left = clip_point.x;
+    if (top < clip_point.y) top = clip_point.y;
+    if (right > (clip_point.x + clip_size.w - 1)) right = clip_point.x + clip_size.w - 1;
+    if (bottom > (clip_point.y + clip_size.h - 1)) bottom = clip_point.y + clip_size.h - 1;
+
+    /* Nothing is left or there is nothing to draw it with */
+    if (left > right
+    || top > bottom
+    || !src_width
+    || !src_height)
+    {
+        scaled->dst_left = scaled->dst_top = 0;
+        scaled->dst_right = scaled->dst_bottom = -1;
+        return false;
+    }
+
+    if ((right - left + 1) > NV3_RENDER_SCALED_MAX_WIDTH)
+        right = left + NV3_RENDER_SCALED_MAX_WIDTH - 1;
+
+    scaled->dst_left = left;
+    scaled->dst_top = top;
+    scaled->dst_right = right;
+    scaled->dst_bottom = bottom;
+    return true;
+}
+
+/* Get the nearest source index and the weight of the one after it for a 12.20 coordinate */
+static inline uint32_t nv3_render_scaled_index(int64_t coordinate, uint32_t size, uint8_t* weight)
+{
+    if (coordinate < 0)
+    {
+        *weight = 0;
+        return 0;
+    }
+
+    int64_t index = coordinate >> NV3_RENDER_SCALED_FRACTION;
+
+    *weight = (coordinate >> (NV3_RENDER_SCALED_FRACTION - 8)) & 0xFF;
+
+    if (index >= (int64_t)size - 1)
+    {
+        /* Nothing after the last one to blend with */
+        *weight = 0;
+        return size - 1;
+    }
+
+    return (uint32_t)index;
+}
+
+/* Blend two a8r8g8b8 pixels, two channels at a time. weight is 0-256 */
+static inline uint32_t nv3_render_scaled_lerp_32(uint32_t a, uint32_t b, uint32_t weight)
+{
+    uint32_t rb = ((((a & 0x00FF00FF) * (256 - weight)) + ((b & 0x00FF00FF) * weight)) >> 8) & 0x00FF00FF;
+    uint32_t ag = ((((a >> 8) & 0x00FF00FF) * (256 - weight)) + (((b >> 8) & 0x00FF00FF) * weight)) & 0xFF00FF00;
+
+    return rb | ag;
+}
+
+/*
+    Blend two 15/16-bit pixels. The green channel is moved up into the top half so that all three channels can be done with one multiply. weight is 0-32.
+    mask is the spread out layout of the channels. x1r5g5b5 keeps the alpha bit of whichever pixel is nearest.
+*/
+static inline uint16_t nv3_render_scaled_lerp_16(uint16_t a, uint16_t b, uint32_t weight, uint32_t mask)
+{
+    uint32_t spread_a = (a | (a << 16)) & mask;
+    uint32_t spread_b = (b | (b << 16)) & mask;
+    uint32_t result = (((spread_a * (32 - weight)) + (spread_b * weight)) >> 5) & mask;
+
+    return ((result | (result >> 16)) & 0xFFFF) | (((weight < 16) ? a : b) & ~(mask | (mask >> 16)) & 0xFFFF);
+}
+
+/* Build dst_line from a source row. If row1 is set, blend it in by weight_y (0-255) */
+static void nv3_render_scaled_build_row(nv3_render_scaled_t* scaled, const uint8_t* row0, const uint8_t* row1, uint32_t weight_y)
+{
+    uint32_t count = (scaled->dst_right - scaled->dst_left) + 1;
+    bool is_565 = (nv3->pramdac.general_control >> NV3_PRAMDAC_GENERAL_CONTROL_565_MODE) & 0x01;
+    uint32_t mask_16 = (is_565) ? 0x07E0F81F : 0x03E07C1F;
+    uint32_t last_column = ((scaled->src_width < NV3_RENDER_SCALED_MAX_WIDTH) ? scaled->src_width : NV3_RENDER_SCALED_MAX_WIDTH) - 1;
+
+    if (!scaled->bilinear)
+    {
+        switch (scaled->bytes)
+        {
+            case 1:
+                for (uint32_t i = 0; i < count; i++)
+                    scaled->dst_line[i] = row0[scaled->columns[i]];
+                break;
+            case 2:
+                for (uint32_t i = 0; i < count; i++)
+                    ((uint16_t*)scaled->dst_line)[i] = ((const uint16_t*)row0)[scaled->columns[i]];
+                break;
+            case 4:
+                for (uint32_t i = 0; i < count; i++)
+                    ((uint32_t*)scaled->dst_line)[i] = ((const uint32_t*)row0)[scaled->columns[i]];
+                break;
+        }
+
+        return;
+    }
+
+    if (!row1)
+    {
+        row1 = row0;
+        weight_y = 0;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t column = scaled->columns[i];
+        uint32_t next = (column < last_column) ? (column + 1) : column;
+        uint32_t weight_x = scaled->column_weights[i];
+
+        if (scaled->bytes == 2)
+        {
+            const uint16_t* top = (const uint16_t*)row0;
+            const uint16_t* bottom = (const uint16_t*)row1;
+
+            uint16_t upper = nv3_render_scaled_lerp_16(top[column], top[next], weight_x >> 3, mask_16);
+            uint16_t lower = nv3_render_scaled_lerp_16(bottom[column], bottom[next], weight_x >> 3, mask_16);
+            ((uint16_t*)scaled->dst_line)[i] = nv3_render_scaled_lerp_16(upper, lower, weight_y >> 3, mask_16);
+        }
+        else
+        {
+            const uint32_t* top = (const uint32_t*)row0;
+            const uint32_t* bottom = (const uint32_t*)row1;
+
+            uint32_t upper = nv3_render_scaled_lerp_32(top[column], top[next], weight_x);
+            uint32_t lower = nv3_render_scaled_lerp_32(bottom[column], bottom[next], weight_x);
+            ((uint32_t*)scaled->dst_line)[i] = nv3_render_scaled_lerp_32(upper, lower, weight_y);
+        }
+    }
+}
+
+/* Read a source row for class 0x0E, unless it's one of the last two that were read */
+static const uint8_t* nv3_render_scaled_read_row(nv3_render_scaled_t* scaled, uint32_t dma_object, uint32_t offset, uint32_t pitch, uint32_t row)
+{
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        if (scaled->src_line_row[i] == (int32_t)row)
+            return scaled->src_line[i];
+    }
+
+    /* Replace the one that isn't the row above, since rows are read top to bottom */
+    uint32_t slot = (scaled->src_line_row[0] == (int32_t)row - 1) ? 1 : 0;
+    uint32_t width = (scaled->src_width < NV3_RENDER_SCALED_MAX_WIDTH) ? scaled->src_width : NV3_RENDER_SCALED_MAX_WIDTH;
+
+    if (!nv3_pgraph_dma_read(dma_object, offset + (row * pitch), scaled->src_line[slot], width * scaled->bytes))
+        return NULL;
+
+    scaled->src_line_row[slot] = row;
+    return scaled->src_line[slot];
+}
+
+/* Scaled image from memory. The whole image is drawn when the source point is set */
+void nv3_render_scaled_image_from_memory(nv3_grobj_t grobj)
+{
+    nv3_render_scaled_t* scaled = &nv3->pgraph.scaled;
+    nv3_scaled_image_from_memory_t* image = &nv3->pgraph.scaled_image_from_memory;
+
+    uint32_t dma_object = (grobj.grobj_2 & 0xFFFF) << 4;
+    uint32_t pitch = image->pitch & 0xFFFF;
+    bool bilinear = ((image->pitch >> NV3_SCALED_IMAGE_FORMAT_FILTER) & 0xFF) != 0;
+
+    int32_t out_x = image->rectangle_out_0.x;
+    int32_t out_y = image->rectangle_out_0.y;
+
+    if (!nv3_render_scaled_begin(scaled, grobj, out_x, out_y, out_x + image->rectangle_out_1.w - 1, out_y + image->rectangle_out_1.h - 1,
+        image->clip_0, image->clip_1, image->size.w, image->size.h, bilinear))
+        return;
+
+    /* The source point is 12.4 */
+    int64_t u_start = (int64_t)(int16_t)(image->point & 0xFFFF) << (NV3_RENDER_SCALED_FRACTION - 4);
+    int64_t v_start = (int64_t)(int16_t)(image->point >> 16) << (NV3_RENDER_SCALED_FRACTION - 4);
+    uint32_t count = (scaled->dst_right - scaled->dst_left) + 1;
+
+    /* The source column for every destination column */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int64_t u = u_start + ((int64_t)(scaled->dst_left - out_x + i) * image->delta_du_dx);
+        scaled->columns[i] = nv3_render_scaled_index(u, scaled->src_width, &scaled->column_weights[i]);
+
+        if (scaled->columns[i] >= NV3_RENDER_SCALED_MAX_WIDTH)
+            scaled->columns[i] = NV3_RENDER_SCALED_MAX_WIDTH - 1;
+    }
+
+    nv_log("Scaled image: %dx%d -> (%d,%d)-(%d,%d) du/dx=0x%08x dv/dy=0x%08x bilinear=%d\n", image->size.w, image->size.h,
+        scaled->dst_left, scaled->dst_top, scaled->dst_right, scaled->dst_bottom, image->delta_du_dx, image->delta_dv_dy, bilinear);
+
+    nv3_render_span_state_t state;
+    nv3_render_span_begin(&state, grobj);
+
+    for (int32_t y = scaled->dst_top; y <= scaled->dst_bottom; y++)
+    {
+        uint8_t weight_y = 0;
+        int64_t v = v_start + ((int64_t)(y - out_y) * image->delta_dv_dy);
+        uint32_t row = nv3_render_scaled_index(v, scaled->src_height, &weight_y);
+
+        const uint8_t* row0 = nv3_render_scaled_read_row(scaled, dma_object, image->offset, pitch, row);
+        const uint8_t* row1 = NULL;
+
+        if (scaled->bilinear && weight_y)
+            row1 = nv3_render_scaled_read_row(scaled, dma_object, image->offset, pitch, row + 1);
+
+        /* The DMA object ran out */
+        if (!row0)
+            break;
+
+        nv3_render_scaled_build_row(scaled, row0, row1, weight_y);
+        nv3_render_span_write(&state, scaled->dst_left, y, count, scaled->dst_line);
+    }
+
+    nv3_render_span_end(&state);
+}
+
+/* Start a stretched image from the CPU. Works out the columns now, the rows are drawn as each source row arrives */
+void nv3_render_stretched_image_begin(nv3_grobj_t grobj)
+{
+    nv3_render_scaled_t* scaled = &nv3->pgraph.scaled;
+    nv3_stretched_image_from_cpu_t* image = &nv3->pgraph.stretched_image_from_cpu;
+
+    /* The destination point is 12.4 */
+    int64_t x_start = (int64_t)(int16_t)(image->point12d4 & 0xFFFF) << (NV3_RENDER_SCALED_FRACTION - 4);
+    int64_t y_start = (int64_t)(int16_t)(image->point12d4 >> 16) << (NV3_RENDER_SCALED_FRACTION - 4);
+    int64_t dx_du = image->delta_dx_du;
+    int64_t dy_dv = image->delta_dy_dv;
+
+    scaled->origin_y = y_start;
+    scaled->dy_dv = dy_dv;
+
+    /* Shrinking to nothing */
+    if (dx_du <= 0
+    || dy_dv <= 0)
+    {
+        nv3_render_scaled_begin(scaled, grobj, 0, 0, -1, -1, image->clip_0, image->clip_1, 0, 0, false);
+        return;
+    }
+
+    /* The destination pixels whose top left is inside the stretched source */
+    int64_t x_end = x_start + (image->size_in.w * dx_du);
+    int64_t y_end = y_start + (image->size_in.h * dy_dv);
+    int32_t left = (int32_t)((x_start + NV3_RENDER_SCALED_ONE - 1) >> NV3_RENDER_SCALED_FRACTION);
+    int32_t top = (int32_t)((y_start + NV3_RENDER_SCALED_ONE - 1) >> NV3_RENDER_SCALED_FRACTION);
+    int32_t right = (int32_t)((x_end + NV3_RENDER_SCALED_ONE - 1) >> NV3_RENDER_SCALED_FRACTION) - 1;
+    int32_t bottom = (int32_t)((y_end + NV3_RENDER_SCALED_ONE - 1) >> NV3_RENDER_SCALED_FRACTION) - 1;
+
+    if (!nv3_render_scaled_begin(scaled, grobj, left, top, right, bottom, image->clip_0, image->clip_1, image->size_in.w, image->size_in.h, false))
+        return;
+
+    uint32_t count = (scaled->dst_right - scaled->dst_left) + 1;
+
+    /* Going from destination to source is a divide, but only once per column */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int64_t x = ((int64_t)(scaled->dst_left + i) << NV3_RENDER_SCALED_FRACTION) - x_start;
+        int64_t u = (x << NV3_RENDER_SCALED_FRACTION) / dx_du;
+
+        scaled->columns[i] = nv3_render_scaled_index(u, scaled->src_width, &scaled->column_weights[i]);
+
+        if (scaled->columns[i] >= NV3_RENDER_SCALED_MAX_WIDTH)
+            scaled->columns[i] = NV3_RENDER_SCALED_MAX_WIDTH - 1;
+    }
+
+    nv_log("Stretched image: %dx%d -> (%d,%d)-(%d,%d) dx/du=0x%08x dy/dv=0x%08x\n", image->size_in.w, image->size_in.h,
+        scaled->dst_left, scaled->dst_top, scaled->dst_right, scaled->dst_bottom, image->delta_dx_du, image->delta_dy_dv);
+}
+
+/* Draw every destination row that a complete source row covers */
+static void nv3_render_stretched_image_row(nv3_render_scaled_t* scaled)
+{
+    int64_t row_top = scaled->origin_y + (scaled->src_row * scaled->dy_dv);
+    int32_t first = (int32_t)((row_top + NV3_RENDER_SCALED_ONE - 1) >> NV3_RENDER_SCALED_FRACTION);
+    int32_t last = (int32_t)((row_top + scaled->dy_dv + NV3_RENDER_SCALED_ONE - 1) >> NV3_RENDER_SCALED_FRACTION) - 1;
+
+    if (first < scaled->dst_top) first = scaled->dst_top;
+    if (last > scaled->dst_bottom) last = scaled->dst_bottom;
+
+    /* Shrunk so much that this row doesn't cover anything */
+    if (first > last)
+        return;
+
+    nv3_render_scaled_build_row(scaled, scaled->src_line[0], NULL, 0);
+
+    nv3_render_span_state_t state;
+    nv3_render_span_begin(&state, scaled->grobj);
+
+    for (int32_t y = first; y <= last; y++)
+        nv3_render_span_write(&state, scaled->dst_left, y, (scaled->dst_right - scaled->dst_left) + 1, scaled->dst_line);
+
+    nv3_render_span_end(&state);
+}
+
+/* Stretched image colour method. Like an image from the CPU, there are 4, 2 or 1 pixels in each, the first one in the low bits */
+void nv3_render_stretched_image_push(uint32_t color, nv3_grobj_t grobj)
+{
+    nv3_render_scaled_t* scaled = &nv3->pgraph.scaled;
+    uint32_t bytes = scaled->bytes;
+
+    if (!bytes
+    || scaled->src_row >= scaled->src_height)
+        return;
+
+    for (uint32_t pixel = 0; pixel < (4 / bytes); pixel++)
+    {
+        /* Anything past the widest row we can draw is just counted */
+        if (scaled->src_x < NV3_RENDER_SCALED_MAX_WIDTH)
+            memcpy(&scaled->src_line[0][scaled->src_x * bytes], ((const uint8_t*)&color) + (pixel * bytes), bytes);
+
+        scaled->src_x++;
+
+        if (scaled->src_x >= scaled->src_width)
+        {
+            if (scaled->dst_left <= scaled->dst_right)
+                nv3_render_stretched_image_row(scaled);
+
+            scaled->src_x = 0;
+            scaled->src_row++;
+
+            if (scaled->src_row >= scaled->src_height)
+                return;
+        }
+    }
+}
@@ -0,0 +1,389 @@
+/*
+* 86Box    A hypervisor and IBM PC system emulator that specializes in
+*          running old operating systems and software designed for IBM
+*          PC systems and compatibles from 1981 through fairly recent
+*          system designs based on the PCI bus.
+*
+*          This file is part of the 86Box distribution.
+*
+*          NV3 span rasteriser: draws whole rows of pixels at once
+*
+*
+*
+* Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+*
+*          Copyright 2024-2025 Connor Hyde
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/pci.h>
+#include <86box/rom.h>
+#include <86box/video.h>
+#include <86box/nv/vid_nv.h>
+#include <86box/nv/vid_nv3.h>
+#include <86box/utils/video_stdlib.h>
+
+/*
+    Everything nv3_render_write_pixel used to work out for every single pixel (clip, chroma key, pattern colours, pixel format) is worked out
+    once per method here. The rows are then filled with the ROP directly in VRAM, and the part of the screen that changed is only sent to
+    the monitor once per frame, after nv3_render_span_end marks it as dirty.
+*/
+
+/* Set up the span state for a method. */
+void nv3_render_span_begin(nv3_render_span_state_t* state, nv3_grobj_t grobj)
+{
+    state->grobj = grobj;
+    state->bpp = nv3->nvbase.svga.bpp;
+    state->rop = nv3->pgraph.rop;
+
+    /* Same bounds as nv3_render_write_pixel, they are inclusive */
+    state->clip_left = nv3->pgraph.clip_start.x;
+    state->clip_top = nv3->pgraph.clip_start.y;
+    state->clip_right = nv3->pgraph.clip_start.x + nv3->pgraph.clip_size.x;
+    state->clip_bottom = nv3->pgraph.clip_start.y + nv3->pgraph.clip_size.y;
+
+    state->alpha_enabled = (grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_ALPHA) & 0x01;
+    state->is_565 = (nv3->pramdac.general_control >> NV3_PRAMDAC_GENERAL_CONTROL_565_MODE) & 0x01;
+
+    /* The chroma key is always stored as RGB10, so convert it to the object's format once, instead of for every pixel */
+    state->chroma_enabled = ((grobj.grobj_0 >> NV3_PGRAPH_CONTEXT_SWITCH_CHROMA_KEY) & 0x01)
+    && ((nv3->pgraph.chroma_key >> 31) & 0x01);
+
+    if (state->chroma_enabled)
+    {
+        nv3_grobj_t grobj_fake = {0};
+        grobj_fake.grobj_0 = 0x02; /* we don't care about any other bits */
+
+        nv3_color_expanded_t chroma_expanded = nv3_render_expand_color(nv3->pgraph.chroma_key, grobj_fake);
+        state->chroma_color = nv3_render_downconvert_color(grobj, chroma_expanded);
+    }
+
+    /* Same for the pattern colours */
+    state->pattern_color[0] = nv3_render_downconvert_color(grobj, nv3->pgraph.pattern_color_0_rgb);
+    state->pattern_color[1] = nv3_render_downconvert_color(grobj, nv3->pgraph.pattern_color_1_rgb);
+    state->pattern_opaque[0] = (nv3->pgraph.pattern_color_0_alpha != 0);
+    state->pattern_opaque[1] = (nv3->pgraph.pattern_color_1_alpha != 0);
+
+    /* The fill pipeline only needs the pattern test, since a solid colour is tested once for the whole span */
+    bool alpha_test = (state->bpp == 15 || state->bpp == 16) && !state->is_565 && state->alpha_enabled;
+    bool pattern_test = !(state->pattern_opaque[0] && state->pattern_opaque[1]);
+
+    nv3_render_pipeline_build(&state->fill_pipeline, state->bpp, state->rop, false, false, pattern_test);
+    nv3_render_pipeline_build(&state->copy_pipeline, state->bpp, state->rop, state->chroma_enabled, alpha_test, pattern_test);
+
+    state->dirty = false;
+}
+
+/* Get the pattern bits for a row, so that the bit for a pixel is just (row_bits >> (x & x_mask)) & 1 */
+static uint64_t nv3_render_span_pattern_row(int32_t y, uint32_t* x_mask)
+{
+    uint64_t bitmap = nv3->pgraph.pattern_bitmap;
+
+    switch (nv3->pgraph.pattern.shape)
+    {
+        /* This logic is from NV1 envytoos docs, but seems to be same on NV3*/
+        case NV3_PATTERN_SHAPE_8X8:
+            *x_mask = 7;
+            return (bitmap >> ((y & 7) << 3)) & 0xFF;
+        case NV3_PATTERN_SHAPE_1X64:
+            *x_mask = 0x3f;
+            return bitmap;
+        case NV3_PATTERN_SHAPE_64X1:
+            *x_mask = 0;
+            return (bitmap >> (y & 0x3f)) & 0x01;
+        default:
+            *x_mask = 0;
+            return bitmap & 0x01;
+    }
+}
+
+/* Mark the VRAM pages from first_addr_vram up to (not including) end_addr_vram, and the part of the screen, that a span changed */
+static void nv3_render_span_mark(nv3_render_span_state_t* state, uint32_t first_addr_vram, uint32_t end_addr_vram, int32_t x_start, int32_t x_end)
+{
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+
+    /* If the span wrapped around the end of VRAM, just mark everything from the start of it */
+    uint32_t last_addr_vram = (end_addr_vram - 1) & vram_mask;
+
+    if (last_addr_vram < first_addr_vram)
+        last_addr_vram = vram_mask;
+
+    for (uint32_t page = (first_addr_vram >> 12); page <= (last_addr_vram >> 12); page++)
+        nv3->nvbase.svga.changedvram[page] = changeframecount;
+
+    nv3_cursor_vram_written(first_addr_vram, (last_addr_vram - first_addr_vram) + 1);
+
+    /* For capture replays */
+    nv3->capture.pixels += (x_end - x_start) + 1;
+
+    /* Remember what part of the screen needs to be updated. The object may be drawing somewhere other than the screen, or with another pitch */
+    nv3_render_dirty_rect_t rect = {0};
+
+    if (!nv3_render_vram_to_rect(first_addr_vram, (last_addr_vram - first_addr_vram) + 1, &rect))
+        return;
+
+    if (!state->dirty)
+    {
+        state->dirty = true;
+        state->dirty_left = rect.left;
+        state->dirty_right = rect.right;
+        state->dirty_top = rect.top;
+        state->dirty_bottom = rect.bottom;
+    }
+    else
+    {
+        if (rect.left < state->dirty_left) state->dirty_left = rect.left;
+        if (rect.right > state->dirty_right) state->dirty_right = rect.right;
+        if (rect.top < state->dirty_top) state->dirty_top = rect.top;
+        if (rect.bottom > state->dirty_bottom) state->dirty_bottom = rect.bottom;
+    }
+}
+
+/* Fill a row of pixels with one colour, running the current ROP against the pattern and what's already in VRAM */
+void nv3_render_span_fill(nv3_render_span_state_t* state, int32_t x, int32_t y, int32_t width, uint32_t color)
+{
+    /* Clip the whole span at once */
+    int32_t x_start = (x < state->clip_left) ? state->clip_left : x;
+    int32_t x_end = x + width - 1;
+
+    if (x_end > state->clip_right)
+        x_end = state->clip_right;
+
+    if (y < state->clip_top
+    || y > state->clip_bottom
+    || x_start > x_end)
+        return;
+
+    /* Positions are 16-bit in the hardware */
+    if (x_start > 0xFFFF || y > 0xFFFF)
+        return;
+
+    /* TODO: Plane Mask...*/
+    /* The source colour doesn't change over the span, so neither does the result of the chroma test */
+    if (state->chroma_enabled
+    && state->chroma_color == color)
+        return;
+
+    /* if alpha is turned on and we aren't in 565 mode, reject transparent pixels */
+    if ((state->bpp == 15 || state->bpp == 16)
+    && !state->is_565
+    && state->alpha_enabled
+    && !(color & 0x8000))
+        return;
+
+    nv3_position_16_t position = {0};
+    position.x = x_start;
+    position.y = y;
+
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+    uint32_t pixel_addr_vram = nv3_render_get_vram_address(position, state->grobj);
+    uint32_t first_addr_vram = pixel_addr_vram;
+    uint32_t count = (x_end - x_start) + 1;
+
+    uint32_t x_mask = 0;
+    uint64_t pattern_row = nv3_render_span_pattern_row(y, &x_mask);
+
+    /* If neither pattern colour is transparent, every pixel in the span gets drawn, so we can use the fast paths */
+    bool all_opaque = state->pattern_opaque[0] && state->pattern_opaque[1];
+    uint8_t rop = state->rop;
+
+    /* 
+        One loop per bpp and per fast path, so nothing that is constant over the span gets checked per pixel.
+        vram is the VRAM pointer of the right width, bytes is the number of bytes per pixel, and src_mask masks the source colour to the pixel size.
+    */
+#define NV3_RENDER_SPAN_LOOP(body)                                                                          \
+    for (uint32_t i = 0; i < count; i++, pixel_addr_vram = (pixel_addr_vram + bytes) & vram_mask)           \
+    {                                                                                                       \
+        body;                                                                                               \
+    }
+
+#define NV3_RENDER_SPAN_KERNEL(type, bytes_per_pixel, src_mask)                                             \
+    {                                                                                                       \
+        type* vram = (type*)(nv3->nvbase.svga.vram);                                                        \
+        uint32_t bytes = bytes_per_pixel;                                                                   \
+        uint32_t rop_src = color & src_mask;                                                                \
+                                                                                                            \
+        if (all_opaque && rop == nv3_rop_srccopy)                                                           \
+            NV3_RENDER_SPAN_LOOP(vram[pixel_addr_vram / bytes] = rop_src)                                   \
+        else if (all_opaque && rop == nv3_rop_blackness)                                                    \
+            NV3_RENDER_SPAN_LOOP(vram[pixel_addr_vram / bytes] = 0)                                         \
+        else if (all_opaque && rop == nv3_rop_patcopy)                                                      \
+            NV3_RENDER_SPAN_LOOP(                                                                           \
+                bool use_color1 = (pattern_row >> ((x_start + i) & x_mask)) & 0x01;                         \
+                vram[pixel_addr_vram / bytes] = state->pattern_color[use_color1] & src_mask)                \
+        else                                                                                                \
+        {                                                                                                   \
+            nv3_render_pipeline_run(&state->fill_pipeline, state, pixel_addr_vram, rop_src, NULL,           \
+                true, false, x_start, count, pattern_row, x_mask);                                          \
+            pixel_addr_vram = (pixel_addr_vram + (count * bytes)) & vram_mask;                              \
+        }                                                                                                   \
+    }
+
+    switch (state->bpp)
+    {
+        case 8:
+            NV3_RENDER_SPAN_KERNEL(uint8_t, 1, 0xFF);
+            break;
+        case 15:
+        case 16:
+            NV3_RENDER_SPAN_KERNEL(uint16_t, 2, 0xFFFF);
+            break;
+        case 32:
+            NV3_RENDER_SPAN_KERNEL(uint32_t, 4, 0xFFFFFFFF);
+            break;
+        default:
+            return;
+    }
+
+#undef NV3_RENDER_SPAN_KERNEL
+#undef NV3_RENDER_SPAN_LOOP
+
+    nv3_render_span_mark(state, first_addr_vram, pixel_addr_vram, x_start, x_end);
+}
+
+/* 
+    Copy a row of pixels that is already in VRAM to (x, y), running the current ROP. src_addr_vram is the address of the source pixel for x. 
+    The source and destination may overlap; the row is walked backwards if the destination is after the source, so nothing is overwritten before it is read.
+    The caller has to do the same with the order of the rows.
+*/
+void nv3_render_span_copy(nv3_render_span_state_t* state, int32_t x, int32_t y, int32_t width, uint32_t src_addr_vram)
+{
+    /* Clip the whole span at once */
+    int32_t x_start = (x < state->clip_left) ? state->clip_left : x;
+    int32_t x_end = x + width - 1;
+
+    if (x_end > state->clip_right)
+        x_end = state->clip_right;
+
+    if (y < state->clip_top
+    || y > state->clip_bottom
+    || x_start > x_end)
+        return;
+
+    /* Positions are 16-bit in the hardware */
+    if (x_start > 0xFFFF || y > 0xFFFF)
+        return;
+
+    uint32_t bytes = 0;
+
+    switch (state->bpp)
+    {
+        case 8:
+            bytes = 1;
+            break;
+        case 15:
+        case 16:
+            bytes = 2;
+            break;
+        case 32:
+            bytes = 4;
+            break;
+        default:
+            return;
+    }
+
+    nv3_position_16_t position = {0};
+    position.x = x_start;
+    position.y = y;
+
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+    uint32_t dst_addr_vram = nv3_render_get_vram_address(position, state->grobj);
+    uint32_t count = (x_end - x_start) + 1;
+    uint32_t size = count * bytes;
+
+    /* Skip the part of the source that got clipped off */
+    src_addr_vram = (src_addr_vram + ((x_start - x) * bytes)) & vram_mask;
+
+    uint32_t x_mask = 0;
+    uint64_t pattern_row = nv3_render_span_pattern_row(y, &x_mask);
+
+    /* Work out everything that decides if we can do the whole row at once */
+    bool wraps = ((src_addr_vram + size - 1) > vram_mask) || ((dst_addr_vram + size - 1) > vram_mask);
+    bool backwards = (dst_addr_vram > src_addr_vram) && (dst_addr_vram < (src_addr_vram + size));
+
+    if (!wraps && !state->copy_pipeline.write && state->rop == nv3_rop_srccopy)
+        memmove(&nv3->nvbase.svga.vram[dst_addr_vram], &nv3->nvbase.svga.vram[src_addr_vram], size);
+    else
+        nv3_render_pipeline_run(&state->copy_pipeline, state, dst_addr_vram, src_addr_vram, NULL, false, backwards, x_start, count, pattern_row, x_mask);
+
+    nv3_render_span_mark(state, dst_addr_vram, dst_addr_vram + size, x_start, x_end);
+}
+
+/* 
+    Draw a row of pixels that came from outside VRAM (e.g. the CPU), already in the framebuffer's pixel format, to (x, y), running the current ROP. 
+    src is the pixel for x. Every source pixel gets the same tests as a copy.
+*/
+void nv3_render_span_write(nv3_render_span_state_t* state, int32_t x, int32_t y, int32_t width, const uint8_t* src)
+{
+    /* Clip the whole span at once */
+    int32_t x_start = (x < state->clip_left) ? state->clip_left : x;
+    int32_t x_end = x + width - 1;
+
+    if (x_end > state->clip_right)
+        x_end = state->clip_right;
+
+    if (y < state->clip_top
+    || y > state->clip_bottom
+    || x_start > x_end)
+        return;
+
+    /* Positions are 16-bit in the hardware */
+    if (x_start > 0xFFFF || y > 0xFFFF)
+        return;
+
+    uint32_t bytes = state->copy_pipeline.bytes;
+
+    nv3_position_16_t position = {0};
+    position.x = x_start;
+    position.y = y;
+
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+    uint32_t dst_addr_vram = nv3_render_get_vram_address(position, state->grobj);
+    uint32_t count = (x_end - x_start) + 1;
+    uint32_t size = count * bytes;
+
+    /* Skip the part of the source that got clipped off */
+    src += (x_start - x) * bytes;
+
+    uint32_t x_mask = 0;
+    uint64_t pattern_row = nv3_render_span_pattern_row(y, &x_mask);
+
+    if (((dst_addr_vram + size - 1) <= vram_mask) && !state->copy_pipeline.write && state->rop == nv3_rop_srccopy)
+        memcpy(&nv3->nvbase.svga.vram[dst_addr_vram], src, size);
+    else
+        nv3_render_pipeline_run(&state->copy_pipeline, state, dst_addr_vram, 0, src, false, false, x_start, count, pattern_row, x_mask);
+
+    nv3_render_span_mark(state, dst_addr_vram, dst_addr_vram + size, x_start, x_end);
+}
+
+/* Plot one pixel using the span state. Used by the paths where every pixel is a different colour (images, text) */
+void nv3_render_span_pixel(nv3_render_span_state_t* state, nv3_position_16_t position, uint32_t color)
+{
+    nv3_render_span_fill(state, position.x, position.y, 1, color);
+}
+
+/* Mark everything that was drawn since nv3_render_span_begin as dirty, so it gets presented at the next vsync */
+void nv3_render_span_end(nv3_render_span_state_t* state)
+{
+    if (!state->dirty)
+        return;
+
+    nv3_position_16_t position = {0};
+    nv3_size_16_t size = {0};
+
+    position.x = state->dirty_left;
+    position.y = state->dirty_top;
+    size.w = (state->dirty_right - state->dirty_left) + 1;
+    size.h = (state->dirty_bottom - state->dirty_top) + 1;
+
+    nv3_render_mark_dirty(position, size);
+
+    state->dirty = false;
+}
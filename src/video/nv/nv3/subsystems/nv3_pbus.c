@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PBUS
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -39,8 +40,12 @@ nv_register_t pbus_registers[] = {
     { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
 };
 
+nv_register_table_t pbus_register_table;     // Built from pbus_registers in nv3_pbus_init
+
 void nv3_pbus_init(void)
 {
+    nv_register_table_build(&pbus_register_table, pbus_registers, sizeof(pbus_registers)/sizeof(pbus_registers[0]));
+
     nv_log("Initialising PBUS...");
 
     nv_log("Done\n");    
@@ -48,7 +53,7 @@ void nv3_pbus_init(void)
 
 uint32_t nv3_pbus_read(uint32_t address) 
 { 
-    nv_register_t* reg = nv_get_register(address, pbus_registers, sizeof(pbus_registers)/sizeof(pbus_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pbus_register_table, address);
 
     uint32_t ret = 0x00; 
 
@@ -93,7 +98,7 @@ uint32_t nv3_pbus_read(uint32_t address)
 
 void nv3_pbus_write(uint32_t address, uint32_t value) 
 {
-    nv_register_t* reg = nv_get_register(address, pbus_registers, sizeof(pbus_registers)/sizeof(pbus_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pbus_register_table, address);
 
     nv_log_verbose_only("PBUS Write 0x%08x -> 0x%08x\n", value, address);
 
@@ -26,11 +26,25 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PEXTDEV
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
+//
+// ****** PEXTDEV register list START ******
+//
+
+nv_register_t pextdev_registers[] = {
+    { NV3_PSTRAPS, "Straps - Chip Configuration", NULL, NULL },
+    { NV_REG_LIST_END, NULL, NULL, NULL }, // sentinel value 
+};
+
+nv_register_table_t pextdev_register_table;     // Built from pextdev_registers in nv3_pextdev_init
+
 void nv3_pextdev_init(void)
 {
+    nv_register_table_build(&pextdev_register_table, pextdev_registers, sizeof(pextdev_registers)/sizeof(pextdev_registers[0]));
+
     nv_log("Initialising PEXTDEV....\n");
 
     // Set the chip straps
@@ -66,15 +80,6 @@ void nv3_pextdev_init(void)
     nv_log("Initialising PEXTDEV: Done\n");
 }
 
-//
-// ****** PEXTDEV register list START ******
-//
-
-nv_register_t pextdev_registers[] = {
-    { NV3_PSTRAPS, "Straps - Chip Configuration", NULL, NULL },
-    { NV_REG_LIST_END, NULL, NULL, NULL }, // sentinel value 
-};
-
 
 //
 // ****** Read/Write functions start ******
@@ -82,7 +87,7 @@ nv_register_t pextdev_registers[] = {
 
 uint32_t nv3_pextdev_read(uint32_t address) 
 { 
-    nv_register_t* reg = nv_get_register(address, pextdev_registers, sizeof(pextdev_registers)/sizeof(pextdev_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pextdev_register_table, address);
 
     uint32_t ret = 0x00;
 
@@ -127,7 +132,7 @@ uint32_t nv3_pextdev_read(uint32_t address)
 
 void nv3_pextdev_write(uint32_t address, uint32_t value) 
 {
-    nv_register_t* reg = nv_get_register(address, pextdev_registers, sizeof(pextdev_registers)/sizeof(pextdev_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pextdev_register_table, address);
 
     nv_log_verbose_only("PEXTDEV Write 0x%08x -> 0x%08x\n", value, address);
 
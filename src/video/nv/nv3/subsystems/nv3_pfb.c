@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PFB
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -43,8 +44,12 @@ nv_register_t pfb_registers[] = {
     { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
 };
 
+nv_register_table_t pfb_register_table;     // Built from pfb_registers in nv3_pfb_init
+
 void nv3_pfb_init(void)
 {  
+    nv_register_table_build(&pfb_register_table, pfb_registers, sizeof(pfb_registers)/sizeof(pfb_registers[0]));
+
     nv_log("Initialising PFB...");
 
     // initial configuration:
@@ -69,7 +74,7 @@ void nv3_pfb_init(void)
 
 uint32_t nv3_pfb_read(uint32_t address) 
 { 
-    nv_register_t* reg = nv_get_register(address, pfb_registers, sizeof(pfb_registers)/sizeof(pfb_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pfb_register_table, address);
 
     uint32_t ret = 0x00;
 
@@ -125,7 +130,7 @@ uint32_t nv3_pfb_read(uint32_t address)
 
 void nv3_pfb_write(uint32_t address, uint32_t value) 
 {
-    nv_register_t* reg = nv_get_register(address, pfb_registers, sizeof(pfb_registers)/sizeof(pfb_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pfb_register_table, address);
 
     nv_log_verbose_only("PFB Write 0x%08x -> 0x%08x", value, address);
 
@@ -26,6 +26,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PFIFO
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -76,11 +77,21 @@ nv_register_t pfifo_registers[] = {
     { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
 };
 
+nv_register_table_t pfifo_register_table;     // Built from pfifo_registers in nv3_pfifo_init
+
 // PFIFO init code
 void nv3_pfifo_init(void)
 {
+    nv_register_table_build(&pfifo_register_table, pfifo_registers, sizeof(pfifo_registers)/sizeof(pfifo_registers[0]));
+
     nv_log("Initialising PFIFO...");
 
+    // The CACHE1 puller runs off its own timer, so NV_USER writes only have to push
+    timer_add(&nv3->pfifo.cache1_puller_timer, nv3_pfifo_cache1_puller_timer, nv3, 0);
+
+    // Nothing has been looked up in RAMHT yet
+    nv3_ramht_cache_invalidate();
+
     nv_log("Done!\n");    
 }
 
@@ -97,7 +108,7 @@ uint32_t nv3_pfifo_read(uint32_t address)
 
     uint32_t ret = 0x00;
 
-    nv_register_t* reg = nv_get_register(address, pfifo_registers, sizeof(pfifo_registers)/sizeof(pfifo_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pfifo_register_table, address);
 
     // todo: friendly logging
     
@@ -392,7 +403,7 @@ void nv3_pfifo_write(uint32_t address, uint32_t val)
         return;
     }
 
-    nv_register_t* reg = nv_get_register(address, pfifo_registers, sizeof(pfifo_registers)/sizeof(pfifo_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pfifo_register_table, address);
 
     nv_log_verbose_only("PFIFO Write 0x%08x -> 0x%08x", val, address);
 
@@ -433,6 +444,8 @@ void nv3_pfifo_write(uint32_t address, uint32_t val)
 
                 case NV3_PFIFO_CONFIG_RAMHT:
                     nv3->pfifo.ramht_config = val;
+                    // RAMHT moved, so everything we looked up in it is stale
+                    nv3_ramht_cache_invalidate();
 // This code sucks a bit fix it later
 #ifdef ENABLE_NV_LOG
                     uint32_t new_size_ramht = ((val >> 16) & 0x03);
@@ -490,7 +503,7 @@ void nv3_pfifo_write(uint32_t address, uint32_t val)
                     nv3->pfifo.cache1_settings.pull0 = val; // 8bits meaningful
                     
                     if (nv3->pfifo.cache1_settings.pull0 & (1 >> NV3_PFIFO_CACHE1_PULL0_ENABLED))
-                        nv3_pfifo_cache1_pull();
+                        nv3_pfifo_cache1_drain(NV3_PFIFO_CACHE1_PULLER_BATCH);
 
                     break;
                 case NV3_PFIFO_CACHE0_PULLER_CTX_STATE:
@@ -747,7 +760,8 @@ void nv3_pfifo_cache0_pull(void)
             
     nv3_ramin_context_t context_structure = *(nv3_ramin_context_t*)&current_context;
 
-    nv3_debug_ramin_print_context_info(current_param, context_structure);
+    if (nv_log_enabled(NV_LOG_LEVEL_VERBOSE, NV_LOG_PRAMIN))
+        nv3_debug_ramin_print_context_info(current_param, context_structure);
     
     nv3_pgraph_submit(current_param, current_method, current_channel, current_subchannel, class_id & 0x1F, context_structure);
     #endif
@@ -775,6 +789,9 @@ void nv3_pfifo_cache1_push(uint32_t addr, uint32_t param)
     uint32_t new_address = 0;
 
     uint32_t method_offset = (addr & 0x1FFC); // size of dma object is 0x2000 and some universal methods are implemented at this point, like free
+
+    if (nv3->capture.recording)
+        nv3_capture_push(addr, param);
     
     // Up to 128 per envytools?
     uint32_t channel = (addr >> NV3_OBJECT_SUBMIT_CHANNEL) & 0x7F;
@@ -939,15 +956,12 @@ void nv3_pfifo_cache1_pull(void)
     // Is this needed?
     nv3->pfifo.cache1_settings.get_address = nv3_pfifo_cache1_normal2gray(next_get_address) << 2;
 
-    #ifndef RELEASE_BUILD
+    nv3_ramin_context_t context_structure = *(nv3_ramin_context_t*)&current_context;
 
     nv_log_verbose_only("***** DEBUG: CACHE1 PULLED ****** Contextual information below\n");
 
-
-    nv3_ramin_context_t context_structure = *(nv3_ramin_context_t*)&current_context;
-
-    nv3_debug_ramin_print_context_info(current_param, context_structure);
-    #endif
+    if (nv_log_enabled(NV_LOG_LEVEL_VERBOSE, NV_LOG_PRAMIN))
+        nv3_debug_ramin_print_context_info(current_param, context_structure);
     
     nv3_pgraph_submit(current_param, current_method, current_channel, current_subchannel, class_id & 0x1F, context_structure);
     
@@ -955,6 +969,54 @@ void nv3_pfifo_cache1_pull(void)
     //Todo: finish it
 }
 
+// Is there anything in CACHE1 for the puller to do?
+bool nv3_pfifo_cache1_is_empty(void)
+{
+    return (nv3->pfifo.cache1_settings.put_address == nv3->pfifo.cache1_settings.get_address);
+}
+
+// Pulls up to max_entries objects out of CACHE1 in one go.
+// Stops early if the puller stalls (disabled, software method, or the object wasn't in RAMHT) since the get address doesn't move then.
+// Returns the number of entries that were actually pulled.
+uint32_t nv3_pfifo_cache1_drain(uint32_t max_entries)
+{
+    uint32_t pulled = 0;
+
+    while (pulled < max_entries
+    && !nv3_pfifo_cache1_is_empty())
+    {
+        uint32_t old_get_address = nv3->pfifo.cache1_settings.get_address;
+
+        nv3_pfifo_cache1_pull();
+
+        if (nv3->pfifo.cache1_settings.get_address == old_get_address)
+            break;
+
+        pulled++;
+    }
+
+    return pulled;
+}
+
+// Schedules the puller if it isn't already going to run.
+// Like the Voodoo FIFO, we don't pull immediately, so that a burst of NV_USER writes can be batched up.
+void nv3_pfifo_cache1_wake_puller(void)
+{
+    if (!timer_is_enabled(&nv3->pfifo.cache1_puller_timer))
+        timer_set_delay_u64(&nv3->pfifo.cache1_puller_timer, NV3_PFIFO_CACHE1_PULLER_DELAY);
+}
+
+// The puller itself. Drains a batch of CACHE1 and goes back to sleep if there's more to do.
+void nv3_pfifo_cache1_puller_timer(void* priv)
+{
+    uint32_t pulled = nv3_pfifo_cache1_drain(NV3_PFIFO_CACHE1_PULLER_BATCH);
+
+    // If we stalled, someone else (a PFIFO register write, or the memory clock) has to restart us
+    if (pulled
+    && !nv3_pfifo_cache1_is_empty())
+        nv3_pfifo_cache1_wake_puller();
+}
+
 // THIS IS PER SUBCHANNEL!
 uint32_t nv3_pfifo_cache1_num_free_spaces(void)
 {
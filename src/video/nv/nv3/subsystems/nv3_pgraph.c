@@ -19,25 +19,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <86box/86box.h>
 #include <86box/device.h>
+#include <86box/dma.h>
 #include <86box/mem.h>
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PGRAPH
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 #include <86box/nv/classes/vid_nv3_classes.h>
 
-// Initialise the PGRAPH subsystem.
-void nv3_pgraph_init(void)
-{
-    nv_log("Initialising PGRAPH...");
-    // Set up the vblank interrupt
-    nv3->nvbase.svga.vblank_start = nv3_pgraph_vblank_start;
-    nv_log("Done!\n");    
-}
-
 //
 // ****** PGRAPH register list START ******
 //
@@ -91,6 +85,19 @@ nv_register_t pgraph_registers[] = {
     { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
 };
 
+nv_register_table_t pgraph_register_table;     // Built from pgraph_registers in nv3_pgraph_init
+
+// Initialise the PGRAPH subsystem.
+void nv3_pgraph_init(void)
+{
+    nv_register_table_build(&pgraph_register_table, pgraph_registers, sizeof(pgraph_registers)/sizeof(pgraph_registers[0]));
+
+    nv_log("Initialising PGRAPH...");
+    // Set up the vblank interrupt
+    nv3->nvbase.svga.vblank_start = nv3_pgraph_vblank_start;
+    nv_log("Done!\n");    
+}
+
 uint32_t nv3_pgraph_read(uint32_t address) 
 { 
     // before doing anything, check that this is even enabled..
@@ -104,7 +111,7 @@ uint32_t nv3_pgraph_read(uint32_t address)
 
     uint32_t ret = 0x00;
 
-    nv_register_t* reg = nv_get_register(address, pgraph_registers, sizeof(pgraph_registers)/sizeof(pgraph_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pgraph_register_table, address);
 
     // todo: friendly logging
     
@@ -295,7 +302,7 @@ void nv3_pgraph_write(uint32_t address, uint32_t value)
         return;
     }
 
-    nv_register_t* reg = nv_get_register(address, pgraph_registers, sizeof(pgraph_registers)/sizeof(pgraph_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pgraph_register_table, address);
 
     nv_log_verbose_only("PGRAPH Write 0x%08x -> 0x%08x\n", value, address);
 
@@ -511,6 +518,136 @@ void nv3_pgraph_vblank_start(svga_t* svga)
     nv3_pgraph_interrupt_valid(NV3_PGRAPH_INTR_0_VBLANK);
 }
 
+/* 
+    Translate an offset into a DMA object (at dma_object in RAMIN) into an address on the object's target.
+    DMA objects use the same layout as notifier objects: info (adjust + target), limit, then one page table entry per 4KB page. 
+    Returns how many bytes can be accessed from there before the next page or the end of the object, or 0 if it can't be accessed at all.
+*/
+static uint32_t nv3_pgraph_dma_translate(uint32_t dma_object, uint32_t offset, bool write, uint32_t* address, uint8_t* target)
+{
+    uint32_t info = nv3_ramin_read32(dma_object, nv3);
+    uint32_t limit = nv3_ramin_read32(dma_object + 0x04, nv3);
+
+    if (offset > limit)
+        return 0;
+
+    uint32_t adjusted = offset + (info & 0xFFF);
+    bool pt_present = (info >> NV3_NOTIFICATION_PT_PRESENT) & 0x01;
+    uint32_t page = 0, left = 0;
+
+    /* Without a pagetable, the object is just one contiguous block starting at the first page */
+    if (pt_present)
+    {
+        page = nv3_ramin_read32(dma_object + 0x08 + ((adjusted >> 12) << 2), nv3);
+        *address = (page & 0xFFFFF000) + (adjusted & 0xFFF);
+        left = 0x1000 - (adjusted & 0xFFF);
+    }
+    else
+    {
+        page = nv3_ramin_read32(dma_object + 0x08, nv3);
+        *address = (page & 0xFFFFF000) + adjusted;
+        left = (limit - offset) + 1;
+    }
+
+    if (!((page >> NV3_NOTIFICATION_PAGE_IS_PRESENT) & 0x01))
+        return 0;
+
+    if (write 
+    && !((page >> NV3_NOTIFICATION_PAGE_ACCESS) & 0x01))
+        return 0;
+
+    if ((left - 1) > (limit - offset))
+        left = (limit - offset) + 1;
+
+    *target = (info >> NV3_NOTIFICATION_TARGET) & 0x03;
+    return left;
+}
+
+/* 
+    Bulk transfer between a buffer and a DMA object, a page at a time. 
+    VRAM is accessed directly, system memory goes through the bus master DMA functions. 
+    Fires an INVALID_DATA interrupt and returns false if any of it can't be accessed.
+*/
+static bool nv3_pgraph_dma_transfer(uint32_t dma_object, uint32_t offset, uint8_t* buffer, uint32_t size, bool write)
+{
+    uint32_t vram_mask = nv3->nvbase.svga.vram_mask;
+
+    while (size)
+    {
+        uint32_t address = 0;
+        uint8_t target = 0;
+        uint32_t chunk = nv3_pgraph_dma_translate(dma_object, offset, write, &address, &target);
+
+        if (!chunk)
+        {
+            nv_log("DMA %s of object 0x%08x offset 0x%08x failed (past limit or page not present)\n", (write) ? "write" : "read", dma_object, offset);
+            nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_INVALID_DATA);
+            return false;
+        }
+
+        if (chunk > size)
+            chunk = size;
+
+        switch (target)
+        {
+            case NV3_NOTIFICATION_TARGET_NVM:
+                address &= vram_mask;
+
+                /* Don't run off the end of VRAM */
+                if ((address + chunk - 1) > vram_mask)
+                    chunk = (vram_mask - address) + 1;
+
+                if (write)
+                {
+                    memcpy(&nv3->nvbase.svga.vram[address], buffer, chunk);
+
+                    // The top of VRAM is RAMIN
+                    if ((address + chunk - 1) >= nv3->ramht.cache_vram_floor)
+                        nv3_ramht_cache_invalidate();
+
+                    for (uint32_t vram_page = (address >> 12); vram_page <= ((address + chunk - 1) >> 12); vram_page++)
+                        nv3->nvbase.svga.changedvram[vram_page] = changeframecount;
+
+                    nv3_render_mark_vram_dirty(address, chunk);
+                }
+                else
+                    memcpy(buffer, &nv3->nvbase.svga.vram[address], chunk);
+
+                break;
+            case NV3_NOTIFICATION_TARGET_PCI:
+            case NV3_NOTIFICATION_TARGET_AGP:
+                if (write)
+                    dma_bm_write(address, buffer, chunk, 4);
+                else
+                    dma_bm_read(address, buffer, chunk, 4);
+
+                break;
+            default:
+                nv_log("DMA to cartridge target. THIS SHOULD NEVER HAPPEN!!!!!\n");
+                nv3_pgraph_interrupt_invalid(NV3_PGRAPH_INTR_1_INVALID_DATA);
+                return false;
+        }
+
+        buffer += chunk;
+        offset += chunk;
+        size -= chunk;
+    }
+
+    return true;
+}
+
+/* Read size bytes starting at offset in a DMA object */
+bool nv3_pgraph_dma_read(uint32_t dma_object, uint32_t offset, uint8_t* buffer, uint32_t size)
+{
+    return nv3_pgraph_dma_transfer(dma_object, offset, buffer, size, false);
+}
+
+/* Write size bytes starting at offset in a DMA object */
+bool nv3_pgraph_dma_write(uint32_t dma_object, uint32_t offset, const uint8_t* buffer, uint32_t size)
+{
+    return nv3_pgraph_dma_transfer(dma_object, offset, (uint8_t*)buffer, size, true);
+}
+
 /* Sends off method execution to the right class */
 void nv3_pgraph_arbitrate_method(uint32_t param, uint16_t method, uint8_t channel, uint8_t subchannel, uint8_t class_id, nv3_ramin_context_t context)
 {
@@ -520,15 +657,29 @@ void nv3_pgraph_arbitrate_method(uint32_t param, uint16_t method, uint8_t channe
     // we need to shift left by 4 to get the real address, something to do with the 16 byte unit of reversal 
     uint32_t real_ramin_base = context.ramin_offset << 4;
 
-    // readin our grobj
-    grobj.grobj_0 = nv3_ramin_read32(real_ramin_base, nv3);
-    grobj.grobj_1 = nv3_ramin_read32(real_ramin_base + 4, nv3);
-    grobj.grobj_2 = nv3_ramin_read32(real_ramin_base + 8, nv3);
-    grobj.grobj_3 = nv3_ramin_read32(real_ramin_base + 12, nv3);
+    // readin our grobj, unless nothing touched RAMIN since we last did
+    if (!nv3_ramht_cache_get_grobj(channel, subchannel, context, &grobj))
+    {
+        grobj.grobj_0 = nv3_ramin_read32(real_ramin_base, nv3);
+        grobj.grobj_1 = nv3_ramin_read32(real_ramin_base + 4, nv3);
+        grobj.grobj_2 = nv3_ramin_read32(real_ramin_base + 8, nv3);
+        grobj.grobj_3 = nv3_ramin_read32(real_ramin_base + 12, nv3);
+
+        nv3_ramht_cache_store_grobj(channel, subchannel, context, grobj);
+    }
 
     nv_log_verbose_only("**** About to execute method **** method=0x%04x param=0x%08x, channel=%d.%d, class=%s, grobj=0x%08x 0x%08x 0x%08x 0x%08x\n",
         method, param, channel, subchannel, nv3_class_names[class_id], grobj.grobj_0, grobj.grobj_1, grobj.grobj_2, grobj.grobj_3);
 
+    /* Only D3D5 triangles can be drawn while the render threads are still busy, everything else might touch what they are drawing */
+    if (class_id != nv3_pgraph_class17_d3d5tri_zeta_buffer)
+        nv3_render_d3d5_wait_idle();
+
+    /* Images from the CPU are drawn a row at a time, so draw what's left of the row before anything else can see VRAM */
+    if (nv3->pgraph.image_staging.staged
+    && (class_id != nv3->pgraph.image_staging.class_id || method < NV3_IMAGE_COLOR_START))
+        nv3_render_image_flush();
+
     /* Methods below 0x104 are shared across all classids, so call generic_method for that*/
     if (method <= NV3_SET_NOTIFY)
     {
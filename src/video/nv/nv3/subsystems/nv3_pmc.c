@@ -25,11 +25,28 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PMC
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
+//
+// ****** PMC register list START ******
+//
+
+nv_register_t pmc_registers[] = {
+    { NV3_PMC_BOOT, "PMC: Boot Manufacturing Information", NULL, NULL },
+    { NV3_PMC_INTERRUPT_STATUS, "PMC: Current Pending Subsystem Interrupts", NULL, NULL},
+    { NV3_PMC_INTERRUPT_ENABLE, "PMC: Global Interrupt Enable", NULL, NULL,},
+    { NV3_PMC_ENABLE, "PMC: Global Subsystem Enable", NULL, NULL },
+    { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
+};
+
+nv_register_table_t pmc_register_table;     // Built from pmc_registers in nv3_pmc_init
+
 void nv3_pmc_init(void)
 {
+    nv_register_table_build(&pmc_register_table, pmc_registers, sizeof(pmc_registers)/sizeof(pmc_registers[0]));
+
     nv_log("Initialising PMC....\n");
 
     if (nv3->nvbase.gpu_revision == NV3_PCI_CFG_REVISION_A00)
@@ -44,18 +61,6 @@ void nv3_pmc_init(void)
     nv_log("Initialising PMC: Done\n");
 }
 
-//
-// ****** PMC register list START ******
-//
-
-nv_register_t pmc_registers[] = {
-    { NV3_PMC_BOOT, "PMC: Boot Manufacturing Information", NULL, NULL },
-    { NV3_PMC_INTERRUPT_STATUS, "PMC: Current Pending Subsystem Interrupts", NULL, NULL},
-    { NV3_PMC_INTERRUPT_ENABLE, "PMC: Global Interrupt Enable", NULL, NULL,},
-    { NV3_PMC_ENABLE, "PMC: Global Subsystem Enable", NULL, NULL },
-    { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
-};
-
 uint32_t nv3_pmc_clear_interrupts(void)
 {
     nv_log_verbose_only("Clearing IRQs\n");
@@ -171,7 +176,7 @@ uint32_t nv3_pmc_handle_interrupts(bool send_now)
 
 uint32_t nv3_pmc_read(uint32_t address) 
 { 
-    nv_register_t* reg = nv_get_register(address, pmc_registers, sizeof(pmc_registers)/sizeof(pmc_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pmc_register_table, address);
 
     uint32_t ret = 0x00;
 
@@ -223,7 +228,7 @@ uint32_t nv3_pmc_read(uint32_t address)
 
 void nv3_pmc_write(uint32_t address, uint32_t value) 
 {
-    nv_register_t* reg = nv_get_register(address, pmc_registers, sizeof(pmc_registers)/sizeof(pmc_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pmc_register_table, address);
 
     nv_log_verbose_only("PMC Write 0x%08x -> 0x%08x", value, address);
 
@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PME
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -34,8 +35,12 @@ nv_register_t pme_registers[] = {
     { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
 };
 
+nv_register_table_t pme_register_table;     // Built from pme_registers in nv3_pme_init
+
 void nv3_pme_init(void)
 {  
+    nv_register_table_build(&pme_register_table, pme_registers, sizeof(pme_registers)/sizeof(pme_registers[0]));
+
     nv_log("Initialising PME...");
 
     nv_log("Done\n");
@@ -43,7 +48,7 @@ void nv3_pme_init(void)
 
 uint32_t nv3_pme_read(uint32_t address) 
 { 
-    nv_register_t* reg = nv_get_register(address, pme_registers, sizeof(pme_registers)/sizeof(pme_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pme_register_table, address);
 
     uint32_t ret = 0x00;
 
@@ -91,7 +96,7 @@ uint32_t nv3_pme_read(uint32_t address)
 
 void nv3_pme_write(uint32_t address, uint32_t value) 
 {
-    nv_register_t* reg = nv_get_register(address, pme_registers, sizeof(pme_registers)/sizeof(pme_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pme_register_table, address);
 
     nv_log_verbose_only("PME Write 0x%08x -> 0x%08x\n", value, address);
 
@@ -28,26 +28,10 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PRAMDAC
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
-void nv3_pramdac_init(void)
-{
-    nv_log("Initialising PRAMDAC\n");
-
-    // defaults, these come from vbios in reality
-    // driver defaults are nonsensical(?), or the algorithm is wrong
-    // munged this to 100mhz for now
-    nv3->pramdac.memory_clock_m = nv3->pramdac.pixel_clock_m = 0x07;
-    nv3->pramdac.memory_clock_n = nv3->pramdac.pixel_clock_n = 0xc8;
-    nv3->pramdac.memory_clock_p = nv3->pramdac.pixel_clock_p = 0x0c;
-
-    nv3_pramdac_set_pixel_clock();
-    nv3_pramdac_set_vram_clock();
-
-    nv_log("Initialising PRAMDAC: Done\n");
-}
-
 // Polls the pixel clock.
 void nv3_pramdac_pixel_clock_poll(double real_time)
 {
@@ -55,30 +39,17 @@ void nv3_pramdac_pixel_clock_poll(double real_time)
     if (!nv3->nvbase.svga.override)
         return; 
 
-    /* Figure out our refresh time. */
-    if (!nv3->nvbase.refresh_time)
-        nv3->nvbase.refresh_time = (1/60.0); // rivatimers count in microseconds but present the info as seconds
-        
-    nv3->nvbase.refresh_clock += real_time;
-
-    if (nv3->nvbase.refresh_clock > nv3->nvbase.refresh_time)
-    {
-        /* Update the screen because something changed */
-        video_blit_memtoscreen(0, 0, xsize, ysize);
-        nv3->nvbase.refresh_clock = 0;
-    }
+    /* The screen is presented once per frame at vsync by nv3_render_present, so there is nothing to blit here */
 
     // TODO: ????
 }
 
 // Polls the memory clock.
-// This updates the 2D/3D engine PGRAPH, PTIMER and more 
+// This updates the 2D/3D engine PGRAPH and more. PTIMER works its time out when it's read, so it doesn't need to be ticked here
 void nv3_pramdac_memory_clock_poll(double real_time)
 {
-    nv3_ptimer_tick(real_time);
-
     nv3_pfifo_cache0_pull();
-    nv3_pfifo_cache1_pull();
+    nv3_pfifo_cache1_drain(NV3_PFIFO_CACHE1_PULLER_BATCH);
     // TODO: UPDATE PGRAPH!
 }
 
@@ -139,6 +110,9 @@ void nv3_pramdac_set_vram_clock(void)
     nv_log("Memory clock = %.2f MHz\n", frequency / 1000000.0f);    
 
     nv3->nvbase.memory_clock_frequency = frequency;
+
+    // PTIMER counts from this clock
+    nv3_ptimer_update_rate();
     
     // Create and start if it it's not running.
     if (!nv3->nvbase.memory_clock_timer)
@@ -208,6 +182,7 @@ nv_register_t pramdac_registers[] =
     { NV3_PRAMDAC_CLOCK_PIXEL, "PRAMDAC - NV3 GPU Core - Pixel clock", nv3_pramdac_get_pixel_clock_register, nv3_pramdac_set_pixel_clock_register },
     { NV3_PRAMDAC_CLOCK_MEMORY, "PRAMDAC - NV3 GPU Core - Memory clock", nv3_pramdac_get_vram_clock_register, nv3_pramdac_set_vram_clock_register },
     { NV3_PRAMDAC_COEFF_SELECT, "PRAMDAC - PLL Clock Coefficient Select", NULL, NULL},
+    { NV3_PRAMDAC_CURSOR_START, "PRAMDAC - Cursor Position", NULL, NULL },
     { NV3_PRAMDAC_GENERAL_CONTROL, "PRAMDAC - General Control", NULL, NULL },
     { NV3_PRAMDAC_VSERR_WIDTH, "PRAMDAC - Vertical Sync Error Width", NULL, NULL},
     { NV3_PRAMDAC_VEQU_END, "PRAMDAC - VEqu End", NULL, NULL},
@@ -228,13 +203,34 @@ nv_register_t pramdac_registers[] =
     { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
 };
 
+nv_register_table_t pramdac_register_table;     // Built from pramdac_registers in nv3_pramdac_init
+
+void nv3_pramdac_init(void)
+{
+    nv_register_table_build(&pramdac_register_table, pramdac_registers, sizeof(pramdac_registers)/sizeof(pramdac_registers[0]));
+
+    nv_log("Initialising PRAMDAC\n");
+
+    // defaults, these come from vbios in reality
+    // driver defaults are nonsensical(?), or the algorithm is wrong
+    // munged this to 100mhz for now
+    nv3->pramdac.memory_clock_m = nv3->pramdac.pixel_clock_m = 0x07;
+    nv3->pramdac.memory_clock_n = nv3->pramdac.pixel_clock_n = 0xc8;
+    nv3->pramdac.memory_clock_p = nv3->pramdac.pixel_clock_p = 0x0c;
+
+    nv3_pramdac_set_pixel_clock();
+    nv3_pramdac_set_vram_clock();
+
+    nv_log("Initialising PRAMDAC: Done\n");
+}
+
 //
 // ****** Read/Write functions start ******
 //
 
 uint32_t nv3_pramdac_read(uint32_t address) 
 { 
-    nv_register_t* reg = nv_get_register(address, pramdac_registers, sizeof(pramdac_registers)/sizeof(pramdac_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pramdac_register_table, address);
 
     uint32_t ret = 0x00;
 
@@ -256,6 +252,9 @@ uint32_t nv3_pramdac_read(uint32_t address)
                 case NV3_PRAMDAC_COEFF_SELECT:
                     ret = nv3->pramdac.coeff_select;
                     break;
+                case NV3_PRAMDAC_CURSOR_START:
+                    ret = nv3->pramdac.cursor_start;
+                    break;
                 case NV3_PRAMDAC_GENERAL_CONTROL:
                     ret = nv3->pramdac.general_control;
                     break;
@@ -319,7 +318,7 @@ uint32_t nv3_pramdac_read(uint32_t address)
 
 void nv3_pramdac_write(uint32_t address, uint32_t value) 
 {
-    nv_register_t* reg = nv_get_register(address, pramdac_registers, sizeof(pramdac_registers)/sizeof(pramdac_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pramdac_register_table, address);
 
     nv_log_verbose_only("PRAMDAC Write 0x%08x -> 0x%08x\n", value, address);
 
@@ -340,6 +339,10 @@ void nv3_pramdac_write(uint32_t address, uint32_t value)
                 case NV3_PRAMDAC_COEFF_SELECT:
                     nv3->pramdac.coeff_select = value;
                     break;
+                case NV3_PRAMDAC_CURSOR_START:
+                    nv3->pramdac.cursor_start = value & 0x0FFF0FFF;
+                    nv3_render_cursor_set_position(nv3->pramdac.cursor_start);
+                    break;
                 case NV3_PRAMDAC_GENERAL_CONTROL:
                     nv3->pramdac.general_control = value;
                     nv3_recalc_timings(&nv3->nvbase.svga);
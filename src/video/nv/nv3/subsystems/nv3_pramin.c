@@ -26,6 +26,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PRAMIN
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 #include <86box/nv/classes/vid_nv3_classes.h>
@@ -125,6 +126,9 @@ void nv3_ramin_write8(uint32_t addr, uint8_t val, void* priv)
 {
     if (!nv3) return;
 
+    // Objects might have changed under us
+    nv3_ramht_cache_invalidate();
+
     addr &= (nv3->nvbase.svga.vram_max - 1);
     uint32_t raw_addr = addr; // saved after and
 
@@ -139,6 +143,7 @@ void nv3_ramin_write8(uint32_t addr, uint8_t val, void* priv)
     if (!nv3_ramin_arbitrate_write(addr, val32))
     {
         nv3->nvbase.svga.vram[addr] = val;
+        nv3_cursor_vram_written(addr, 1);
         nv_log_verbose_only("Write byte to PRAMIN addr=0x%08x val=0x%02x (raw address=0x%08x)\n", addr, val, raw_addr);
     }
 
@@ -150,6 +155,9 @@ void nv3_ramin_write16(uint32_t addr, uint16_t val, void* priv)
 {
     if (!nv3) return;
 
+    // Objects might have changed under us
+    nv3_ramht_cache_invalidate();
+
     addr &= (nv3->nvbase.svga.vram_max - 1);
 
     // why does this not work in one line
@@ -165,6 +173,7 @@ void nv3_ramin_write16(uint32_t addr, uint16_t val, void* priv)
     if (!nv3_ramin_arbitrate_write(addr, val32))
     {
         vram_16bit[addr] = val;
+        nv3_cursor_vram_written(addr << 1, 2);
         nv_log_verbose_only("Write word to PRAMIN addr=0x%08x val=0x%04x (raw address=0x%08x)\n", addr, val, raw_addr);
     }
 
@@ -176,6 +185,9 @@ void nv3_ramin_write32(uint32_t addr, uint32_t val, void* priv)
 {
     if (!nv3) return;
 
+    // Objects might have changed under us
+    nv3_ramht_cache_invalidate();
+
     addr &= (nv3->nvbase.svga.vram_max - 1);
 
     // why does this not work in one line
@@ -189,6 +201,7 @@ void nv3_ramin_write32(uint32_t addr, uint32_t val, void* priv)
     if (!nv3_ramin_arbitrate_write(addr, val))
     {
         vram_32bit[addr] = val;
+        nv3_cursor_vram_written(addr << 2, 4);
         nv_log_verbose_only("Write dword to PRAMIN addr=0x%08x val=0x%08x (raw address=0x%08x)\n", addr, val, raw_addr);
     }
 
@@ -387,7 +400,10 @@ bool nv3_ramin_find_object(uint32_t name, uint32_t cache_num, uint8_t channel, u
     uint32_t found_obj_name = 0x00;
     nv3_ramin_context_t obj_context_struct = {0};
 
-    for (uint32_t bucket_entry = 0; bucket_entry < bucket_entries; bucket_entry++)
+    // See if we already looked this one up
+    found_object = nv3_ramht_cache_find_object(name, channel, subchannel, &obj_context_struct);
+
+    for (uint32_t bucket_entry = 0; !found_object && bucket_entry < bucket_entries; bucket_entry++)
     {
         found_obj_name = nv3_ramin_read32(ramht_cur_address, NULL);
         ramht_cur_address += 0x04;
@@ -400,6 +416,7 @@ bool nv3_ramin_find_object(uint32_t name, uint32_t cache_num, uint8_t channel, u
             && obj_context_struct.channel == channel)
         {
             found_object = true;
+            nv3_ramht_cache_store_object(name, channel, subchannel, obj_context_struct, ramht_cur_address - 0x08);
             break;
         }
     }
@@ -446,9 +463,8 @@ bool nv3_ramin_find_object(uint32_t name, uint32_t cache_num, uint8_t channel, u
     // Illegal accesses sent to RAMRO, so ignore here
     // TODO: SEND THESE TO RAMRO!!!!!
 
-    #ifndef RELEASE_BUILD
-    nv3_debug_ramin_print_context_info(name, obj_context_struct);
-    #endif
+    if (nv_log_enabled(NV_LOG_LEVEL_VERBOSE, NV_LOG_PRAMIN))
+        nv3_debug_ramin_print_context_info(name, obj_context_struct);
 
     // By definition we can't have a cache error by here so take it off
     if (!cache_num)
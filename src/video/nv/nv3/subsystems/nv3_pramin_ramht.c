@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PRAMIN
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -53,3 +54,99 @@ void nv3_ramht_write(uint32_t address, uint32_t value)
 {
     nv_log_verbose_only("RAMHT (Graphics object storage hashtable) Write (0x%04x -> 0x%04x), I DON'T BELIEVE THIS SHOULD EVER HAPPEN - UNIMPLEMENTED\n", value, address);
 }
+
+/* RAMHT object translation cache
+
+   Walking RAMHT for every object bind, and reading the grobj out of RAMIN for every method, is slow. So we remember what we found for each [channel, subchannel].
+   Anything that writes to RAMIN flushes the whole thing, since drivers only really do that when they create or destroy objects.
+*/
+
+// Track the VRAM address backing a cached RAMIN address so that DFB writes to it can flush the cache
+static void nv3_ramht_cache_track(uint32_t ramin_address)
+{
+    uint32_t vram_address = (ramin_address & (nv3->nvbase.svga.vram_max - 1)) ^ (nv3->nvbase.svga.vram_max - 0x10);
+
+    vram_address &= ~0x0F; // reversal unit is 16 bytes
+
+    if (vram_address < nv3->ramht.cache_vram_floor)
+        nv3->ramht.cache_vram_floor = vram_address;
+}
+
+void nv3_ramht_cache_invalidate(void)
+{
+    for (uint32_t channel = 0; channel < NV3_DMA_CHANNELS; channel++)
+    {
+        for (uint32_t subchannel = 0; subchannel < NV3_DMA_SUBCHANNELS_PER_CHANNEL; subchannel++)
+        {
+            nv3->ramht.subchannels[channel][subchannel].name_valid = false;
+            nv3->ramht.subchannels[channel][subchannel].grobj_valid = false;
+        }
+    }
+
+    nv3->ramht.cache_vram_floor = nv3->nvbase.svga.vram_max;
+}
+
+bool nv3_ramht_cache_find_object(uint32_t name, uint8_t channel, uint8_t subchannel, nv3_ramin_context_t* context)
+{
+    if (channel >= NV3_DMA_CHANNELS
+    || subchannel >= NV3_DMA_SUBCHANNELS_PER_CHANNEL)
+        return false;
+
+    nv3_ramin_ramht_subchannel_t* entry = &nv3->ramht.subchannels[channel][subchannel];
+
+    if (!entry->name_valid
+    || entry->name != name)
+        return false;
+
+    *context = entry->context;
+    return true;
+}
+
+void nv3_ramht_cache_store_object(uint32_t name, uint8_t channel, uint8_t subchannel, nv3_ramin_context_t context, uint32_t ramht_address)
+{
+    if (channel >= NV3_DMA_CHANNELS
+    || subchannel >= NV3_DMA_SUBCHANNELS_PER_CHANNEL)
+        return;
+
+    nv3_ramin_ramht_subchannel_t* entry = &nv3->ramht.subchannels[channel][subchannel];
+
+    entry->name = name;
+    entry->context = context;
+    entry->name_valid = true;
+
+    // Both dwords of the RAMHT entry
+    nv3_ramht_cache_track(ramht_address);
+    nv3_ramht_cache_track(ramht_address + 4);
+}
+
+bool nv3_ramht_cache_get_grobj(uint8_t channel, uint8_t subchannel, nv3_ramin_context_t context, nv3_grobj_t* grobj)
+{
+    if (channel >= NV3_DMA_CHANNELS
+    || subchannel >= NV3_DMA_SUBCHANNELS_PER_CHANNEL)
+        return false;
+
+    nv3_ramin_ramht_subchannel_t* entry = &nv3->ramht.subchannels[channel][subchannel];
+
+    if (!entry->grobj_valid
+    || entry->grobj_ramin_offset != context.ramin_offset)
+        return false;
+
+    *grobj = entry->grobj;
+    return true;
+}
+
+void nv3_ramht_cache_store_grobj(uint8_t channel, uint8_t subchannel, nv3_ramin_context_t context, nv3_grobj_t grobj)
+{
+    if (channel >= NV3_DMA_CHANNELS
+    || subchannel >= NV3_DMA_SUBCHANNELS_PER_CHANNEL)
+        return;
+
+    nv3_ramin_ramht_subchannel_t* entry = &nv3->ramht.subchannels[channel][subchannel];
+
+    entry->grobj = grobj;
+    entry->grobj_ramin_offset = context.ramin_offset;
+    entry->grobj_valid = true;
+
+    // grobj is one 16-byte reversal unit
+    nv3_ramht_cache_track(context.ramin_offset << 4);
+}
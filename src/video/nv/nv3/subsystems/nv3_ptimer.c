@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PTIMER
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -40,9 +41,13 @@ nv_register_t ptimer_registers[] = {
     { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
 };
 
+nv_register_table_t ptimer_register_table;     // Built from ptimer_registers in nv3_ptimer_init
+
 // ptimer init code
 void nv3_ptimer_init(void)
 {
+    nv_register_table_build(&ptimer_register_table, ptimer_registers, sizeof(ptimer_registers)/sizeof(ptimer_registers[0]));
+
     nv_log("Initialising PTIMER...");
 
     nv_log("Done!\n");    
@@ -56,42 +61,97 @@ void nv3_ptimer_interrupt(uint32_t num)
     nv3_pmc_handle_interrupts(true);
 }
 
-// Ticks the timer.
-void nv3_ptimer_tick(double real_time)
+/*
+    PTIMER isn't ticked. time is only worked out when something reads it, from how long it has been since it was last brought up to date,
+    and the alarm is a one-shot rivatimer set for when time will reach it. Drivers read TIME constantly, so this is a lot cheaper than counting
+    it up on every memory clock poll, and it doesn't lose the fraction of a tick every time either.
+*/
+
+// Bring time up to date. Call this before anything that changes how fast it counts
+static void nv3_ptimer_sync(void)
 {
-    // prevent a divide by zero
-    if (nv3->ptimer.clock_numerator == 0
-    || nv3->ptimer.clock_denominator == 0)
-        return; 
+    double now = rivatimer_get_monotonic_time();
+
+    if (nv3->ptimer.rate > 0)
+        nv3->ptimer.time += (uint64_t)((now - nv3->ptimer.time_host) * nv3->ptimer.rate);
 
-    // get the current time
+    nv3->ptimer.time_host = now;
+}
+
+// Get the current value of time
+uint64_t nv3_ptimer_get_time(void)
+{
+    if (nv3->ptimer.rate <= 0)
+        return nv3->ptimer.time;
+
+    return nv3->ptimer.time + (uint64_t)((rivatimer_get_monotonic_time() - nv3->ptimer.time_host) * nv3->ptimer.rate);
+}
+
+static void nv3_ptimer_alarm_fire(double real_time);
+
+// Set the alarm timer for when the low 32 bits of time next reach the alarm value
+static void nv3_ptimer_schedule_alarm(void)
+{
+    if (nv3->ptimer.alarm_timer)
+        rivatimer_stop(nv3->ptimer.alarm_timer);
 
-    // See Envytools. We need to use the frequency as a source. 
-    // We need to figure out how many cycles actually occurred because this counts up every cycle...
-    // However it seems that their formula is wrong. I can't be bothered to figure out what's going on and, based on documentation from NVIDIA,
-    // timer_0 is meant to roll over every 4 seconds. Multiplying by 10 basically does the job.
+    // Time isn't moving, so it will never get there
+    if (nv3->ptimer.rate <= 0)
+        return;
 
-    // Convert to microseconds
-    double freq_base = (real_time / 1000000.0f) / ((double)1.0 / nv3->nvbase.memory_clock_frequency) * 10.0f;
-    double current_time = freq_base * ((double)nv3->ptimer.clock_numerator) / (double)nv3->ptimer.clock_denominator; // *10.0?
+    uint32_t remaining = nv3->ptimer.alarm - (uint32_t)nv3_ptimer_get_time();
+    double period = (double)remaining / nv3->ptimer.rate;
 
-    // truncate it 
-    nv3->ptimer.time += (uint64_t)current_time;
+    // Rivatimers can't have a zero period
+    if (period < 1.0)
+        period = 1.0;
 
-    // Check if the alarm has actually triggered..
+    if (!nv3->ptimer.alarm_timer)
+        nv3->ptimer.alarm_timer = rivatimer_create(period, nv3_ptimer_alarm_fire);
+    else
+        rivatimer_set_period(nv3->ptimer.alarm_timer, period);
+
+    rivatimer_start(nv3->ptimer.alarm_timer);
+}
+
+// The alarm timer went off
+static void nv3_ptimer_alarm_fire(double real_time)
+{
     // Only log on ptimer alarm. Otherwise, it's too much spam.
-    if (nv3->ptimer.time >= nv3->ptimer.alarm)
+    nv_log_verbose_only("PTIMER alarm interrupt fired (if interrupts enabled) because we reached TIME value 0x%08x\n", nv3->ptimer.alarm);
+    nv3_ptimer_interrupt(NV3_PTIMER_INTR_ALARM);
+
+    // The low 32 bits will get back round to it again
+    nv3_ptimer_schedule_alarm();
+}
+
+// Work out how fast time counts. Called when the numerator, denominator or memory clock change
+void nv3_ptimer_update_rate(void)
+{
+    nv3_ptimer_sync();
+
+    // prevent a divide by zero
+    if (nv3->ptimer.clock_numerator == 0
+    || nv3->ptimer.clock_denominator == 0)
+        nv3->ptimer.rate = 0;
+    else
     {
-        nv_log_verbose_only("PTIMER alarm interrupt fired (if interrupts enabled) because we reached TIME value 0x%08x\n", nv3->ptimer.alarm);
-        nv3_ptimer_interrupt(NV3_PTIMER_INTR_ALARM);
+        // See Envytools. We need to use the frequency as a source. 
+        // We need to figure out how many cycles actually occurred because this counts up every cycle...
+        // However it seems that their formula is wrong. I can't be bothered to figure out what's going on and, based on documentation from NVIDIA,
+        // timer_0 is meant to roll over every 4 seconds. Multiplying by 10 basically does the job.
+        nv3->ptimer.rate = (nv3->nvbase.memory_clock_frequency / 1000000.0) * 10.0 
+            * (double)nv3->ptimer.clock_numerator / (double)nv3->ptimer.clock_denominator;
     }
+
+    nv3_ptimer_schedule_alarm();
 }
 
 uint32_t nv3_ptimer_read(uint32_t address) 
 { 
     // always enabled
 
-    nv_register_t* reg = nv_get_register(address, ptimer_registers, sizeof(ptimer_registers)/sizeof(ptimer_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&ptimer_register_table, address);
 
     // Only log these when tehy actually tick
     if (address != NV3_PTIMER_TIME_0_NSEC
@@ -130,11 +190,11 @@ uint32_t nv3_ptimer_read(uint32_t address)
                 // 64-bit value
                 // High part
                 case NV3_PTIMER_TIME_0_NSEC:
-                    ret = nv3->ptimer.time & 0xFFFFFFFF; //28:0
+                    ret = nv3_ptimer_get_time() & 0xFFFFFFE0; // 31:5
                     break;
                 // Low part
                 case NV3_PTIMER_TIME_1_NSEC:
-                    ret = nv3->ptimer.time >> 32; // 31:5
+                    ret = (nv3_ptimer_get_time() >> 32) & 0x1FFFFFFF; // 28:0
                     break;
                 case NV3_PTIMER_ALARM_NSEC: 
                     ret = nv3->ptimer.alarm; // 31:5
@@ -163,7 +223,7 @@ uint32_t nv3_ptimer_read(uint32_t address)
 void nv3_ptimer_write(uint32_t address, uint32_t value) 
 {
     // before doing anything, check the subsystem enablement
-    nv_register_t* reg = nv_get_register(address, ptimer_registers, sizeof(ptimer_registers)/sizeof(ptimer_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&ptimer_register_table, address);
 
     nv_log_verbose_only("PTIMER Write 0x%08x -> 0x%08x", value, address);
 
@@ -197,6 +257,7 @@ void nv3_ptimer_write(uint32_t address, uint32_t value)
                 // nUMERATOR
                 case NV3_PTIMER_NUMERATOR:
                     nv3->ptimer.clock_numerator = value & 0xFFFF; // 15:0
+                    nv3_ptimer_update_rate();
                     break;
                 case NV3_PTIMER_DENOMINATOR:
                     // prevent Div0
@@ -204,18 +265,23 @@ void nv3_ptimer_write(uint32_t address, uint32_t value)
                         value = 1;
 
                     nv3->ptimer.clock_denominator = value & 0xFFFF; //15:0
+                    nv3_ptimer_update_rate();
                     break;
                 // 64-bit value
                 // High part
                 case NV3_PTIMER_TIME_0_NSEC:
-                    nv3->ptimer.time |= (value) & 0xFFFFFFE0; //28:0
+                    nv3_ptimer_sync();
+                    nv3->ptimer.time = (nv3->ptimer.time & 0xFFFFFFFF00000000ULL) | (value & 0xFFFFFFE0); // 31:5
+                    nv3_ptimer_schedule_alarm();
                     break;
                 // Low part
                 case NV3_PTIMER_TIME_1_NSEC:
-                    nv3->ptimer.time |= ((uint64_t)(value & 0xFFFFFFE0) << 32); // 31:5
+                    nv3_ptimer_sync();
+                    nv3->ptimer.time = (nv3->ptimer.time & 0xFFFFFFFF) | ((uint64_t)(value & 0x1FFFFFFF) << 32); // 28:0
                     break;
                 case NV3_PTIMER_ALARM_NSEC: 
                     nv3->ptimer.alarm = value & 0xFFFFFFE0; // 31:5
+                    nv3_ptimer_schedule_alarm();
                     break;
             }
         }
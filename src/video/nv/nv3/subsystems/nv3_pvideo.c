@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_PVIDEO
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -32,15 +33,34 @@
 nv_register_t pvideo_registers[] = {
     { NV3_PVIDEO_INTR, "PVIDEO - Interrupt Status", NULL, NULL},
     { NV3_PVIDEO_INTR_EN, "PVIDEO - Interrupt Enable", NULL, NULL,},
+    { NV3_PVIDEO_STEP_SIZE, "PVIDEO - Step Size", NULL, NULL},
+    { NV3_PVIDEO_CONTROL_Y, "PVIDEO - Control Y", NULL, NULL},
+    { NV3_PVIDEO_CONTROL_X, "PVIDEO - Control X", NULL, NULL},
+    { NV3_PVIDEO_BUFF0_START, "PVIDEO - Buffer 0 Start", NULL, NULL},
+    { NV3_PVIDEO_BUFF1_START, "PVIDEO - Buffer 1 Start", NULL, NULL},
+    { NV3_PVIDEO_BUFF0_PITCH, "PVIDEO - Buffer 0 Pitch", NULL, NULL},
+    { NV3_PVIDEO_BUFF1_PITCH, "PVIDEO - Buffer 1 Pitch", NULL, NULL},
+    { NV3_PVIDEO_BUFF0_OFFSET, "PVIDEO - Buffer 0 Offset", NULL, NULL},
+    { NV3_PVIDEO_BUFF1_OFFSET, "PVIDEO - Buffer 1 Offset", NULL, NULL},
+    { NV3_PVIDEO_OE_STATE, "PVIDEO - Output Engine State", NULL, NULL},
+    { NV3_PVIDEO_SU_STATE, "PVIDEO - Setup State", NULL, NULL},
+    { NV3_PVIDEO_RM_STATE, "PVIDEO - Resource Manager State", NULL, NULL},
+    { NV3_PVIDEO_WINDOW_START, "PVIDEO - Window Start", NULL, NULL},
+    { NV3_PVIDEO_WINDOW_SIZE, "PVIDEO - Window Size", NULL, NULL},
     { NV3_PVIDEO_FIFO_THRESHOLD, "PVIDEO - FIFO Fill Threshold", NULL, NULL},
     { NV3_PVIDEO_FIFO_BURST_LENGTH, "PVIDEO - FIFO Burst Length (1=32, 2=64, 3=128)", NULL, NULL},
+    { NV3_PVIDEO_KEY, "PVIDEO - Colour Key", NULL, NULL},
     { NV3_PVIDEO_OVERLAY, "PVIDEO - Overlay Info (Bit0 = Video On, Bit4 = Key On, Bit8 = Format, 0=CCIR, 1=YUV2)", NULL, NULL },
     { NV_REG_LIST_END, NULL, NULL, NULL}, // sentinel value 
 };
 
-// ptimer init code
+nv_register_table_t pvideo_register_table;     // Built from pvideo_registers in nv3_pvideo_init
+
+// pvideo init code
 void nv3_pvideo_init(void)
 {
+    nv_register_table_build(&pvideo_register_table, pvideo_registers, sizeof(pvideo_registers)/sizeof(pvideo_registers[0]));
+
     nv_log("Initialising PVIDEO...");
 
     nv_log("Done!\n");    
@@ -50,7 +70,7 @@ uint32_t nv3_pvideo_read(uint32_t address)
 { 
     // before doing anything, check the subsystem enablement
 
-    nv_register_t* reg = nv_get_register(address, pvideo_registers, sizeof(pvideo_registers)/sizeof(pvideo_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pvideo_register_table, address);
     uint32_t ret = 0x00;
     
     // todo: friendly logging
@@ -88,9 +108,48 @@ uint32_t nv3_pvideo_read(uint32_t address)
                     ret = nv3->pvideo.fifo_burst_size & 0x03;
                     break;
                 case NV3_PVIDEO_OVERLAY:
-                    ret = nv3->pvideo.overlay_settings & 0xFF;
+                    ret = nv3->pvideo.overlay_settings;
+                    break;
+                case NV3_PVIDEO_STEP_SIZE:
+                    ret = nv3->pvideo.step_size;
+                    break;
+                case NV3_PVIDEO_CONTROL_Y:
+                    ret = nv3->pvideo.control_y;
+                    break;
+                case NV3_PVIDEO_CONTROL_X:
+                    ret = nv3->pvideo.control_x;
+                    break;
+                case NV3_PVIDEO_BUFF0_START:
+                case NV3_PVIDEO_BUFF1_START:
+                    ret = nv3->pvideo.buffer_start[(reg->address - NV3_PVIDEO_BUFF0_START) >> 2];
+                    break;
+                case NV3_PVIDEO_BUFF0_PITCH:
+                case NV3_PVIDEO_BUFF1_PITCH:
+                    ret = nv3->pvideo.buffer_pitch[(reg->address - NV3_PVIDEO_BUFF0_PITCH) >> 2];
+                    break;
+                case NV3_PVIDEO_BUFF0_OFFSET:
+                case NV3_PVIDEO_BUFF1_OFFSET:
+                    ret = nv3->pvideo.buffer_offset[(reg->address - NV3_PVIDEO_BUFF0_OFFSET) >> 2];
+                    break;
+                case NV3_PVIDEO_OE_STATE:
+                    ret = nv3->pvideo.oe_state;
+                    break;
+                case NV3_PVIDEO_SU_STATE:
+                    ret = nv3->pvideo.su_state;
+                    break;
+                case NV3_PVIDEO_RM_STATE:
+                    ret = nv3->pvideo.rm_state;
+                    break;
+                case NV3_PVIDEO_WINDOW_START:
+                    ret = nv3->pvideo.window_start.x | (nv3->pvideo.window_start.y << 16);
+                    break;
+                case NV3_PVIDEO_WINDOW_SIZE:
+                    ret = nv3->pvideo.window_size.w | (nv3->pvideo.window_size.h << 16);
+                    break;
+                case NV3_PVIDEO_KEY:
+                    ret = nv3->pvideo.key;
                     break;
-                
+
             }
         }
 
@@ -110,7 +169,7 @@ uint32_t nv3_pvideo_read(uint32_t address)
 void nv3_pvideo_write(uint32_t address, uint32_t value) 
 {
     // before doing anything, check the subsystem enablement
-    nv_register_t* reg = nv_get_register(address, pvideo_registers, sizeof(pvideo_registers)/sizeof(pvideo_registers[0]));
+    nv_register_t* reg = nv_register_table_get(&pvideo_register_table, address);
 
     nv_log_verbose_only("PVIDEO Write 0x%08x -> 0x%08x\n", value, address);
 
@@ -147,7 +206,54 @@ void nv3_pvideo_write(uint32_t address, uint32_t value)
                     nv3->pvideo.fifo_burst_size = value & 0x03;
                     break;
                 case NV3_PVIDEO_OVERLAY:
-                    nv3->pvideo.overlay_settings = value & 0xFF;
+                    /* The overlay might have been turned off, so put back whatever was under it */
+                    nv3->pvideo.overlay_settings = value & 0x111;
+                    nv3_render_mark_full();
+                    break;
+                case NV3_PVIDEO_STEP_SIZE:
+                    nv3->pvideo.step_size = value & 0xFFF;
+                    nv3_render_mark_full();
+                    break;
+                case NV3_PVIDEO_CONTROL_Y:
+                    nv3->pvideo.control_y = value;
+                    break;
+                case NV3_PVIDEO_CONTROL_X:
+                    nv3->pvideo.control_x = value;
+                    break;
+                case NV3_PVIDEO_BUFF0_START:
+                case NV3_PVIDEO_BUFF1_START:
+                    nv3->pvideo.buffer_start[(reg->address - NV3_PVIDEO_BUFF0_START) >> 2] = value & (nv3->nvbase.svga.vram_max - 1);
+                    break;
+                case NV3_PVIDEO_BUFF0_PITCH:
+                case NV3_PVIDEO_BUFF1_PITCH:
+                    nv3->pvideo.buffer_pitch[(reg->address - NV3_PVIDEO_BUFF0_PITCH) >> 2] = value & 0x1FFE;
+                    break;
+                case NV3_PVIDEO_BUFF0_OFFSET:
+                case NV3_PVIDEO_BUFF1_OFFSET:
+                    nv3->pvideo.buffer_offset[(reg->address - NV3_PVIDEO_BUFF0_OFFSET) >> 2] = value & (nv3->nvbase.svga.vram_max - 1);
+                    break;
+                case NV3_PVIDEO_OE_STATE:
+                    nv3->pvideo.oe_state = value;
+                    break;
+                case NV3_PVIDEO_SU_STATE:
+                    nv3->pvideo.su_state = value;
+                    break;
+                case NV3_PVIDEO_RM_STATE:
+                    nv3->pvideo.rm_state = value;
+                    break;
+                /* Moving the window uncovers part of the screen */
+                case NV3_PVIDEO_WINDOW_START:
+                    nv3->pvideo.window_start.x = value & 0x7FF;
+                    nv3->pvideo.window_start.y = (value >> 16) & 0x7FF;
+                    nv3_render_mark_full();
+                    break;
+                case NV3_PVIDEO_WINDOW_SIZE:
+                    nv3->pvideo.window_size.w = value & 0x7FF;
+                    nv3->pvideo.window_size.h = (value >> 16) & 0x7FF;
+                    nv3_render_mark_full();
+                    break;
+                case NV3_PVIDEO_KEY:
+                    nv3->pvideo.key = value;
                     break;
             }
         }
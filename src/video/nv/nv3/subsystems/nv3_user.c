@@ -25,6 +25,7 @@
 #include <86box/pci.h>
 #include <86box/rom.h> // DEPENDENT!!!
 #include <86box/video.h>
+#define NV_LOG_SUBSYSTEM NV_LOG_USER
 #include <86box/nv/vid_nv.h>
 #include <86box/nv/vid_nv3.h>
 
@@ -62,9 +63,13 @@ uint32_t nv3_user_read(uint32_t address)
 // So we send the writes here. This might do other stuff, so we keep this function
 void nv3_user_write(uint32_t address, uint32_t value) 
 {
+    // The dynarec can write objects faster than the puller wakes up. Well-behaved drivers poll the free count first, 
+    // but if CACHE1 is full, drain it here rather than letting the push go to RAMRO.
+    if (!nv3_pfifo_cache1_num_free_spaces())
+        nv3_pfifo_cache1_drain(NV3_PFIFO_CACHE1_PULLER_BATCH);
+
     nv3_pfifo_cache1_push(address, value);
 
-    // This isn't ideal, but otherwise, the dynarec causes the GPU to write so many objects into CACHE1, it starts overwriting the old objects
-    // This basically makes the fifo not a fifo, but oh well 
-    nv3_pfifo_cache1_pull();
+    // Let the puller pick it up (and anything else that gets submitted in the meantime) later
+    nv3_pfifo_cache1_wake_puller();
 }
\ No newline at end of file
@@ -26,12 +26,25 @@
 #include <86box/device.h>
 #endif
 #include <86box/log.h>
+#include <86box/nv/vid_nv_log.h>
 
 
 // Common logging
 #ifdef ENABLE_NV_LOG
 int nv_do_log = ENABLE_NV_LOG;
 
+// Everything is logged up to the level the build allows until nv_log_configure says otherwise
+uint32_t nv_log_masks[NV_LOG_LEVEL_VERBOSE + 1] = 
+{
+    0,
+    NV_LOG_ALL,
+#ifdef ENABLE_NV_LOG_ULTRA
+    NV_LOG_ALL,
+#else
+    0,
+#endif
+};
+
 // A bit of kludge so that in the future we can abstract this function acorss multiple generations of Nvidia GPUs
 void* nv_log_device;
 bool nv_log_full = false;
@@ -50,6 +63,16 @@ void nv_log_set_device(void* device)
     nv_log_device = device;
 }
 
+// Log the subsystems in subsystem_mask at level and below, and nothing above level
+void nv_log_configure(int32_t level, uint32_t subsystem_mask)
+{
+    if (!nv_do_log)
+        level = NV_LOG_LEVEL_NONE;
+
+    for (int32_t i = NV_LOG_LEVEL_NORMAL; i <= NV_LOG_LEVEL_VERBOSE; i++)
+        nv_log_masks[i] = (i <= level && i <= NV_LOG_LEVEL_MAX) ? (subsystem_mask & NV_LOG_ALL) : 0;
+}
+
 void nv_log_internal(const char* fmt, va_list arg)
 {
     if (!nv_log_device)
@@ -63,45 +86,31 @@ void nv_log_internal(const char* fmt, va_list arg)
     
 }
 
-void nv_log(const char *fmt, ...)
-{
-    va_list arg; 
-
-    if (!nv_do_log)
-        return; 
-
-    va_start(arg, fmt);
-    nv_log_internal(fmt, arg);
-    va_end(arg);
-}
-
-void nv_log_verbose_only(const char *fmt, ...)
+// Called by nv_log and nv_log_verbose_only once they've decided the message should be logged
+void nv_log_print(const char *fmt, ...)
 {
-    #ifdef ENABLE_NV_LOG_ULTRA
     va_list arg; 
 
-    if (!nv_do_log)
-        return; 
-
     va_start(arg, fmt);
     nv_log_internal(fmt, arg);
     va_end(arg);
-    #endif
 }
 
 #else
-void nv_log(const char *fmt, ...)
+uint32_t nv_log_masks[NV_LOG_LEVEL_VERBOSE + 1] = { 0 };
+
+void nv_log_print(const char *fmt, ...)
 {
     
 }
 
-void nv_log_verbose_only(const char *fmt, ...)
+void nv_log_configure(int32_t level, uint32_t subsystem_mask)
 {
-    
+
 }
 
 void nv_log_set_device(void* device)
 {
 
 }
-#endif
\ No newline at end of file
+#endif
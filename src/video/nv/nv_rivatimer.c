@@ -22,35 +22,142 @@ Since Windows XP, QueryPerformanceCounter and QueryPerformanceFrequency cannot f
 
 */
 
+#include <string.h>
 #include <86box/nv/vid_nv_rivatimer.h>
 
 #ifdef _WIN32
 LARGE_INTEGER performance_frequency;
 #endif
 
-rivatimer_t* rivatimer_head;        // The head of the rivatimer list. 
-rivatimer_t* rivatimer_tail;        // The tail of the rivatimer list.
+rivatimer_t rivatimer_pool[RIVATIMER_MAX];          // Every rivatimer lives in here, so checking if one exists doesn't need to walk a list
+rivatimer_t* rivatimer_free;                        // The first free slot in the pool
+rivatimer_t* rivatimer_heap[RIVATIMER_MAX];         // Running rivatimers, as a min-heap ordered by deadline
+uint32_t rivatimer_heap_size;                       // Number of rivatimers in the heap
 
 /* Functions only used in this translation unit */
-bool rivatimer_really_exists(rivatimer_t* rivatimer);   // Determine if a rivatimer really exists in the linked list.
+bool rivatimer_really_exists(rivatimer_t* rivatimer);   // Determine if a rivatimer really exists.
 
-void rivatimer_init(void)
+// Get the current monotonic time in microseconds.
+double rivatimer_get_monotonic_time(void)
 {
-    // Destroy all the rivatimers.
-    rivatimer_t* rivatimer_ptr = rivatimer_head;
+#ifdef _WIN32
+    LARGE_INTEGER current_time;
+
+    QueryPerformanceCounter(&current_time);
+
+    return ((double)current_time.QuadPart * 1000000.0) / (double)performance_frequency.QuadPart;
+#else
+    struct timespec current_time; 
+
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+
+    return ((double)current_time.tv_sec * 1000000.0) + ((double)current_time.tv_nsec / 1000.0);
+#endif
+}
+
+// Put a rivatimer at the right place in the heap, starting from where it is now
+static void rivatimer_heap_sift_up(uint32_t index)
+{
+    rivatimer_t* rivatimer_ptr = rivatimer_heap[index];
+
+    while (index > 0)
+    {
+        uint32_t parent = (index - 1) >> 1;
+
+        if (rivatimer_heap[parent]->deadline <= rivatimer_ptr->deadline)
+            break;
+
+        rivatimer_heap[index] = rivatimer_heap[parent];
+        rivatimer_heap[index]->heap_index = index;
+        index = parent;
+    }
+
+    rivatimer_heap[index] = rivatimer_ptr;
+    rivatimer_ptr->heap_index = index;
+}
+
+static void rivatimer_heap_sift_down(uint32_t index)
+{
+    rivatimer_t* rivatimer_ptr = rivatimer_heap[index];
+
+    while (true)
+    {
+        uint32_t child = (index << 1) + 1;
+
+        if (child >= rivatimer_heap_size)
+            break;
+
+        // Pick the child that fires first
+        if ((child + 1) < rivatimer_heap_size
+        && rivatimer_heap[child + 1]->deadline < rivatimer_heap[child]->deadline)
+            child++;
 
-    if (!rivatimer_ptr)
+        if (rivatimer_ptr->deadline <= rivatimer_heap[child]->deadline)
+            break;
+
+        rivatimer_heap[index] = rivatimer_heap[child];
+        rivatimer_heap[index]->heap_index = index;
+        index = child;
+    }
+
+    rivatimer_heap[index] = rivatimer_ptr;
+    rivatimer_ptr->heap_index = index;
+}
+
+static void rivatimer_heap_insert(rivatimer_t* rivatimer_ptr)
+{
+    rivatimer_heap[rivatimer_heap_size] = rivatimer_ptr;
+    rivatimer_heap_sift_up(rivatimer_heap_size++);
+}
+
+static void rivatimer_heap_remove(rivatimer_t* rivatimer_ptr)
+{
+    uint32_t index = rivatimer_ptr->heap_index;
+
+    rivatimer_ptr->heap_index = -1;
+    rivatimer_heap_size--;
+
+    // It was the last one, so nothing needs to move
+    if (index == rivatimer_heap_size)
         return;
 
-    while (rivatimer_ptr)
+    // Move the last one into the hole, then fix up the heap in whichever direction it needs to go
+    rivatimer_heap[index] = rivatimer_heap[rivatimer_heap_size];
+    rivatimer_heap[index]->heap_index = index;
+
+    if (index > 0
+    && rivatimer_heap[index]->deadline < rivatimer_heap[(index - 1) >> 1]->deadline)
+        rivatimer_heap_sift_up(index);
+    else
+        rivatimer_heap_sift_down(index);
+}
+
+// A rivatimer's deadline changed, so move it to where it belongs in the heap
+static void rivatimer_heap_update(rivatimer_t* rivatimer_ptr)
+{
+    uint32_t index = rivatimer_ptr->heap_index;
+
+    if (index > 0
+    && rivatimer_ptr->deadline < rivatimer_heap[(index - 1) >> 1]->deadline)
+        rivatimer_heap_sift_up(index);
+    else
+        rivatimer_heap_sift_down(index);
+}
+
+void rivatimer_init(void)
+{
+    // Destroy all the rivatimers.
+    memset(rivatimer_pool, 0x00, sizeof(rivatimer_pool));
+    rivatimer_heap_size = 0;
+    rivatimer_free = NULL;
+
+    // Build the free list backwards so the first slot is handed out first
+    for (int32_t i = RIVATIMER_MAX - 1; i >= 0; i--)
     {
-        // since we are destroing it
-        rivatimer_t* old_next = rivatimer_ptr->next;
-        rivatimer_destroy(rivatimer_ptr);
-        
-        rivatimer_ptr = old_next;
+        rivatimer_pool[i].heap_index = -1;
+        rivatimer_pool[i].next_free = rivatimer_free;
+        rivatimer_free = &rivatimer_pool[i];
     }
-        
 
     #ifdef _WIN32
     // Query the performance frequency.
@@ -61,59 +168,38 @@ void rivatimer_init(void)
 // Creates a rivatimer.
 rivatimer_t* rivatimer_create(double period, void (*callback)(double real_time))
 {
-    rivatimer_t* new_rivatimer = NULL;
-
-    // See i
     if (period <= 0 
     || !callback)
     {
         fatal("Invalid rivatimer_create call: period <= 0 or no callback");
     }
 
-    // If there are no rivatimers, create one
-    if (!rivatimer_head)
-    {
-        rivatimer_head = calloc(1, sizeof(rivatimer_t));
-        rivatimer_head->prev = NULL; // indicate this is the first in the list even if we don't strictly need to
-        rivatimer_tail = rivatimer_head; 
-        new_rivatimer = rivatimer_head;
-    }
-    else // Otherwise add a new one to the list
-    {
-        rivatimer_tail->next = calloc(1, sizeof(rivatimer_t));
-        rivatimer_tail = rivatimer_tail->next;
-        new_rivatimer = rivatimer_tail;
-    }
-    
-    // sanity check
-    if (new_rivatimer)
-    {
-        new_rivatimer->running = false;
-        new_rivatimer->period = period;
-        new_rivatimer->next = NULL; // indicate this is the last in the list
-        new_rivatimer->callback = callback;
-    }
+    if (!rivatimer_free)
+        fatal("rivatimer_create: Too many rivatimers (the maximum is %d)", RIVATIMER_MAX);
+
+    rivatimer_t* new_rivatimer = rivatimer_free;
+    rivatimer_free = new_rivatimer->next_free;
+
+    memset(new_rivatimer, 0x00, sizeof(rivatimer_t));
+    new_rivatimer->in_use = true;
+    new_rivatimer->heap_index = -1;
+    new_rivatimer->period = period;
+    new_rivatimer->callback = callback;
 
     return new_rivatimer;
 }
 
-// Determines if a rivatimer really exists.
+// Determines if a rivatimer really exists. It has to be a slot in the pool that hasn't been destroyed.
 bool rivatimer_really_exists(rivatimer_t* rivatimer)
 {
-    rivatimer_t* current = rivatimer_head;
+    uintptr_t offset = (uintptr_t)rivatimer - (uintptr_t)rivatimer_pool;
 
-    if (!current)
+    if (!rivatimer
+    || offset >= sizeof(rivatimer_pool)
+    || (offset % sizeof(rivatimer_t)) != 0)
         return false;
 
-    while (current)
-    {
-        if (current == rivatimer)
-            return true;
-
-        current = current->next;
-    }
-
-    return false;
+    return rivatimer->in_use;
 }
 
 // Destroy a rivatimer.
@@ -122,100 +208,70 @@ void rivatimer_destroy(rivatimer_t* rivatimer_ptr)
     if (!rivatimer_really_exists(rivatimer_ptr))
         fatal("rivatimer_destroy: The timer was already destroyed, or never existed in the first place.");
     
-    // Case: We are destroying the head
-    if (rivatimer_ptr == rivatimer_head)
-    {
-        // This is the only rivatimer
-        if (rivatimer_ptr->next == NULL)
-        {
-            rivatimer_head = NULL;
-            rivatimer_tail = NULL;
-        }
-        // This is not the only rivatimer
-        else 
-        {
-            rivatimer_head = rivatimer_ptr->next;
-            rivatimer_head->prev = NULL; 
-            // This is the only rivatimer and now there is only one
-            if (!rivatimer_head->next)
-                rivatimer_tail = rivatimer_head;
-        }
-    }
-    // Case: We are destroying the tail
-    else if (rivatimer_ptr == rivatimer_tail)
-    {
-        // We already covered the case where there is only one item above
-        rivatimer_tail = rivatimer_ptr->prev;
-        rivatimer_tail->next = NULL;
-    }
-    // Case: This is not the first or last rivatimer, so we don't need to set the head or tail
-    else
-    {
-        // Fix the break in the chain that this 
-        if (rivatimer_ptr->next)
-            rivatimer_ptr->prev->next = rivatimer_ptr->next;
-        if (rivatimer_ptr->prev)
-            rivatimer_ptr->next->prev = rivatimer_ptr->prev;
-    }
+    if (rivatimer_ptr->heap_index >= 0)
+        rivatimer_heap_remove(rivatimer_ptr);
 
-    free(rivatimer_ptr);
-    rivatimer_ptr = NULL; //explicitly set to null
+    rivatimer_ptr->in_use = false;
+    rivatimer_ptr->running = false;
+    rivatimer_ptr->next_free = rivatimer_free;
+    rivatimer_free = rivatimer_ptr;
 }
 
+/* 
+    Fire every rivatimer that is due.
+    The deadline always moves forward by a whole number of periods, so timers don't drift no matter how late this gets called. If a timer
+    missed more than RIVATIMER_MAX_CATCHUP periods (e.g. the emulator was paused), the extra ones are passed in real_time of the last callback
+    instead of calling it thousands of times.
+*/
 void rivatimer_update_all(void)
 {
-    rivatimer_t* rivatimer_ptr = rivatimer_head;
-
-    if (!rivatimer_ptr)
+    if (!rivatimer_heap_size)
         return;
 
-    while (rivatimer_ptr)
-    {
-        // if it's not running skip it
-        if (!rivatimer_ptr->running)
-        {
-            rivatimer_ptr = rivatimer_ptr->next;
-            continue;
-        }
-
-        #ifdef _WIN32
-            LARGE_INTEGER current_time;
+    double now = rivatimer_get_monotonic_time();
 
-            QueryPerformanceCounter(&current_time);
+    while (rivatimer_heap_size
+    && rivatimer_heap[0]->deadline <= now)
+    {
+        rivatimer_t* rivatimer_ptr = rivatimer_heap[0];
+        double period = rivatimer_ptr->period;
 
-            double microseconds = ((double)current_time.QuadPart / 1000000.0) - (rivatimer_ptr->starting_time.QuadPart / 1000000.0);
-        #else
-            struct timespec current_time; 
+        // How many periods went past
+        uint64_t periods = (uint64_t)((now - rivatimer_ptr->deadline) / period) + 1;
+        uint32_t calls = (periods > RIVATIMER_MAX_CATCHUP) ? RIVATIMER_MAX_CATCHUP : (uint32_t)periods;
 
-            clock_gettime(CLOCK_REALTIME, &current_time);
+        rivatimer_ptr->deadline += (double)periods * period;
+        rivatimer_ptr->fired += periods;
+        rivatimer_ptr->coalesced += periods - calls;
+        rivatimer_heap_update(rivatimer_ptr);
 
-            double microseconds = ((double)current_time.tv_sec * 1000000.0) + ((double)current_time.tv_nsec / 1000.0);
-        #endif
+        for (uint32_t call = 0; call < calls; call++)
+        {
+            // The last call gets everything that didn't get its own call
+            double real_time = (call == (calls - 1)) ? ((double)(periods - calls + 1) * period) : period;
 
-        rivatimer_ptr->time += microseconds; 
+            uint32_t generation = rivatimer_ptr->generation;
 
-        // Reset the current time so we can actually restart
-        #ifdef _WIN32
-            QueryPerformanceCounter(&rivatimer_ptr->starting_time);
-        #else
-            clock_gettime(CLOCK_REALTIME, &rivatimer_ptr->starting_time);
-        #endif 
+            rivatimer_ptr->time += real_time;
+            rivatimer_ptr->callback(real_time);
 
-        // Time to fire
-        if (microseconds > rivatimer_ptr->period)
-        {
-            if (!rivatimer_ptr->callback)
-            {
-                pclog("Eh? No callback in RivaTimer?");
-                continue;
-            }
-                    
-            rivatimer_ptr->callback(microseconds);
+            // The callback may have stopped or destroyed it, or started it again with a new deadline (one-shot timers like the PTIMER alarm do this),
+            // in which case the periods we were catching up on don't apply any more
+            if (!rivatimer_ptr->in_use
+            || !rivatimer_ptr->running
+            || rivatimer_ptr->generation != generation)
+                break;
         }
-
-        rivatimer_ptr = rivatimer_ptr->next;
     }
+}
+
+// Get when the next rivatimer fires. Negative if none are running.
+double rivatimer_get_next_deadline(void)
+{
+    if (!rivatimer_heap_size)
+        return -1.0;
 
+    return rivatimer_heap[0]->deadline;
 }
 
 void rivatimer_start(rivatimer_t* rivatimer_ptr)
@@ -227,13 +283,13 @@ void rivatimer_start(rivatimer_t* rivatimer_ptr)
         fatal("rivatimer_start: Zero period!");
 
     rivatimer_ptr->running = true;
+    rivatimer_ptr->generation++;
+    rivatimer_ptr->deadline = rivatimer_get_monotonic_time() + rivatimer_ptr->period;
 
-    // Start off so rivatimer_update_all can actually update.
-    #ifdef _WIN32
-        QueryPerformanceCounter(&rivatimer_ptr->starting_time);
-    #else
-        clock_gettime(CLOCK_REALTIME, &rivatimer_ptr->starting_time);
-    #endif 
+    if (rivatimer_ptr->heap_index >= 0)
+        rivatimer_heap_update(rivatimer_ptr);
+    else
+        rivatimer_heap_insert(rivatimer_ptr);
 }
 
 void rivatimer_stop(rivatimer_t* rivatimer_ptr)
@@ -241,7 +297,11 @@ void rivatimer_stop(rivatimer_t* rivatimer_ptr)
     if (!rivatimer_really_exists(rivatimer_ptr))
         fatal("rivatimer_stop: The timer has been destroyed, or never existed in the first place.");
 
+    if (rivatimer_ptr->heap_index >= 0)
+        rivatimer_heap_remove(rivatimer_ptr);
+
     rivatimer_ptr->running = false;
+    rivatimer_ptr->generation++;
     rivatimer_ptr->time = 0;
 }
 
@@ -270,5 +330,16 @@ void rivatimer_set_period(rivatimer_t* rivatimer_ptr, double period)
     if (!rivatimer_really_exists(rivatimer_ptr))
        fatal("rivatimer_set_period: The timer has been destroyed, or never existed in the first place.");
 
+    if (period <= 0)
+        fatal("rivatimer_set_period: Zero period!");
+
+    // Keep the time it was last due at, and work out the next deadline from the new period
+    if (rivatimer_ptr->running)
+    {
+        rivatimer_ptr->deadline += period - rivatimer_ptr->period;
+        rivatimer_heap_update(rivatimer_ptr);
+    }
+
     rivatimer_ptr->period = period;
-}
\ No newline at end of file
+    rivatimer_ptr->generation++;
+}
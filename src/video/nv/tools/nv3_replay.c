@@ -0,0 +1,78 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          NV3 capture replay tool
+ *
+ *          Runs a PGRAPH command capture through the NV3 core without booting a guest, and logs how long it took. 
+ *          The card is set up by the PCI device's init function the same way the emulator does it, with the rest of the emulator stubbed out in nv3_replay_stubs.c.
+ *
+ *          Usage: nv3_replay <capture.nv3cap> [D3D5 render threads]
+ *
+ * Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+ *
+ *          Copyright 2024-2025 starfrost
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/pci.h>
+#include <86box/rom.h>
+#include <86box/video.h>
+#include <86box/nv/vid_nv.h>
+#include <86box/nv/vid_nv3.h>
+#include "nv3_replay.h"
+
+int main(int argc, char** argv)
+{
+    nv3_capture_header_t header = {0};
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <capture.nv3cap> [D3D5 render threads]\n", argv[0]);
+        return 1;
+    }
+
+    // The card has to have as much VRAM as the one that was captured, so get that before setting it up
+    FILE* file = fopen(argv[1], "rb");
+
+    if (!file)
+    {
+        fprintf(stderr, "Couldn't open %s\n", argv[1]);
+        return 1;
+    }
+
+    if (fread(&header, sizeof(header), 1, file) != 1
+    || header.magic != NV3_CAPTURE_MAGIC)
+    {
+        fprintf(stderr, "%s isn't an NV3 capture\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+
+    fclose(file);
+
+    nv3_replay_vram_size = header.vram_size;
+
+    if (argc >= 3)
+        nv3_replay_threads = atoi(argv[2]);
+
+    // timer_init does this in the emulator
+    rivatimer_init();
+    nv3_device_pci.init(&nv3_device_pci);
+
+    bool ok = nv3_capture_replay(argv[1]);
+
+    nv3_close(nv3);
+    return (ok) ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          NV3 capture replay tool: settings shared between the tool and its stubs
+ *
+ * Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+ *
+ *          Copyright 2024-2025 starfrost
+ */
+#pragma once
+
+extern uint32_t nv3_replay_vram_size;       // VRAM the card is set up with, taken from the capture
+extern int32_t  nv3_replay_threads;         // D3D5 render threads
@@ -0,0 +1,360 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          NV3 capture replay tool: the parts of the emulator the NV3 core calls into, cut down to what a replay needs.
+ *          There is no guest, so there is no bus, no I/O, no monitor and no emulated time. VRAM is the only thing svga_init has to
+ *          set up for real, and the device config comes from the defaults in nv3_config apart from what the tool overrides.
+ *
+ * Authors: Connor Hyde, <mario64crashed@gmail.com> I need a better email address ;^)
+ *
+ *          Copyright 2024-2025 starfrost
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/io.h>
+#include <86box/log.h>
+#include <86box/mem.h>
+#include <86box/pci.h>
+#include <86box/dma.h>
+#include <86box/plat.h>
+#include <86box/rom.h>
+#include <86box/timer.h>
+#include <86box/video.h>
+#include <86box/vid_svga.h>
+#include <86box/vid_ddc.h>
+#include <86box/i2c.h>
+#include <86box/nv/vid_nv.h>
+#include <86box/nv/vid_nv3.h>
+#include "nv3_replay.h"
+
+uint32_t nv3_replay_vram_size = NV3_VRAM_SIZE_4MB;
+int32_t  nv3_replay_threads = 1;
+
+// Emulated time doesn't move, so nothing that runs off it will fire
+uint64_t TIMER_USEC = 1;
+uint64_t tsc = 0;
+double   cpuclock = 100000000.0;
+
+monitor_t monitors[MONITORS_NUM];
+int       monitor_index_global = 0;
+uint32_t* video_15to32 = NULL;
+uint32_t* video_16to32 = NULL;
+
+//
+// Logging
+//
+
+void pclog(const char* fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+void warning(const char* fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+void fatal(const char* fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    exit(1);
+}
+
+// nv_log is quiet without a log device, and the tool never opens one so that logging doesn't get timed along with the replay
+void* log_open(const char* dev_name)
+{
+    return NULL;
+}
+
+void* log_open_cyclic(const char* dev_name)
+{
+    return NULL;
+}
+
+void log_close(void* priv)
+{
+}
+
+void log_out(void* priv, const char* fmt, va_list ap)
+{
+}
+
+void log_out_cyclic(void* priv, const char* fmt, va_list ap)
+{
+}
+
+//
+// Device config
+//
+
+// Find an option in the NV3 device config
+static const device_config_t* nv3_replay_find_config(const char* name)
+{
+    for (const device_config_t* config = nv3_config; config->type != CONFIG_END; config++)
+    {
+        if (config->name
+        && !strcmp(config->name, name))
+            return config;
+    }
+
+    return NULL;
+}
+
+int device_get_config_int(const char* name)
+{
+    if (!strcmp(name, "vram_size"))
+        return nv3_replay_vram_size;
+    else if (!strcmp(name, "pgraph_threads"))
+        return nv3_replay_threads;
+
+    const device_config_t* config = nv3_replay_find_config(name);
+    return (config) ? config->default_int : 0;
+}
+
+const char* device_get_config_string(const char* name)
+{
+    // The tool starts the replay itself
+    if (!strcmp(name, "nv_debug_replay_file")
+    || !strcmp(name, "nv_debug_capture_file"))
+        return NULL;
+
+    const device_config_t* config = nv3_replay_find_config(name);
+    return (config) ? config->default_string : NULL;
+}
+
+const char* device_get_bios_file(const device_t* dev, const char* internal_name, int file_no)
+{
+    return "";
+}
+
+// There is no VBIOS, and no guest to run it
+int rom_init(rom_t* rom, const char* fn, uint32_t address, int size, int mask, int file_offset, uint32_t flags)
+{
+    return 0;
+}
+
+int rom_present(const char* fn)
+{
+    return 1;
+}
+
+FILE* plat_fopen(const char* path, const char* mode)
+{
+    return fopen(path, mode);
+}
+
+void plat_set_thread_name(void* thread, const char* name)
+{
+}
+
+//
+// Bus, I/O and memory. Nothing is mapped, as nothing reads or writes the card except the replay
+//
+
+void pci_add_card(uint8_t add_type, uint8_t (*read)(int func, int addr, void* priv),
+    void (*write)(int func, int addr, uint8_t val, void* priv), void* priv, uint8_t* slot)
+{
+    *slot = 0;
+}
+
+void pci_irq(uint8_t slot, uint8_t pci_int, int level, int set, uint8_t* irq_state)
+{
+}
+
+void io_sethandler(uint16_t base, int size,
+    uint8_t (*inb)(uint16_t addr, void* priv), uint16_t (*inw)(uint16_t addr, void* priv), uint32_t (*inl)(uint16_t addr, void* priv),
+    void (*outb)(uint16_t addr, uint8_t val, void* priv), void (*outw)(uint16_t addr, uint16_t val, void* priv), void (*outl)(uint16_t addr, uint32_t val, void* priv),
+    void* priv)
+{
+}
+
+void io_removehandler(uint16_t base, int size,
+    uint8_t (*inb)(uint16_t addr, void* priv), uint16_t (*inw)(uint16_t addr, void* priv), uint32_t (*inl)(uint16_t addr, void* priv),
+    void (*outb)(uint16_t addr, uint8_t val, void* priv), void (*outw)(uint16_t addr, uint16_t val, void* priv), void (*outl)(uint16_t addr, uint32_t val, void* priv),
+    void* priv)
+{
+}
+
+void mem_mapping_add(mem_mapping_t* mapping, uint32_t base, uint32_t size,
+    uint8_t (*read_b)(uint32_t addr, void* priv), uint16_t (*read_w)(uint32_t addr, void* priv), uint32_t (*read_l)(uint32_t addr, void* priv),
+    void (*write_b)(uint32_t addr, uint8_t val, void* priv), void (*write_w)(uint32_t addr, uint16_t val, void* priv), void (*write_l)(uint32_t addr, uint32_t val, void* priv),
+    uint8_t* exec, uint32_t flags, void* priv)
+{
+}
+
+void mem_mapping_set_addr(mem_mapping_t* mapping, uint32_t base, uint32_t size)
+{
+}
+
+void mem_mapping_enable(mem_mapping_t* mapping)
+{
+}
+
+void mem_mapping_disable(mem_mapping_t* mapping)
+{
+}
+
+// DMA to system memory reads zeroes and throws writes away, as there is no system memory
+void dma_bm_read(uint32_t PhysAddress, uint8_t* DataRead, uint32_t TotalSize, int TransferSize)
+{
+    memset(DataRead, 0x00, TotalSize);
+}
+
+void dma_bm_write(uint32_t PhysAddress, const uint8_t* DataWrite, uint32_t TotalSize, int TransferSize)
+{
+}
+
+//
+// Timers. The CACHE1 puller never runs; the replay drains CACHE1 itself
+//
+
+void timer_add(pc_timer_t* timer, void (*callback)(void* priv), void* priv, int start_timer)
+{
+    memset(timer, 0x00, sizeof(pc_timer_t));
+    timer->callback = callback;
+    timer->priv = priv;
+}
+
+void timer_enable(pc_timer_t* timer)
+{
+}
+
+void timer_disable(pc_timer_t* timer)
+{
+}
+
+//
+// SVGA and the monitor
+//
+
+int svga_init(const device_t* info, svga_t* svga, void* priv, int memsize,
+    void (*recalctimings_ex)(struct svga_t* svga),
+    uint8_t (*video_in)(uint16_t addr, void* priv),
+    void (*video_out)(uint16_t addr, uint8_t val, void* priv),
+    void (*hwcursor_draw)(struct svga_t* svga, int displine),
+    void (*overlay_draw)(struct svga_t* svga, int displine))
+{
+    svga->priv = priv;
+    svga->monitor_index = monitor_index_global;
+    svga->monitor = &monitors[svga->monitor_index];
+    svga->bpp = 8;
+    svga->vram = calloc(memsize + 8, 1);
+    svga->vram_max = memsize;
+    svga->vram_display_mask = svga->vram_mask = memsize - 1;
+    svga->decode_mask = 0x7fffff;
+    svga->changedvram = calloc((memsize >> 12) + 1, 1);
+    svga->recalctimings_ex = recalctimings_ex;
+    svga->video_in = video_in;
+    svga->video_out = video_out;
+    svga->hwcursor_draw = hwcursor_draw;
+    svga->overlay_draw = overlay_draw;
+
+    if (!svga->vram
+    || !svga->changedvram)
+        fatal("NV3 replay: Couldn't allocate %d bytes of VRAM\n", memsize);
+
+    return 0;
+}
+
+void svga_close(svga_t* svga)
+{
+    free(svga->changedvram);
+    free(svga->vram);
+    svga->changedvram = NULL;
+    svga->vram = NULL;
+}
+
+uint8_t svga_in(uint16_t addr, void* priv)
+{
+    return 0xFF;
+}
+
+void svga_out(uint16_t addr, uint8_t val, void* priv)
+{
+}
+
+uint8_t svga_read_linear(uint32_t addr, void* priv)
+{
+    return 0xFF;
+}
+
+void svga_writel_linear(uint32_t addr, uint32_t val, void* priv)
+{
+}
+
+void video_inform_monitor(int type, const video_timings_t* ptr, int monitor_index)
+{
+}
+
+void video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+{
+}
+
+void set_screen_size(int x, int y)
+{
+}
+
+//
+// I2C and DDC. Nothing reads the EDID
+//
+
+void* i2c_gpio_init(char* bus_name)
+{
+    return NULL;
+}
+
+void i2c_gpio_close(void* dev_handle)
+{
+}
+
+void i2c_gpio_set(void* dev_handle, uint8_t scl, uint8_t sda)
+{
+}
+
+uint8_t i2c_gpio_get_scl(void* dev_handle)
+{
+    return 1;
+}
+
+uint8_t i2c_gpio_get_sda(void* dev_handle)
+{
+    return 1;
+}
+
+void* i2c_gpio_get_bus(void* dev_handle)
+{
+    return NULL;
+}
+
+void* ddc_init(void* i2c)
+{
+    return NULL;
+}
+
+void ddc_close(void* eeprom)
+{
+}